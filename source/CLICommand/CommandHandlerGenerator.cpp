@@ -1,5 +1,6 @@
 #include "CommandHandlerGenerator.h"
 #include "Serialization/Serializer.h"
+#include "util/Perf.h"
 
 void CommandHandlerGenerator::print_error(
     const CommandResponsePtr& response, 
@@ -23,3 +24,19 @@ void CommandHandlerGenerator::print_error(
     } 
     out << endObject;
 }
+
+bool CommandHandlerGenerator::decode_arguments(
+    const CommandArgs& args,
+    const CommandResponsePtr& response,
+    const ArgumentDecoder* decoders,
+    std::size_t count,
+    ConstArray<CommandArgDescription> (*argsDescription)()) {
+    PERF_SCOPE(ARGUMENT_PARSING);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!decoders[i].decode(args[i], decoders[i].value)) {
+            print_error(response, i, argsDescription);
+            return false;
+        }
+    }
+    return true;
+}
@@ -63,6 +63,57 @@ private:
     };
 
 
+    /**
+     * @brief Deserializer of a single argument: convert str into the object
+     * pointed by value.
+     */
+    typedef bool (*argument_decoder_t)(const char* str, void* value);
+
+
+    /**
+     * @brief Entry of the argument table of a handler: the deserializer of the
+     * argument and the storage of the argument.
+     */
+    struct ArgumentDecoder {
+        argument_decoder_t decode;
+        void* value;
+    };
+
+
+    /**
+     * @brief Deserializer of arguments of type T, referenced by the argument
+     * tables of the handlers.
+     */
+    template<typename T>
+    static bool decode(const char* str, void* value) {
+        return fromString(str, *static_cast<T*>(value));
+    }
+
+
+    /**
+     * @brief Deserialize the arguments of a command from their table.
+     * @details Handlers generated for each command build the table of their
+     * arguments and delegate the parsing to this function.
+     *
+     * @param args the command line arguments
+     * @param response the command response, an error is printed in it if an
+     * argument cannot be deserialized.
+     * @param decoders Table of the arguments of the command.
+     * @param count Number of entries in decoders.
+     * @param argsDescription Accessor to the command argsDescription.
+     *
+     * @return true if all the arguments have been deserialized and false
+     * otherwise.
+     */
+    static bool decode_arguments(
+        const CommandArgs& args,
+        const CommandResponsePtr& response,
+        const ArgumentDecoder* decoders,
+        std::size_t count,
+        ConstArray<CommandArgDescription> (*argsDescription)()
+    );
+
+
     /**
      * @brief Generic function used to print an error in the command response if the 
      * deserialization fail.
@@ -118,9 +169,10 @@ private:
 
     /**
      * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect one argument of type A0, this 
-     * argument is deserialized first then if the deserialization was a success, the 
-     * function is called with the deserialized argument and the command response.
+     * @detail In this form, the real_handler expect 1 argument of type A0.
+     * The arguments are deserialized from the table of their decoders then, if
+     * the deserialization was a success, real_handler is called with the
+     * deserialized arguments and the command response as parameters.
      * 
      * @param args the command line arguments 
      * @param response the command response 
@@ -133,8 +185,12 @@ private:
                         void(*real_handler)(A0, const CommandResponsePtr&),
                         ConstArray<CommandArgDescription> (*argsDescription)()) { 
         typename remove_reference<A0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
+
+        const ArgumentDecoder decoders[] = {
+            { &decode<typename remove_reference<A0>::type>, &arg0 }
+        };
+
+        if (!decode_arguments(args, response, decoders, 1, argsDescription)) {
             return;
         }
 
@@ -144,10 +200,10 @@ private:
 
     /**
      * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect two argument of type A0 and A1, 
-     * these arguments are deserialized first then if the deserialization was a success, 
-     * the function real_handler is called with the deserialized arguments and the 
-     * command response as parameters.
+     * @detail In this form, the real_handler expect 2 arguments of type A0 and A1.
+     * The arguments are deserialized from the table of their decoders then, if
+     * the deserialization was a success, real_handler is called with the
+     * deserialized arguments and the command response as parameters.
      * 
      * @param args the command line arguments 
      * @param response the command response 
@@ -160,16 +216,16 @@ private:
                         void(*real_handler)(A0, A1, const CommandResponsePtr&),
                         ConstArray<CommandArgDescription> (*argsDescription)()) { 
         typename remove_reference<A0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
         typename remove_reference<A1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
+
+        const ArgumentDecoder decoders[] = {
+            { &decode<typename remove_reference<A0>::type>, &arg0 },
+            { &decode<typename remove_reference<A1>::type>, &arg1 }
+        };
+
+        if (!decode_arguments(args, response, decoders, 2, argsDescription)) {
             return;
-        }        
+        }
 
         real_handler(arg0, arg1, response);
     }
@@ -177,10 +233,10 @@ private:
 
     /**
      * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type A0, A1 and A2, 
-     * these arguments are deserialized first then if the deserialization was a success, 
-     * the function real_handler is called with the deserialized arguments and the 
-     * command response as parameters.
+     * @detail In this form, the real_handler expect 3 arguments of type A0, A1 and A2.
+     * The arguments are deserialized from the table of their decoders then, if
+     * the deserialization was a success, real_handler is called with the
+     * deserialized arguments and the command response as parameters.
      * 
      * @param args the command line arguments 
      * @param response the command response 
@@ -193,32 +249,29 @@ private:
                         void(*real_handler)(A0, A1, A2, const CommandResponsePtr&),
                         ConstArray<CommandArgDescription> (*argsDescription)()) { 
         typename remove_reference<A0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
         typename remove_reference<A1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
+
+        const ArgumentDecoder decoders[] = {
+            { &decode<typename remove_reference<A0>::type>, &arg0 },
+            { &decode<typename remove_reference<A1>::type>, &arg1 },
+            { &decode<typename remove_reference<A2>::type>, &arg2 }
+        };
+
+        if (!decode_arguments(args, response, decoders, 3, argsDescription)) {
             return;
-        }        
+        }
+
         real_handler(arg0, arg1, arg2, response);
     }
 
 
     /**
      * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type A0, 
-     * A1, A2 and A3. These arguments are deserialized first then if the 
-     * deserialization was a success, the function real_handler is called 
-     * with the deserialized arguments and the command response as parameters.
+     * @detail In this form, the real_handler expect 4 arguments of type A0, A1, A2 and A3.
+     * The arguments are deserialized from the table of their decoders then, if
+     * the deserialization was a success, real_handler is called with the
+     * deserialized arguments and the command response as parameters.
      * 
      * @param args the command line arguments 
      * @param response the command response 
@@ -231,28 +284,20 @@ private:
                         void(*real_handler)(A0, A1, A2, A3, const CommandResponsePtr&),
                         ConstArray<CommandArgDescription> (*argsDescription)()) { 
         typename remove_reference<A0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
         typename remove_reference<A1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A3>::type arg3;
-        if (!fromString(args[3], arg3)) {
-            print_error(response, 3, argsDescription);
+
+        const ArgumentDecoder decoders[] = {
+            { &decode<typename remove_reference<A0>::type>, &arg0 },
+            { &decode<typename remove_reference<A1>::type>, &arg1 },
+            { &decode<typename remove_reference<A2>::type>, &arg2 },
+            { &decode<typename remove_reference<A3>::type>, &arg3 }
+        };
+
+        if (!decode_arguments(args, response, decoders, 4, argsDescription)) {
             return;
-        }        
+        }
 
         real_handler(arg0, arg1, arg2, arg3, response);
     }
@@ -260,10 +305,10 @@ private:
 
     /**
      * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type A0, 
-     * A1, A2, A3 and A4. These arguments are deserialized first then if the 
-     * deserialization was a success, the function real_handler is called 
-     * with the deserialized arguments and the command response as parameters.
+     * @detail In this form, the real_handler expect 5 arguments of type A0, A1, A2, A3 and A4.
+     * The arguments are deserialized from the table of their decoders then, if
+     * the deserialization was a success, real_handler is called with the
+     * deserialized arguments and the command response as parameters.
      * 
      * @param args the command line arguments 
      * @param response the command response 
@@ -276,34 +321,22 @@ private:
                         void(*real_handler)(A0, A1, A2, A3, A4, const CommandResponsePtr&),
                         ConstArray<CommandArgDescription> (*argsDescription)()) { 
         typename remove_reference<A0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
         typename remove_reference<A1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A3>::type arg3;
-        if (!fromString(args[3], arg3)) {
-            print_error(response, 3, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A4>::type arg4;
-        if (!fromString(args[4], arg4)) {
-            print_error(response, 4, argsDescription);
+
+        const ArgumentDecoder decoders[] = {
+            { &decode<typename remove_reference<A0>::type>, &arg0 },
+            { &decode<typename remove_reference<A1>::type>, &arg1 },
+            { &decode<typename remove_reference<A2>::type>, &arg2 },
+            { &decode<typename remove_reference<A3>::type>, &arg3 },
+            { &decode<typename remove_reference<A4>::type>, &arg4 }
+        };
+
+        if (!decode_arguments(args, response, decoders, 5, argsDescription)) {
             return;
-        }     
+        }
 
         real_handler(arg0, arg1, arg2, arg3, arg4, response);
     }
@@ -311,10 +344,10 @@ private:
 
     /**
      * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type A0, 
-     * A1, A2, A3, A4 and A5. These arguments are deserialized first then if the 
-     * deserialization was a success, the function real_handler is called 
-     * with the deserialized arguments and the command response as parameters.
+     * @detail In this form, the real_handler expect 6 arguments of type A0, A1, A2, A3, A4 and A5.
+     * The arguments are deserialized from the table of their decoders then, if
+     * the deserialization was a success, real_handler is called with the
+     * deserialized arguments and the command response as parameters.
      * 
      * @param args the command line arguments 
      * @param response the command response 
@@ -327,40 +360,24 @@ private:
                         void(*real_handler)(A0, A1, A2, A3, A4, A5, const CommandResponsePtr&),
                         ConstArray<CommandArgDescription> (*argsDescription)()) { 
         typename remove_reference<A0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
         typename remove_reference<A1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A3>::type arg3;
-        if (!fromString(args[3], arg3)) {
-            print_error(response, 3, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A4>::type arg4;
-        if (!fromString(args[4], arg4)) {
-            print_error(response, 4, argsDescription);
-            return;
-        }     
-
         typename remove_reference<A5>::type arg5;
-        if (!fromString(args[5], arg5)) {
-            print_error(response, 5, argsDescription);
+
+        const ArgumentDecoder decoders[] = {
+            { &decode<typename remove_reference<A0>::type>, &arg0 },
+            { &decode<typename remove_reference<A1>::type>, &arg1 },
+            { &decode<typename remove_reference<A2>::type>, &arg2 },
+            { &decode<typename remove_reference<A3>::type>, &arg3 },
+            { &decode<typename remove_reference<A4>::type>, &arg4 },
+            { &decode<typename remove_reference<A5>::type>, &arg5 }
+        };
+
+        if (!decode_arguments(args, response, decoders, 6, argsDescription)) {
             return;
-        }     
+        }
 
         real_handler(arg0, arg1, arg2, arg3, arg4, arg5, response);
     }
@@ -368,10 +385,10 @@ private:
 
     /**
      * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type A0, 
-     * A1, A2, A3, A4, A5 and A6. These arguments are deserialized first then 
-     * if the deserialization was a success, the function real_handler is called 
-     * with the deserialized arguments and the command response as parameters.
+     * @detail In this form, the real_handler expect 7 arguments of type A0, A1, A2, A3, A4, A5 and A6.
+     * The arguments are deserialized from the table of their decoders then, if
+     * the deserialization was a success, real_handler is called with the
+     * deserialized arguments and the command response as parameters.
      * 
      * @param args the command line arguments 
      * @param response the command response 
@@ -385,44 +402,24 @@ private:
                         void(*real_handler)(A0, A1, A2, A3, A4, A5, A6, const CommandResponsePtr&),
                         ConstArray<CommandArgDescription> (*argsDescription)()) { 
         typename remove_reference<A0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
         typename remove_reference<A1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A3>::type arg3;
-        if (!fromString(args[3], arg3)) {
-            print_error(response, 3, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A4>::type arg4;
-        if (!fromString(args[4], arg4)) {
-            print_error(response, 4, argsDescription);
-            return;
-        }     
-
         typename remove_reference<A5>::type arg5;
-        if (!fromString(args[5], arg5)) {
-            print_error(response, 5, argsDescription);
-            return;
-        }     
-
         typename remove_reference<A6>::type arg6;
-        if (!fromString(args[6], arg6)) {
-            print_error(response, 6, argsDescription);
+
+        const ArgumentDecoder decoders[] = {
+            { &decode<typename remove_reference<A0>::type>, &arg0 },
+            { &decode<typename remove_reference<A1>::type>, &arg1 },
+            { &decode<typename remove_reference<A2>::type>, &arg2 },
+            { &decode<typename remove_reference<A3>::type>, &arg3 },
+            { &decode<typename remove_reference<A4>::type>, &arg4 },
+            { &decode<typename remove_reference<A5>::type>, &arg5 },
+            { &decode<typename remove_reference<A6>::type>, &arg6 }
+        };
+
+        if (!decode_arguments(args, response, decoders, 7, argsDescription)) {
             return;
         }
 
@@ -432,10 +429,10 @@ private:
 
     /**
      * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type A0, 
-     * A1, A2, A3, A4, A5, A6 and A7. These arguments are deserialized first then 
-     * if the deserialization was a success, the function real_handler is called 
-     * with the deserialized arguments and the command response as parameters.
+     * @detail In this form, the real_handler expect 8 arguments of type A0, A1, A2, A3, A4, A5, A6 and A7.
+     * The arguments are deserialized from the table of their decoders then, if
+     * the deserialization was a success, real_handler is called with the
+     * deserialized arguments and the command response as parameters.
      * 
      * @param args the command line arguments 
      * @param response the command response 
@@ -449,52 +446,28 @@ private:
                         void(*real_handler)(A0, A1, A2, A3, A4, A5, A6, A7, const CommandResponsePtr&),
                         ConstArray<CommandArgDescription> (*argsDescription)()) { 
         typename remove_reference<A0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
         typename remove_reference<A1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A3>::type arg3;
-        if (!fromString(args[3], arg3)) {
-            print_error(response, 3, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A4>::type arg4;
-        if (!fromString(args[4], arg4)) {
-            print_error(response, 4, argsDescription);
-            return;
-        }     
-
         typename remove_reference<A5>::type arg5;
-        if (!fromString(args[5], arg5)) {
-            print_error(response, 5, argsDescription);
-            return;
-        }     
-
         typename remove_reference<A6>::type arg6;
-        if (!fromString(args[6], arg6)) {
-            print_error(response, 6, argsDescription);
-            return;
-        }
-
         typename remove_reference<A7>::type arg7;
-        if (!fromString(args[7], arg7)) {
-            print_error(response, 7, argsDescription);
+
+        const ArgumentDecoder decoders[] = {
+            { &decode<typename remove_reference<A0>::type>, &arg0 },
+            { &decode<typename remove_reference<A1>::type>, &arg1 },
+            { &decode<typename remove_reference<A2>::type>, &arg2 },
+            { &decode<typename remove_reference<A3>::type>, &arg3 },
+            { &decode<typename remove_reference<A4>::type>, &arg4 },
+            { &decode<typename remove_reference<A5>::type>, &arg5 },
+            { &decode<typename remove_reference<A6>::type>, &arg6 },
+            { &decode<typename remove_reference<A7>::type>, &arg7 }
+        };
+
+        if (!decode_arguments(args, response, decoders, 8, argsDescription)) {
             return;
-        }     
+        }
 
         real_handler(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, response);
     }
@@ -502,10 +475,10 @@ private:
 
     /**
      * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type A0, 
-     * A1, A2, A3, A4, A5, A6, A7 and A8. These arguments are deserialized first then 
-     * if the deserialization was a success, the function real_handler is called 
-     * with the deserialized arguments and the command response as parameters.
+     * @detail In this form, the real_handler expect 9 arguments of type A0, A1, A2, A3, A4, A5, A6, A7 and A8.
+     * The arguments are deserialized from the table of their decoders then, if
+     * the deserialization was a success, real_handler is called with the
+     * deserialized arguments and the command response as parameters.
      * 
      * @param args the command line arguments 
      * @param response the command response 
@@ -519,58 +492,30 @@ private:
                         void(*real_handler)(A0, A1, A2, A3, A4, A5, A6, A7, A8, const CommandResponsePtr&),
                         ConstArray<CommandArgDescription> (*argsDescription)()) { 
         typename remove_reference<A0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
         typename remove_reference<A1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A3>::type arg3;
-        if (!fromString(args[3], arg3)) {
-            print_error(response, 3, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A4>::type arg4;
-        if (!fromString(args[4], arg4)) {
-            print_error(response, 4, argsDescription);
-            return;
-        }     
-
         typename remove_reference<A5>::type arg5;
-        if (!fromString(args[5], arg5)) {
-            print_error(response, 5, argsDescription);
-            return;
-        }     
-
         typename remove_reference<A6>::type arg6;
-        if (!fromString(args[6], arg6)) {
-            print_error(response, 6, argsDescription);
-            return;
-        }
-
         typename remove_reference<A7>::type arg7;
-        if (!fromString(args[7], arg7)) {
-            print_error(response, 7, argsDescription);
-            return;
-        }     
-
         typename remove_reference<A8>::type arg8;
-        if (!fromString(args[8], arg8)) {
-            print_error(response, 8, argsDescription);
+
+        const ArgumentDecoder decoders[] = {
+            { &decode<typename remove_reference<A0>::type>, &arg0 },
+            { &decode<typename remove_reference<A1>::type>, &arg1 },
+            { &decode<typename remove_reference<A2>::type>, &arg2 },
+            { &decode<typename remove_reference<A3>::type>, &arg3 },
+            { &decode<typename remove_reference<A4>::type>, &arg4 },
+            { &decode<typename remove_reference<A5>::type>, &arg5 },
+            { &decode<typename remove_reference<A6>::type>, &arg6 },
+            { &decode<typename remove_reference<A7>::type>, &arg7 },
+            { &decode<typename remove_reference<A8>::type>, &arg8 }
+        };
+
+        if (!decode_arguments(args, response, decoders, 9, argsDescription)) {
             return;
-        }     
+        }
 
         real_handler(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, response);
     }
@@ -578,10 +523,10 @@ private:
 
     /**
      * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type A0, 
-     * A1, A2, A3, A4, A5, A6, A7, A8 and A9. These arguments are deserialized first then 
-     * if the deserialization was a success, the function real_handler is called 
-     * with the deserialized arguments and the command response as parameters.
+     * @detail In this form, the real_handler expect 10 arguments of type A0, A1, A2, A3, A4, A5, A6, A7, A8 and A9.
+     * The arguments are deserialized from the table of their decoders then, if
+     * the deserialization was a success, real_handler is called with the
+     * deserialized arguments and the command response as parameters.
      * 
      * @param args the command line arguments 
      * @param response the command response 
@@ -595,62 +540,30 @@ private:
                         void(*real_handler)(A0, A1, A2, A3, A4, A5, A6, A7, A8, A9, const CommandResponsePtr&),
                         ConstArray<CommandArgDescription> (*argsDescription)()) { 
         typename remove_reference<A0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
         typename remove_reference<A1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A3>::type arg3;
-        if (!fromString(args[3], arg3)) {
-            print_error(response, 3, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A4>::type arg4;
-        if (!fromString(args[4], arg4)) {
-            print_error(response, 4, argsDescription);
-            return;
-        }     
-
         typename remove_reference<A5>::type arg5;
-        if (!fromString(args[5], arg5)) {
-            print_error(response, 5, argsDescription);
-            return;
-        }     
-
         typename remove_reference<A6>::type arg6;
-        if (!fromString(args[6], arg6)) {
-            print_error(response, 6, argsDescription);
-            return;
-        }
-
         typename remove_reference<A7>::type arg7;
-        if (!fromString(args[7], arg7)) {
-            print_error(response, 7, argsDescription);
-            return;
-        }     
-
         typename remove_reference<A8>::type arg8;
-        if (!fromString(args[8], arg8)) {
-            print_error(response, 8, argsDescription);
-            return;
-        }     
-
         typename remove_reference<A9>::type arg9;
-        if (!fromString(args[9], arg9)) {
-            print_error(response, 9, argsDescription);
+
+        const ArgumentDecoder decoders[] = {
+            { &decode<typename remove_reference<A0>::type>, &arg0 },
+            { &decode<typename remove_reference<A1>::type>, &arg1 },
+            { &decode<typename remove_reference<A2>::type>, &arg2 },
+            { &decode<typename remove_reference<A3>::type>, &arg3 },
+            { &decode<typename remove_reference<A4>::type>, &arg4 },
+            { &decode<typename remove_reference<A5>::type>, &arg5 },
+            { &decode<typename remove_reference<A6>::type>, &arg6 },
+            { &decode<typename remove_reference<A7>::type>, &arg7 },
+            { &decode<typename remove_reference<A8>::type>, &arg8 },
+            { &decode<typename remove_reference<A9>::type>, &arg9 }
+        };
+
+        if (!decode_arguments(args, response, decoders, 10, argsDescription)) {
             return;
         }
 
@@ -660,11 +573,10 @@ private:
 
     /**
      * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type A0, 
-     * A1, A2, A3, A4, A5, A6, A7, A8, A9 and A100. These arguments are deserialized 
-     * first then if the deserialization was a success, the function real_handler 
-     * is called with the deserialized arguments and the command response as 
-     * parameters.
+     * @detail In this form, the real_handler expect 11 arguments of type A0, A1, A2, A3, A4, A5, A6, A7, A8, A9 and A10.
+     * The arguments are deserialized from the table of their decoders then, if
+     * the deserialization was a success, real_handler is called with the
+     * deserialized arguments and the command response as parameters.
      * 
      * @param args the command line arguments 
      * @param response the command response 
@@ -678,70 +590,34 @@ private:
                         void(*real_handler)(A0, A1, A2, A3, A4, A5, A6, A7, A8, A9, A10, const CommandResponsePtr&),
                         ConstArray<CommandArgDescription> (*argsDescription)()) { 
         typename remove_reference<A0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
         typename remove_reference<A1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A3>::type arg3;
-        if (!fromString(args[3], arg3)) {
-            print_error(response, 3, argsDescription);
-            return;
-        }        
-
         typename remove_reference<A4>::type arg4;
-        if (!fromString(args[4], arg4)) {
-            print_error(response, 4, argsDescription);
-            return;
-        }     
-
         typename remove_reference<A5>::type arg5;
-        if (!fromString(args[5], arg5)) {
-            print_error(response, 5, argsDescription);
-            return;
-        }     
-
         typename remove_reference<A6>::type arg6;
-        if (!fromString(args[6], arg6)) {
-            print_error(response, 6, argsDescription);
-            return;
-        }
-
         typename remove_reference<A7>::type arg7;
-        if (!fromString(args[7], arg7)) {
-            print_error(response, 7, argsDescription);
-            return;
-        }     
-
         typename remove_reference<A8>::type arg8;
-        if (!fromString(args[8], arg8)) {
-            print_error(response, 8, argsDescription);
-            return;
-        }     
-
         typename remove_reference<A9>::type arg9;
-        if (!fromString(args[9], arg9)) {
-            print_error(response, 9, argsDescription);
-            return;
-        }             
-
         typename remove_reference<A10>::type arg10;
-        if (!fromString(args[10], arg10)) {
-            print_error(response, 10, argsDescription);
+
+        const ArgumentDecoder decoders[] = {
+            { &decode<typename remove_reference<A0>::type>, &arg0 },
+            { &decode<typename remove_reference<A1>::type>, &arg1 },
+            { &decode<typename remove_reference<A2>::type>, &arg2 },
+            { &decode<typename remove_reference<A3>::type>, &arg3 },
+            { &decode<typename remove_reference<A4>::type>, &arg4 },
+            { &decode<typename remove_reference<A5>::type>, &arg5 },
+            { &decode<typename remove_reference<A6>::type>, &arg6 },
+            { &decode<typename remove_reference<A7>::type>, &arg7 },
+            { &decode<typename remove_reference<A8>::type>, &arg8 },
+            { &decode<typename remove_reference<A9>::type>, &arg9 },
+            { &decode<typename remove_reference<A10>::type>, &arg10 }
+        };
+
+        if (!decode_arguments(args, response, decoders, 11, argsDescription)) {
             return;
-        }     
+        }
 
         real_handler(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, response);
     }
@@ -1,5 +1,6 @@
 #include <functional>
 #include "CommandResponse.h"
+#include "util/Perf.h"
 
 using namespace serialization;
 
@@ -81,6 +82,7 @@ void CommandResponse::close() {
     out << endObject;
     out.flush();
     closed = 1;
+    PERF_COMMAND_END();
 
     onClose(this);
 }
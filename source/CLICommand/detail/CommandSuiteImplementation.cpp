@@ -3,6 +3,7 @@
 
 #include "../CommandEventQueue.h"
 #include "CommandSuiteImplementation.h"
+#include "util/Perf.h"
 #include <string.h>
 
 using mbed::util::SharedPointer;
@@ -13,7 +14,9 @@ static void whenAsyncCommandEnd(const CommandResponse* response) {
     getCLICommandEventQueue()->post(&cmd_ready, response->getStatusCode());
 }
 
-static const Command* getCommand(
+}
+
+const Command* CommandSuiteImplementation::getCommand(
     const char* name,
     const ConstArray<const Command*>& builtinCommands,
     const ConstArray<const Command*>& moduleCommands) {
@@ -33,37 +36,50 @@ static const Command* getCommand(
     return NULL;
 }
 
-}
-
 int CommandSuiteImplementation::commandHandler(
     int argc, char** argv,
     const ConstArray<const Command*>& builtinCommands,
     const ConstArray<const Command*>& moduleCommands) {
+    PERF_COMMAND_BEGIN();
     const CommandArgs args(argc, argv);
     const char* commandName = args[1];
     const CommandArgs commandArgs(args.drop(2));
 
     SharedPointer<CommandResponse> response(new CommandResponse());
 
-    const Command* command = getCommand(commandName, builtinCommands, moduleCommands);
-    if(!command) {
-        response->faillure("invalid command name, you can get all the command name for this module by using the command 'list'");
-        return response->getStatusCode();
+    // lookup of the command and check of the arguments count; errors are
+    // reported out of the probe
+    const Command* command = NULL;
+    const char* argumentsError = NULL;
+    {
+        PERF_SCOPE(COMMAND_DISPATCH);
+        command = getCommand(commandName, builtinCommands, moduleCommands);
+        if(command) {
+            if(commandArgs.count() < command->argsDescription().count()) {
+                argumentsError = "not enough arguments";
+            } else if(commandArgs.count() > command->maximumArgsRequired()) {
+                argumentsError = "too many arguments";
+            }
+        }
     }
 
-    // check arguments
-    if(commandArgs.count() < command->argsDescription().count()) {
-        response->invalidParameters("not enough arguments");
+    if(!command) {
+        response->faillure("invalid command name, you can get all the command name for this module by using the command 'list'");
         return response->getStatusCode();
     }
 
-    if(commandArgs.count() > command->maximumArgsRequired()) {
-        response->invalidParameters("too many arguments");
+    if(argumentsError) {
+        response->invalidParameters(argumentsError);
         return response->getStatusCode();
     }
 
     // execute the handler
-    command->handler(commandArgs, response);
+    {
+        PERF_COMMAND_HANDLER_STARTED(args[0], command, command->name());
+        PERF_SCOPE(HANDLER_EXECUTION);
+        command->handler(commandArgs, response);
+    }
+    PERF_COMMAND_HANDLER_RETURNED();
 
     // if response is not referenced elsewhere, this means that the execution is done,
     // just return the status code set
@@ -11,6 +11,9 @@
  * It is not meant to be used directly.
  */
 struct CommandSuiteImplementation {
+    // the bench suite measures the command lookup
+    friend struct CommandLookupBench;
+
     static int commandHandler(
         int argc, char** argv,
         const ConstArray<const Command*>& builtinCommands,
@@ -34,6 +37,17 @@ struct CommandSuiteImplementation {
         const ConstArray<const Command*>& builtinCommands,
         const ConstArray<const Command*>& moduleCommands
     );
+
+private:
+    /**
+     * @brief Find a command by name, builtin commands are looked up first.
+     * @return The command or NULL if no command is named name.
+     */
+    static const Command* getCommand(
+        const char* name,
+        const ConstArray<const Command*>& builtinCommands,
+        const ConstArray<const Command*>& moduleCommands
+    );
 };
 
 
@@ -1,5 +1,26 @@
+#include <cstdlib>
 #include "AsyncProcedure.h"
 #include "../CommandEventQueue.h"
+#include "util/SlabPool.h"
+
+namespace {
+
+#if BLE_CLIAPP_PROCEDURE_POOL
+util::SlabPool<PROCEDURE_POOL_SMALL_SLOT_SIZE, PROCEDURE_POOL_SMALL_SLOT_COUNT> smallSlots;
+util::SlabPool<PROCEDURE_POOL_LARGE_SLOT_SIZE, PROCEDURE_POOL_LARGE_SLOT_COUNT> largeSlots;
+#endif
+uint32_t oversized = 0;
+
+template<typename Pool>
+void getStatistics(const Pool& pool, AsyncProcedure::PoolStatistics& statistics) {
+    statistics.slotSize = pool.slotSize();
+    statistics.slotCount = pool.slotCount();
+    statistics.used = pool.used();
+    statistics.peak = pool.peak();
+    statistics.exhausted = pool.exhausted();
+}
+
+} // end of anonymous namespace
 
 AsyncProcedure::AsyncProcedure(const CommandResponsePtr& res, uint32_t t) :
     response(res), timeoutHandle(NULL), timeout(t) {
@@ -40,3 +61,71 @@ void AsyncProcedure::whenTimeout() {
 void AsyncProcedure::doWhenTimeout() {
     response->faillure("timeout");
 }
+
+bool AsyncProcedure::getPoolStatistics(std::size_t sizeClass, PoolStatistics& statistics) {
+#if BLE_CLIAPP_PROCEDURE_POOL
+    switch (sizeClass) {
+        case 0:
+            getStatistics(smallSlots, statistics);
+            return true;
+        case 1:
+            getStatistics(largeSlots, statistics);
+            return true;
+        default:
+            return false;
+    }
+#else
+    (void) sizeClass;
+    (void) statistics;
+    return false;
+#endif
+}
+
+uint32_t AsyncProcedure::oversizedProcedures() {
+    return oversized;
+}
+
+void AsyncProcedure::resetPoolStatistics() {
+#if BLE_CLIAPP_PROCEDURE_POOL
+    smallSlots.resetStatistics();
+    largeSlots.resetStatistics();
+#endif
+    oversized = 0;
+}
+
+void* AsyncProcedure::operator new(std::size_t size) throw() {
+    void* ptr = NULL;
+#if BLE_CLIAPP_PROCEDURE_POOL
+    if (size <= smallSlots.slotSize()) {
+        ptr = smallSlots.allocate();
+    }
+
+    // a small procedure takes a large slot if all the small ones are used
+    if (!ptr && size <= largeSlots.slotSize()) {
+        ptr = largeSlots.allocate();
+    } else if (size > largeSlots.slotSize()) {
+        ++oversized;
+    }
+#endif
+
+    // a failure is reported to the command by startProcedure
+    if (!ptr) {
+        ptr = std::malloc(size);
+    }
+
+    return ptr;
+}
+
+void AsyncProcedure::operator delete(void* ptr) throw() {
+#if BLE_CLIAPP_PROCEDURE_POOL
+    if (smallSlots.owns(ptr)) {
+        smallSlots.deallocate(ptr);
+        return;
+    }
+    if (largeSlots.owns(ptr)) {
+        largeSlots.deallocate(ptr);
+        return;
+    }
+#endif
+    std::free(ptr);
+}
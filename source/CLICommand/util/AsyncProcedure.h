@@ -1,9 +1,57 @@
 #ifndef BLE_CLIAPP_CLICOMMAND_UTIL_ASYNC_PROCEDURE_
 #define BLE_CLIAPP_CLICOMMAND_UTIL_ASYNC_PROCEDURE_
 
+#include <stdint.h>
+#include <cstddef>
 #include "EventQueue/EventQueue.h"
 #include "CLICommand/Command.h"
 
+// the pool reserves about 2.3 KB of RAM with its default sizing, procedures
+// are allocated on the heap on the targets with 32 KB of RAM.
+#ifndef BLE_CLIAPP_PROCEDURE_POOL
+#if defined(TARGET_MCU_NRF51_32K_UNIFIED)
+#define BLE_CLIAPP_PROCEDURE_POOL 0
+#else
+#define BLE_CLIAPP_PROCEDURE_POOL 1
+#endif
+#endif
+
+#ifndef BLE_CLIAPP_PROCEDURE_POOL_SMALL_SLOT_SIZE
+static const std::size_t PROCEDURE_POOL_SMALL_SLOT_SIZE = 128;
+#else
+static const std::size_t PROCEDURE_POOL_SMALL_SLOT_SIZE = BLE_CLIAPP_PROCEDURE_POOL_SMALL_SLOT_SIZE;
+#endif
+
+#ifndef BLE_CLIAPP_PROCEDURE_POOL_SMALL_SLOT_COUNT
+static const std::size_t PROCEDURE_POOL_SMALL_SLOT_COUNT = 4;
+#else
+static const std::size_t PROCEDURE_POOL_SMALL_SLOT_COUNT = BLE_CLIAPP_PROCEDURE_POOL_SMALL_SLOT_COUNT;
+#endif
+
+// large enough for the capture procedures of the GATT client and server with
+// their default sizing; they fail to compile if they do not fit.
+#ifndef BLE_CLIAPP_PROCEDURE_POOL_LARGE_SLOT_SIZE
+static const std::size_t PROCEDURE_POOL_LARGE_SLOT_SIZE = 1792;
+#else
+static const std::size_t PROCEDURE_POOL_LARGE_SLOT_SIZE = BLE_CLIAPP_PROCEDURE_POOL_LARGE_SLOT_SIZE;
+#endif
+
+#ifndef BLE_CLIAPP_PROCEDURE_POOL_LARGE_SLOT_COUNT
+static const std::size_t PROCEDURE_POOL_LARGE_SLOT_COUNT = 1;
+#else
+static const std::size_t PROCEDURE_POOL_LARGE_SLOT_COUNT = BLE_CLIAPP_PROCEDURE_POOL_LARGE_SLOT_COUNT;
+#endif
+
+/**
+ * @brief Fail the compilation if a procedure does not fit in a large slot of
+ * the procedure pool; it would be allocated on the heap at each start. The
+ * check passes if the pool is disabled.
+ */
+#define ASYNC_PROCEDURE_FITS_POOL(ProcedureType) \
+    typedef char ProcedureType##_exceeds_the_procedure_pool_large_slot[ \
+        (!BLE_CLIAPP_PROCEDURE_POOL || sizeof(ProcedureType) <= PROCEDURE_POOL_LARGE_SLOT_SIZE) ? 1 : -1 \
+    ]
+
 /**
  * @brief Base class for used to build Asynchronous commands.
  * @details This base class help command writer to write clean and efficient 
@@ -60,6 +108,23 @@
     // start the procedure
     startProcedure<MyLongProcedure>(stateA, ..., response, 10 * 1000);
  * @endcode
+ *
+ * Procedures are allocated in a pool of fixed size slots rather than on the
+ * heap: the pool has a small and a large size class, each procedure takes a
+ * slot of the smallest class it fits in. Their size and number of slots are set
+ * at compile time with BLE_CLIAPP_PROCEDURE_POOL_SMALL_SLOT_SIZE,
+ * BLE_CLIAPP_PROCEDURE_POOL_SMALL_SLOT_COUNT,
+ * BLE_CLIAPP_PROCEDURE_POOL_LARGE_SLOT_SIZE and
+ * BLE_CLIAPP_PROCEDURE_POOL_LARGE_SLOT_COUNT. Procedures which do not fit in
+ * any class are allocated on the heap and accounted; a small procedure which
+ * finds all the small slots in use takes a large slot, then falls back to the
+ * heap. Large procedures check that they fit in a large slot with
+ * ASYNC_PROCEDURE_FITS_POOL. The pool is disabled, and all the procedures
+ * allocated on the heap, if BLE_CLIAPP_PROCEDURE_POOL is 0; it is the default
+ * on MCU_NRF51_32K_UNIFIED.
+ *
+ * If a procedure cannot be allocated, startProcedure fails the command with
+ * the message "procedure allocation failed".
  */
 
 struct AsyncProcedure {
@@ -82,6 +147,49 @@ struct AsyncProcedure {
     template<typename ProcedureType, typename T0, typename T1, typename T2, typename T3, typename T4, typename T5>
     friend void startProcedure(const T0& arg0, const T1& arg1, const T2& arg2, const T3& arg3, const T4& arg4, const T5& arg5);
 
+public:
+    /**
+     * @brief Statistics of a size class of the procedure pool.
+     */
+    struct PoolStatistics {
+        std::size_t slotSize;       /// size of the slots
+        std::size_t slotCount;      /// number of slots
+        std::size_t used;           /// slots in use
+        std::size_t peak;           /// greatest number of slots used at once
+        uint32_t exhausted;         /// allocations which found all the slots in use
+    };
+
+    /**
+     * @brief Get the statistics of a size class of the procedure pool.
+     * @param sizeClass Index of the class, from the smallest to the largest.
+     * @return false if there is no class at sizeClass or if the pool is
+     * disabled.
+     */
+    static bool getPoolStatistics(std::size_t sizeClass, PoolStatistics& statistics);
+
+    /**
+     * @brief Return the number of procedures allocated on the heap because
+     * they are larger than the slots of the largest class.
+     */
+    static uint32_t oversizedProcedures();
+
+    /**
+     * @brief Reset the peaks and the allocation counters of the pool.
+     */
+    static void resetPoolStatistics();
+
+    /**
+     * @brief Allocate a procedure in the procedure pool.
+     * @return The memory allocated or NULL if the pool and the heap are
+     * exhausted; the procedure is not constructed in this case.
+     */
+    static void* operator new(std::size_t size) throw();
+
+    /**
+     * @brief Release a procedure allocated by operator new.
+     */
+    static void operator delete(void* ptr) throw();
+
 protected:
 
     /**
@@ -140,9 +248,22 @@ private:
     uint32_t timeout;
 };
 
+/**
+ * @brief Report the failure of the allocation of a procedure to its command;
+ * startProcedure calls it with each of its arguments, only the response of
+ * the command is written.
+ */
+template<typename T>
+void reportProcedureAllocationFailure(const T&) { }
+
+inline void reportProcedureAllocationFailure(const CommandResponsePtr& response) {
+    response->faillure("procedure allocation failed");
+}
+
 /**
  * @brief start a new procedure, variadic args will be forwarded to
- * ProcedureType constructor.
+ * ProcedureType constructor. The command fails if the procedure cannot be
+ * allocated.
  *
  * @param args Args used to build the procedure
  * @tparam ProcedureType The type of procedure to start
@@ -150,36 +271,75 @@ private:
 template<typename ProcedureType, typename T0>
 void startProcedure(T0& arg0) {
     ProcedureType* proc = new ProcedureType(arg0);
+    if (!proc) {
+        reportProcedureAllocationFailure(arg0);
+        return;
+    }
     proc->start();
 }
 
 template<typename ProcedureType, typename T0, typename T1>
 void startProcedure(const T0& arg0, const T1& arg1) {
     ProcedureType* proc = new ProcedureType(arg0, arg1);
+    if (!proc) {
+        reportProcedureAllocationFailure(arg0);
+        reportProcedureAllocationFailure(arg1);
+        return;
+    }
     proc->start();
 }
 
 template<typename ProcedureType, typename T0, typename T1, typename T2>
 void startProcedure(const T0& arg0, const T1& arg1, const T2& arg2) {
     ProcedureType* proc = new ProcedureType(arg0, arg1, arg2);
+    if (!proc) {
+        reportProcedureAllocationFailure(arg0);
+        reportProcedureAllocationFailure(arg1);
+        reportProcedureAllocationFailure(arg2);
+        return;
+    }
     proc->start();
 }
 
 template<typename ProcedureType, typename T0, typename T1, typename T2, typename T3>
 void startProcedure(const T0& arg0, const T1& arg1, const T2& arg2, const T3& arg3) {
     ProcedureType* proc = new ProcedureType(arg0, arg1, arg2, arg3);
+    if (!proc) {
+        reportProcedureAllocationFailure(arg0);
+        reportProcedureAllocationFailure(arg1);
+        reportProcedureAllocationFailure(arg2);
+        reportProcedureAllocationFailure(arg3);
+        return;
+    }
     proc->start();
 }
 
 template<typename ProcedureType, typename T0, typename T1, typename T2, typename T3, typename T4>
 void startProcedure(const T0& arg0, const T1& arg1, const T2& arg2, const T3& arg3, const T4& arg4) {
     ProcedureType* proc = new ProcedureType(arg0, arg1, arg2, arg3, arg4);
+    if (!proc) {
+        reportProcedureAllocationFailure(arg0);
+        reportProcedureAllocationFailure(arg1);
+        reportProcedureAllocationFailure(arg2);
+        reportProcedureAllocationFailure(arg3);
+        reportProcedureAllocationFailure(arg4);
+        return;
+    }
     proc->start();
 }
 
 template<typename ProcedureType, typename T0, typename T1, typename T2, typename T3, typename T4, typename T5>
 void startProcedure(const T0& arg0, const T1& arg1, const T2& arg2, const T3& arg3, const T4& arg4, const T5& arg5) {
     ProcedureType* proc = new ProcedureType(arg0, arg1, arg2, arg3, arg4, arg5);
+    if (!proc) {
+        reportProcedureAllocationFailure(arg0);
+        reportProcedureAllocationFailure(arg1);
+        reportProcedureAllocationFailure(arg2);
+        reportProcedureAllocationFailure(arg3);
+        reportProcedureAllocationFailure(arg4);
+        reportProcedureAllocationFailure(arg5);
+        return;
+    }
     proc->start();
 }
 
@@ -0,0 +1,111 @@
+#include "ResultStream.h"
+#include "../CommandEventQueue.h"
+
+using serialization::ChunkedSerializer;
+using serialization::JSONOutputStream;
+
+namespace {
+
+typedef void (*DeferredCallback_t)();
+
+std::size_t activeStreams = 0;
+DeferredCallback_t deferredCallbacks[RESULT_STREAM_DEFERRED_CALLBACK_COUNT];
+std::size_t deferredCallbackCount = 0;
+
+/*
+ * Post the callbacks deferred once no result is being streamed; the responses
+ * are closed at this point so a callback which cannot be posted is called
+ * directly.
+ */
+void releaseDeferredCallbacks() {
+    if (activeStreams) {
+        return;
+    }
+
+    std::size_t count = deferredCallbackCount;
+    deferredCallbackCount = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (getCLICommandEventQueue()->post(deferredCallbacks[i]) == NULL) {
+            deferredCallbacks[i]();
+        }
+    }
+}
+
+/**
+ * State of a result being streamed, it holds a reference to the response which
+ * keeps it open until the stream completes.
+ */
+struct ResultStream {
+    ResultStream(const CommandResponsePtr& res, ChunkedSerializer* s) :
+        response(res), serializer(s) {
+        ++activeStreams;
+    }
+
+    ~ResultStream() {
+        delete serializer;
+        --activeStreams;
+    }
+
+    void writeChunk() {
+        JSONOutputStream& os = response->getResultStream();
+        std::size_t start = os.bytesWritten();
+
+        bool remaining = true;
+        while (remaining && (os.bytesWritten() - start) < RESULT_STREAM_CHUNK_SIZE) {
+            remaining = serializer->next(os);
+        }
+
+        if (remaining && schedule()) {
+            return;
+        }
+
+        // if the queue is full, the result is completed at once
+        while (remaining) {
+            remaining = serializer->next(os);
+        }
+        response->close();
+        delete this;
+        releaseDeferredCallbacks();
+    }
+
+    bool schedule() {
+        return getCLICommandEventQueue()->post(
+            eq::EventQueue::PRIORITY_LOW, &ResultStream::writeChunk, this
+        ) != NULL;
+    }
+
+    CommandResponsePtr response;
+    ChunkedSerializer* serializer;
+};
+
+} // end of anonymous namespace
+
+void streamResult(const CommandResponsePtr& response, ChunkedSerializer* serializer) {
+    ResultStream* stream = new ResultStream(response, serializer);
+    if (!stream->schedule()) {
+        stream->writeChunk();
+    }
+}
+
+bool resultStreamActive() {
+    return activeStreams != 0;
+}
+
+bool postAfterResultStreams(void (*callback)()) {
+    if (!activeStreams) {
+        return getCLICommandEventQueue()->post(callback) != NULL;
+    }
+
+    for (std::size_t i = 0; i < deferredCallbackCount; ++i) {
+        if (deferredCallbacks[i] == callback) {
+            return true;
+        }
+    }
+
+    if (deferredCallbackCount == RESULT_STREAM_DEFERRED_CALLBACK_COUNT) {
+        return false;
+    }
+
+    deferredCallbacks[deferredCallbackCount++] = callback;
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef BLE_CLIAPP_CLICOMMAND_UTIL_RESULT_STREAM_
+#define BLE_CLIAPP_CLICOMMAND_UTIL_RESULT_STREAM_
+
+#include <cstddef>
+#include "CLICommand/Command.h"
+#include "Serialization/ChunkedSerializer.h"
+
+#ifndef BLE_CLIAPP_RESULT_STREAM_CHUNK_SIZE
+static const std::size_t RESULT_STREAM_CHUNK_SIZE = 128;
+#else
+static const std::size_t RESULT_STREAM_CHUNK_SIZE = BLE_CLIAPP_RESULT_STREAM_CHUNK_SIZE;
+#endif
+
+#ifndef BLE_CLIAPP_RESULT_STREAM_DEFERRED_CALLBACK_COUNT
+static const std::size_t RESULT_STREAM_DEFERRED_CALLBACK_COUNT = 4;
+#else
+static const std::size_t RESULT_STREAM_DEFERRED_CALLBACK_COUNT = BLE_CLIAPP_RESULT_STREAM_DEFERRED_CALLBACK_COUNT;
+#endif
+
+/**
+ * @brief Write the result of a response from a chunked serializer without
+ * blocking the event queue.
+ * @details At each dispatch turn, fragments are written until at least
+ * RESULT_STREAM_CHUNK_SIZE bytes have been output then the rest of the result
+ * is rescheduled in the low priority class of the CLICommand event queue; the
+ * events of the BLE stack are dispatched between two chunks. The response is
+ * kept open until the last fragment has been written and closed once the
+ * result is complete.
+ *
+ * @code
+    response->success();
+    streamResult(response, new MySerializer(value));
+ * @endcode
+ *
+ * @param response The response to write; its status code should be set.
+ * @param serializer The serializer of the result. It is allocated with new and
+ * owned by the stream which deletes it once the result is complete.
+ */
+void streamResult(const CommandResponsePtr& response, serialization::ChunkedSerializer* serializer);
+
+/**
+ * @brief Indicate if a result is being streamed.
+ */
+bool resultStreamActive();
+
+/**
+ * @brief Post a callback in the CLICommand event queue once no result is being
+ * streamed.
+ * @details Asynchronous events written while a result is streamed would be
+ * inserted in the middle of the response. Producers of events post the output
+ * of their events with this function and keep the events buffered meanwhile.
+ * Up to RESULT_STREAM_DEFERRED_CALLBACK_COUNT distinct callbacks can wait for
+ * the streams in progress.
+ *
+ * @param callback The function to post.
+ * @return true if the callback has been posted or deferred and false otherwise.
+ */
+bool postAfterResultStreams(void (*callback)());
+
+#endif //BLE_CLIAPP_CLICOMMAND_UTIL_RESULT_STREAM_
@@ -4,6 +4,8 @@
 #include "CLICommand/util/AsyncProcedure.h"
 #include "CLICommand/CommandHelper.h"
 #include "Common.h"
+#include "util/ConnectionTable.h"
+#include "CLICommand/CommandEventQueue.h"
 
 #if not defined(NO_FILESYSTEM)
 #include "LittleFileSystem.h"
@@ -64,6 +66,7 @@ DECLARE_CMD(InitCommand) {
             if(initializationStatus->error) {
                 response->faillure(initializationStatus->error);
             } else {
+                ConnectionTable::attach();
                 response->success();
             }
             terminate();
@@ -94,6 +97,7 @@ DECLARE_CMD(ResetCommand) {
         if(err) {
             response->faillure("Failled to init the ble instance");
         } else {
+            ConnectionTable::attach();
             response->success();
         }
     }
@@ -149,6 +153,132 @@ DECLARE_CMD(CreateFilesystem) {
     }
 };
 
+DECLARE_CMD(GetEventQueueMetricsCommand) {
+    CMD_NAME("getEventQueueMetrics")
+
+    CMD_HELP(
+        "Return the metrics of the event queue of the application. Durations "
+        "are in milliseconds."
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("uint32_t", "capacity", "Number of events the queue can hold."),
+        CMD_RESULT("uint32_t", "occupancy", "Number of events in the queue."),
+        CMD_RESULT("uint32_t", "peak_occupancy", "Greatest number of events held by the queue."),
+        CMD_RESULT("uint32_t", "post_failures", "Events rejected because the queue was full."),
+        CMD_RESULT("uint32_t", "dispatched", "Events dispatched."),
+        CMD_RESULT("uint32_t", "max_dispatch_lag", "Longest delay between the deadline of an event and its dispatch."),
+        CMD_RESULT("uint32_t", "max_callback_duration", "Longest execution of an event."),
+        CMD_RESULT("JSON Array", "sites", "Metrics of each call site of post."),
+        CMD_RESULT("string", "sites[x].site", "Address of the call to post, null for the sites not tracked."),
+        CMD_RESULT("uint32_t", "sites[x].posted", "Events posted from the site."),
+        CMD_RESULT("uint32_t", "sites[x].max_callback_duration", "Longest execution of an event posted from the site.")
+    )
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        using namespace serialization;
+
+        eq::EventQueue* queue = getCLICommandEventQueue();
+        eq::EventQueue::Metrics metrics;
+        if (!queue->get_metrics(metrics)) {
+            response->notImplemented();
+            return;
+        }
+
+        JSONOutputStream& os = response->getResultStream();
+        os << startObject <<
+            key("capacity") << (uint32_t) metrics.capacity <<
+            key("occupancy") << (uint32_t) metrics.occupancy <<
+            key("peak_occupancy") << (uint32_t) metrics.peak_occupancy <<
+            key("post_failures") << metrics.post_failures <<
+            key("dispatched") << metrics.dispatched <<
+            key("max_dispatch_lag") << (uint32_t) metrics.max_dispatch_lag <<
+            key("max_callback_duration") << (uint32_t) metrics.max_callback_duration <<
+            key("sites") << startArray;
+
+        eq::EventQueue::SiteMetrics site;
+        for (std::size_t i = 0; queue->get_site_metrics(i, site); ++i) {
+            os << startObject << key("site");
+            if (site.site) {
+                os.formatValue("\"0x%08lX\"", (unsigned long) (uintptr_t) site.site);
+            } else {
+                os << nil;
+            }
+            os <<
+                key("posted") << site.posted <<
+                key("max_callback_duration") << (uint32_t) site.max_callback_duration <<
+            endObject;
+        }
+
+        os << endArray << endObject;
+        response->success();
+    }
+};
+
+DECLARE_CMD(ResetEventQueueMetricsCommand) {
+    CMD_NAME("resetEventQueueMetrics")
+
+    CMD_HELP("Reset the metrics of the event queue of the application.")
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        getCLICommandEventQueue()->reset_metrics();
+        response->success();
+    }
+};
+
+DECLARE_CMD(GetProcedurePoolStatisticsCommand) {
+    CMD_NAME("getProcedurePoolStatistics")
+
+    CMD_HELP(
+        "Return the statistics of the pool where asynchronous procedures are "
+        "allocated. Size classes are listed from the smallest to the largest."
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("JSON Array", "classes", "Statistics of each size class of the pool."),
+        CMD_RESULT("uint32_t", "classes[x].slot_size", "Size of the slots of the class."),
+        CMD_RESULT("uint32_t", "classes[x].slot_count", "Number of slots of the class."),
+        CMD_RESULT("uint32_t", "classes[x].used", "Slots in use."),
+        CMD_RESULT("uint32_t", "classes[x].peak", "Greatest number of slots used at once."),
+        CMD_RESULT("uint32_t", "classes[x].exhausted", "Allocations which found all the slots of the class in use."),
+        CMD_RESULT("uint32_t", "oversized", "Procedures allocated on the heap because they do not fit in any class.")
+    )
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        using namespace serialization;
+
+        JSONOutputStream& os = response->getResultStream();
+        os << startObject << key("classes") << startArray;
+
+        AsyncProcedure::PoolStatistics statistics;
+        for (std::size_t i = 0; AsyncProcedure::getPoolStatistics(i, statistics); ++i) {
+            os << startObject <<
+                key("slot_size") << (uint32_t) statistics.slotSize <<
+                key("slot_count") << (uint32_t) statistics.slotCount <<
+                key("used") << (uint32_t) statistics.used <<
+                key("peak") << (uint32_t) statistics.peak <<
+                key("exhausted") << statistics.exhausted <<
+            endObject;
+        }
+
+        os << endArray <<
+            key("oversized") << AsyncProcedure::oversizedProcedures() <<
+        endObject;
+        response->success();
+    }
+};
+
+DECLARE_CMD(ResetProcedurePoolStatisticsCommand) {
+    CMD_NAME("resetProcedurePoolStatistics")
+
+    CMD_HELP("Reset the peaks and the allocation counters of the procedure pool.")
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        AsyncProcedure::resetPoolStatistics();
+        response->success();
+    }
+};
+
 } // end of annonymous namespace
 
 
@@ -157,5 +287,9 @@ DECLARE_SUITE_COMMANDS(BLECommandSuiteDescription,
     CMD_INSTANCE(InitCommand),
     CMD_INSTANCE(ResetCommand),
     CMD_INSTANCE(GetVersionCommand),
-    CMD_INSTANCE(CreateFilesystem)
+    CMD_INSTANCE(CreateFilesystem),
+    CMD_INSTANCE(GetEventQueueMetricsCommand),
+    CMD_INSTANCE(ResetEventQueueMetricsCommand),
+    CMD_INSTANCE(GetProcedurePoolStatisticsCommand),
+    CMD_INSTANCE(ResetProcedurePoolStatisticsCommand)
 )
@@ -0,0 +1,853 @@
+#include <string.h>
+#include <algorithm>
+
+#ifdef YOTTA_CFG
+#include "mbed-drivers/Timer.h"
+#else
+#include "Timer.h"
+#include "EventQueue/EventQueueClassicMbed.h"
+#endif
+
+#include "ble/BLE.h"
+#include "EventQueue/PriorityQueue.h"
+#include "EventQueue/Thunk.h"
+#include "EventQueue/MakeThunk.h"
+#include "EventQueue/EventQueueClassic.h"
+#include "EventQueue/VirtualClock.h"
+
+#include "Serialization/Serializer.h"
+#include "Serialization/GapSerializer.h"
+#include "Serialization/GapAdvertisingDataSerializer.h"
+#include "Serialization/Hex.h"
+#include "Serialization/UUID.h"
+
+#include "CLICommand/CommandHelper.h"
+#include "CLICommand/detail/CommandSuiteImplementation.h"
+#include "CLICommand/util/AsyncProcedure.h"
+
+#include "util/ServiceBuilder.h"
+
+#if defined(MBED_HEAP_STATS_ENABLED) && MBED_HEAP_STATS_ENABLED
+#define BENCH_HEAP_STATS
+#include "platform/mbed_stats.h"
+#endif
+
+#include "BenchCommands.h"
+#include "GapCommands.h"
+
+using namespace serialization;
+
+/*
+ * Access to the command lookup of CommandSuiteImplementation, which is private.
+ */
+struct CommandLookupBench {
+    static const Command* getCommand(
+        const char* name,
+        const ConstArray<const Command*>& builtinCommands,
+        const ConstArray<const Command*>& moduleCommands
+    ) {
+        return CommandSuiteImplementation::getCommand(name, builtinCommands, moduleCommands);
+    }
+};
+
+// isolation
+namespace {
+
+#ifndef BLE_CLIAPP_BENCH_QUEUE_CAPACITY
+static const std::size_t BENCH_QUEUE_CAPACITY = 32;
+#else
+static const std::size_t BENCH_QUEUE_CAPACITY = BLE_CLIAPP_BENCH_QUEUE_CAPACITY;
+#endif
+
+/*
+ * Output sink which discards and counts the bytes written, serialization
+ * benchmarks measure the cost of the formatting rather than the cost of the
+ * serial line.
+ */
+struct NullOutputSink : OutputSink {
+    NullOutputSink() : count(0) { }
+
+    virtual void put(char) {
+        ++count;
+    }
+
+    virtual void write(const char* data) {
+        count += strlen(data);
+    }
+
+    virtual void write(const char*, std::size_t size) {
+        count += size;
+    }
+
+    std::size_t count;
+};
+
+// results of the benchmarks are accumulated here to keep them alive
+volatile uint32_t benchSink;
+
+static void accumulate(uint32_t value) {
+    benchSink = benchSink + value;
+}
+
+/*
+ * Serialize the measure of a benchmark as a JSON object with the attributes
+ * name, iterations, total_us and per_op_ns.
+ */
+static void report(JSONOutputStream& os, const char* name, uint32_t operations, uint32_t elapsedUs) {
+    os << startObject <<
+        key("name") << name <<
+        key("iterations") << operations <<
+        key("total_us") << elapsedUs <<
+        key("per_op_ns") << (uint32_t) (((uint64_t) elapsedUs * 1000) / operations) <<
+    endObject;
+}
+
+DECLARE_CMD(SerializationCommand) {
+    CMD_NAME("serialization")
+
+    CMD_HELP(
+        "Measure the serialization of integers, strings and hex strings by "
+        "JSONOutputStream. The output is discarded."
+    )
+
+    CMD_ARGS(
+        CMD_ARG("uint32_t", "iterations", "Number of values serialized by each benchmark.")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("JSON Array", "", "Measures of the integer, string and hex benchmarks.")
+    )
+
+    CMD_HANDLER(uint32_t iterations, CommandResponsePtr& response) {
+        if (iterations == 0) {
+            response->invalidParameters("iterations should be greater than 0");
+            return;
+        }
+
+        static const uint8_t payload[] = {
+            0x02, 0x01, 0x06, 0x03, 0x03, 0x0D, 0x18, 0x09, 0x09, 0x62, 0x6C,
+            0x65, 0x2D, 0x63, 0x6C, 0x69, 0x03, 0x19, 0x40, 0x03
+        };
+
+        NullOutputSink sink;
+        mbed::Timer timer;
+        JSONOutputStream& os = response->getResultStream();
+        os << startArray;
+
+        {
+            JSONOutputStream out(sink);
+            out << startArray;
+            timer.reset();
+            timer.start();
+            for (uint32_t i = 0; i < iterations; ++i) {
+                out << (uint32_t) (i * 2654435761u);
+            }
+            timer.stop();
+            out << endArray;
+        }
+        report(os, "integer", iterations, timer.read_us());
+
+        {
+            JSONOutputStream out(sink);
+            out << startArray;
+            timer.reset();
+            timer.start();
+            for (uint32_t i = 0; i < iterations; ++i) {
+                out << "ADV_CONNECTABLE_UNDIRECTED";
+            }
+            timer.stop();
+            out << endArray;
+        }
+        report(os, "string", iterations, timer.read_us());
+
+        {
+            JSONOutputStream out(sink);
+            out << startArray;
+            timer.reset();
+            timer.start();
+            for (uint32_t i = 0; i < iterations; ++i) {
+                serializeRawDataToHexString(out, payload, sizeof(payload));
+            }
+            timer.stop();
+            out << endArray;
+        }
+        report(os, "hex", iterations, timer.read_us());
+
+        os << endArray;
+        accumulate(sink.count);
+        response->success();
+    }
+};
+
+DECLARE_CMD(AdvertisingDataCommand) {
+    CMD_NAME("advertisingData")
+
+    CMD_HELP(
+        "Measure the serialization of an advertising payload by "
+        "AdvertisingDataSerializer. The output is discarded."
+    )
+
+    CMD_ARGS(
+        CMD_ARG("uint32_t", "iterations", "Number of times the payload is serialized."),
+        CMD_ARG("RawData_t", "payload", "Advertising payload captured, as an hex string.")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("JSON Object", "", "Measure of the benchmark.")
+    )
+
+    CMD_HANDLER(uint32_t iterations, RawData_t& payload, CommandResponsePtr& response) {
+        if (iterations == 0) {
+            response->invalidParameters("iterations should be greater than 0");
+            return;
+        }
+
+        if (payload.size() > 0xFF) {
+            response->invalidParameters("payload is too large");
+            return;
+        }
+
+        NullOutputSink sink;
+        mbed::Timer timer;
+        {
+            JSONOutputStream out(sink);
+            out << startArray;
+            timer.start();
+            for (uint32_t i = 0; i < iterations; ++i) {
+                out << AdvertisingDataSerializer(payload.cbegin(), payload.size());
+            }
+            timer.stop();
+            out << endArray;
+        }
+
+        report(response->getResultStream(), "advertising_data", iterations, timer.read_us());
+        accumulate(sink.count);
+        response->success();
+    }
+};
+
+DECLARE_CMD(FromStringCommand) {
+    CMD_NAME("fromString")
+
+    CMD_HELP("Measure the parsing of MAC addresses, UUIDs and enums.")
+
+    CMD_ARGS(
+        CMD_ARG("uint32_t", "iterations", "Number of strings parsed by each benchmark.")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("JSON Array", "", "Measures of the mac_address, short_uuid, long_uuid and enum benchmarks.")
+    )
+
+    CMD_HANDLER(uint32_t iterations, CommandResponsePtr& response) {
+        if (iterations == 0) {
+            response->invalidParameters("iterations should be greater than 0");
+            return;
+        }
+
+        mbed::Timer timer;
+        JSONOutputStream& os = response->getResultStream();
+        os << startArray;
+
+        MacAddress_t address;
+        timer.start();
+        for (uint32_t i = 0; i < iterations; ++i) {
+            accumulate(fromString("D8:2F:A1:73:0C:5E", address));
+        }
+        timer.stop();
+        report(os, "mac_address", iterations, timer.read_us());
+
+        UUID uuid;
+        timer.reset();
+        timer.start();
+        for (uint32_t i = 0; i < iterations; ++i) {
+            accumulate(fromString("6157", uuid));
+        }
+        timer.stop();
+        report(os, "short_uuid", iterations, timer.read_us());
+
+        timer.reset();
+        timer.start();
+        for (uint32_t i = 0; i < iterations; ++i) {
+            accumulate(fromString("6E400001-B5A3-F393-E0A9-E50E24DCCA9E", uuid));
+        }
+        timer.stop();
+        report(os, "long_uuid", iterations, timer.read_us());
+
+        // the last entry of the mapping is the worst case of the lookup
+        Gap::AdvertisingPolicyMode_t policy;
+        timer.reset();
+        timer.start();
+        for (uint32_t i = 0; i < iterations; ++i) {
+            accumulate(fromString("ADV_POLICY_FILTER_ALL_REQS", policy));
+        }
+        timer.stop();
+        report(os, "enum", iterations, timer.read_us());
+
+        os << endArray;
+        response->success();
+    }
+};
+
+DECLARE_CMD(DispatchCommand) {
+    CMD_NAME("dispatch")
+
+    CMD_HELP(
+        "Measure the lookup of commands by name in the gap suite, every "
+        "command of the suite is looked up at each iteration."
+    )
+
+    CMD_ARGS(
+        CMD_ARG("uint32_t", "iterations", "Number of passes over the commands of the suite.")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("JSON Object", "", "Measure of the benchmark, an operation is a lookup.")
+    )
+
+    CMD_HANDLER(uint32_t iterations, CommandResponsePtr& response) {
+        if (iterations == 0) {
+            response->invalidParameters("iterations should be greater than 0");
+            return;
+        }
+
+        const ConstArray<const Command*> builtinCommands;
+        const ConstArray<const Command*> commands = GapCommandSuiteDescription::commands();
+
+        mbed::Timer timer;
+        timer.start();
+        for (uint32_t i = 0; i < iterations; ++i) {
+            for (std::size_t j = 0; j < commands.count(); ++j) {
+                accumulate(CommandLookupBench::getCommand(
+                    commands[j]->name(), builtinCommands, commands
+                ) != NULL);
+            }
+        }
+        timer.stop();
+
+        report(response->getResultStream(), "dispatch", iterations * commands.count(), timer.read_us());
+        response->success();
+    }
+};
+
+DECLARE_CMD(PriorityQueueCommand) {
+    CMD_NAME("priorityQueue")
+
+    CMD_HELP(
+        "Measure push/pop and update operations of the priority queue used by "
+        "the event queue at a given occupancy."
+    )
+
+    CMD_ARGS(
+        CMD_ARG("uint32_t", "iterations", "Number of operations of each benchmark."),
+        CMD_ARG("uint8_t", "occupancy", "Number of elements in the queue during the measures.")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("JSON Array", "", "Measures of the push_pop and update benchmarks.")
+    )
+
+    CMD_HANDLER(uint32_t iterations, uint8_t occupancy, CommandResponsePtr& response) {
+        if (iterations == 0) {
+            response->invalidParameters("iterations should be greater than 0");
+            return;
+        }
+
+        if (occupancy == 0 || occupancy >= BENCH_QUEUE_CAPACITY) {
+            response->invalidParameters("occupancy is out of range");
+            return;
+        }
+
+        typedef eq::PriorityQueue<uint32_t, BENCH_QUEUE_CAPACITY> queue_t;
+        queue_t queue;
+        uint32_t next = 0;
+        for (uint8_t i = 0; i < occupancy; ++i) {
+            queue.push(next);
+            next += 7;
+        }
+
+        mbed::Timer timer;
+        JSONOutputStream& os = response->getResultStream();
+        os << startArray;
+
+        // elements are inserted in the middle of the queue then the head
+        // is removed.
+        timer.start();
+        for (uint32_t i = 0; i < iterations; ++i) {
+            queue.push(*queue.begin() + (occupancy * 7) / 2);
+            queue.pop();
+        }
+        timer.stop();
+        report(os, "push_pop", iterations, timer.read_us());
+
+        // the head is delayed after the last element of the queue
+        timer.reset();
+        timer.start();
+        for (uint32_t i = 0; i < iterations; ++i) {
+            queue_t::iterator it = queue.begin();
+            *it = next;
+            next += 7;
+            queue.update(it);
+        }
+        timer.stop();
+        report(os, "update", iterations, timer.read_us());
+
+        os << endArray;
+        response->success();
+    }
+};
+
+static void benchEvent(uint32_t value) {
+    accumulate(value);
+}
+
+DECLARE_CMD(EventQueueCommand) {
+    CMD_NAME("eventQueue")
+
+    CMD_HELP(
+        "Measure the construction and call of thunks and the post and dispatch "
+        "of events in a private event queue."
+    )
+
+    CMD_ARGS(
+        CMD_ARG("uint32_t", "iterations", "Number of events of each benchmark.")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("JSON Array", "", "Measures of the thunk, post and dispatch benchmarks.")
+    )
+
+    CMD_HANDLER(uint32_t iterations, CommandResponsePtr& response) {
+        if (iterations == 0) {
+            response->invalidParameters("iterations should be greater than 0");
+            return;
+        }
+
+        mbed::Timer timer;
+        JSONOutputStream& os = response->getResultStream();
+        os << startArray;
+
+        timer.start();
+        for (uint32_t i = 0; i < iterations; ++i) {
+            eq::Thunk thunk(eq::make_thunk(&benchEvent, i));
+            thunk();
+        }
+        timer.stop();
+        report(os, "thunk", iterations, timer.read_us());
+
+#ifndef YOTTA_CFG
+        // events are posted and dispatched by batches which fill the queue
+        static eq::EventQueueClassic<BENCH_QUEUE_CAPACITY> queue;
+        mbed::Timer dispatchTimer;
+        timer.reset();
+        for (uint32_t i = 0; i < iterations; i += BENCH_QUEUE_CAPACITY) {
+            uint32_t batch = std::min<uint32_t>(BENCH_QUEUE_CAPACITY, iterations - i);
+            timer.start();
+            for (uint32_t j = 0; j < batch; ++j) {
+                queue.post(&benchEvent, j);
+            }
+            timer.stop();
+            dispatchTimer.start();
+            queue.dispatch();
+            dispatchTimer.stop();
+        }
+        report(os, "post", iterations, timer.read_us());
+        report(os, "dispatch", iterations, dispatchTimer.read_us());
+#endif
+
+        os << endArray;
+        response->success();
+    }
+};
+
+/*
+ * Two devices simulated on the virtual clock: the first one sends a message to
+ * the second one every SIMULATED_SEND_PERIOD ms, the message is received
+ * SIMULATED_LATENCY ms later; the second one also runs a periodic tick.
+ */
+typedef eq::EventQueueClassic<
+    4, eq::VirtualTicker, eq::VirtualTimer, 2, eq::NoCriticalSection,
+    eq::NoDispatchProbe
+> SimulatedQueue;
+
+static const uint32_t SIMULATED_SEND_PERIOD = 7;
+static const uint32_t SIMULATED_TICK_PERIOD = 11;
+static const uint32_t SIMULATED_LATENCY = 3;
+
+struct SimulationCounters {
+    uint32_t sent;
+    uint32_t received;
+    uint32_t ticks;
+};
+
+static void simulatedReceive(SimulationCounters* counters) {
+    ++counters->received;
+}
+
+static void simulatedSend(SimulatedQueue* peer, SimulationCounters* counters) {
+    ++counters->sent;
+    peer->post_in(&simulatedReceive, counters, SIMULATED_LATENCY);
+}
+
+static void simulatedTick(SimulationCounters* counters) {
+    ++counters->ticks;
+}
+
+static void reportSimulatedEvents(JSONOutputStream& os, const char* name, uint32_t dispatched, uint32_t expected) {
+    os << key(name) << startObject <<
+        key("dispatched") << dispatched <<
+        key("expected") << expected <<
+    endObject;
+}
+
+DECLARE_CMD(VirtualClockCommand) {
+    CMD_NAME("virtualClock")
+
+    CMD_HELP(
+        "Run two event queues on the virtual clock for a simulated duration and "
+        "compare the events dispatched with the events expected. The first queue "
+        "sends a message to the second one every 7 ms, messages are received 3 ms "
+        "later; the second queue runs a tick every 11 ms."
+    )
+
+    CMD_ARGS(
+        CMD_ARG("uint32_t", "duration", "Simulated duration in ms.")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("uint32_t", "simulated_ms", "Time of the last step of the simulation."),
+        CMD_RESULT("uint32_t", "steps", "Number of steps of the virtual clock."),
+        CMD_RESULT("uint32_t", "total_us", "Time spent to run the simulation."),
+        CMD_RESULT("JSON Object", "sent", "Messages sent, dispatched and expected."),
+        CMD_RESULT("JSON Object", "received", "Messages received, dispatched and expected."),
+        CMD_RESULT("JSON Object", "ticks", "Ticks, dispatched and expected."),
+        CMD_RESULT("bool", "deterministic", "True if every count matches its expectation.")
+    )
+
+    CMD_HANDLER(uint32_t duration, CommandResponsePtr& response) {
+        eq::VirtualClock& clock = eq::VirtualClock::instance();
+        SimulationCounters counters = { 0, 0, 0 };
+        uint32_t steps = 0;
+
+        mbed::Timer timer;
+        timer.start();
+        clock.reset();
+        {
+            // the tickers of the queues are detached when the queues are destroyed
+            SimulatedQueue devices[2];
+            devices[0].post_every(&simulatedSend, &devices[1], &counters, SIMULATED_SEND_PERIOD);
+            devices[1].post_every(&simulatedTick, &counters, SIMULATED_TICK_PERIOD);
+
+            while (true) {
+                devices[0].dispatch();
+                devices[1].dispatch();
+
+                eq::VirtualClock::ms_time_t deadline;
+                if (!clock.next_deadline(deadline) || deadline > duration) {
+                    break;
+                }
+                clock.step();
+                ++steps;
+            }
+        }
+        timer.stop();
+
+        uint32_t expectedSent = duration / SIMULATED_SEND_PERIOD;
+        uint32_t expectedReceived = (duration >= SIMULATED_LATENCY) ?
+            ((duration - SIMULATED_LATENCY) / SIMULATED_SEND_PERIOD) : 0;
+        uint32_t expectedTicks = duration / SIMULATED_TICK_PERIOD;
+
+        JSONOutputStream& os = response->getResultStream();
+        os << startObject <<
+            key("simulated_ms") << (uint32_t) clock.now() <<
+            key("steps") << steps <<
+            key("total_us") << (uint32_t) timer.read_us();
+        reportSimulatedEvents(os, "sent", counters.sent, expectedSent);
+        reportSimulatedEvents(os, "received", counters.received, expectedReceived);
+        reportSimulatedEvents(os, "ticks", counters.ticks, expectedTicks);
+        os << key("deterministic") << (
+            counters.sent == expectedSent &&
+            counters.received == expectedReceived &&
+            counters.ticks == expectedTicks
+        ) << endObject;
+        response->success();
+    }
+};
+
+DECLARE_CMD(ServiceDeclarationCommand) {
+    CMD_NAME("serviceDeclaration")
+
+    CMD_HELP(
+        "Declare then destroy a service with a ServiceBuilder and report the "
+        "heap operations of the declaration. Each characteristic has a value, "
+        "replaced once by a shorter one, and a descriptor. The arenas of the "
+        "service are sized with RAIIGattService::declarationSize and the size "
+        "of the values; the command fails if the declaration or the values "
+        "don't fit in the first chunk of their arena or if values remain once "
+        "released. The service is not added to the GattServer. Heap figures "
+        "require MBED_HEAP_STATS_ENABLED and are null otherwise."
+    )
+
+    CMD_ARGS(
+        CMD_ARG("uint8_t", "characteristics", "Number of characteristics of the service.")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("uint32_t", "total_us", "Time spent to declare and destroy the service."),
+        CMD_RESULT("uint32_t", "declaration_size", "Size of the arena computed by declarationSize."),
+        CMD_RESULT("uint32_t", "declaration_used", "Memory used in the arena by the declaration."),
+        CMD_RESULT("uint32_t", "values_size", "Size of the arena of values computed."),
+        CMD_RESULT("uint32_t", "values_used", "Memory used in the arena of values."),
+        CMD_RESULT("uint32_t", "allocations", "Heap allocations made by the declaration."),
+        CMD_RESULT("uint32_t", "footprint", "Heap used by the service declared."),
+        CMD_RESULT("uint32_t", "leaked", "Heap still used once the service is destroyed.")
+    )
+
+    CMD_HANDLER(uint8_t characteristics, CommandResponsePtr& response) {
+        static const uint8_t value[20] = { 0 };
+
+#if defined(BENCH_HEAP_STATS)
+        mbed_stats_heap_t start;
+        mbed_stats_heap_t declared;
+        mbed_stats_heap_t end;
+        mbed_stats_heap_get(&start);
+#endif
+
+        const std::size_t declarationSize =
+            detail::RAIIGattService::declarationSize(characteristics, characteristics);
+        const std::size_t valuesSize = characteristics * (
+            util::BumpArena::alignedSize(sizeof(value)) + util::BumpArena::alignedSize(sizeof(value))
+        );
+        std::size_t declarationUsed = 0;
+        std::size_t declarationChunks = 0;
+        std::size_t valuesUsed = 0;
+        std::size_t valuesChunks = 0;
+        std::size_t valuesLeft = 0;
+
+        mbed::Timer timer;
+        timer.start();
+        bool success = true;
+        {
+            ServiceBuilder builder(UUID((UUID::ShortUUIDBytes_t) 0xA000), declarationSize, valuesSize);
+            success = builder.isValid();
+            for (uint8_t i = 0; success && i < characteristics; ++i) {
+                success =
+                    builder.declareCharacteristic(UUID((UUID::ShortUUIDBytes_t) (0xA001 + i))) &&
+                    builder.setCharacteristicValue(value, sizeof(value)) &&
+                    builder.setCharacteristicValue(value, sizeof(value) / 2) &&
+                    builder.declareDescriptor(UUID((UUID::ShortUUIDBytes_t) 0x2901)) &&
+                    builder.setDescriptorValue(value, sizeof(value));
+            }
+
+            detail::RAIIGattService* service = success ? builder.release() : NULL;
+            success = service != NULL;
+
+#if defined(BENCH_HEAP_STATS)
+            mbed_stats_heap_get(&declared);
+#endif
+
+            if (service) {
+                declarationUsed = service->arena().used();
+                declarationChunks = service->arena().chunkCount();
+                valuesUsed = service->valuesArena().used();
+                valuesChunks = service->valuesArena().chunkCount();
+                service->releaseAttributesValue();
+                valuesLeft = service->valuesArena().used();
+                for (uint8_t i = 0; i < service->getCharacteristicCount(); ++i) {
+                    GattCharacteristic* characteristic = service->getCharacteristic(i);
+                    valuesLeft += characteristic->getValueAttribute().getLength();
+                    for (uint8_t j = 0; j < characteristic->getDescriptorCount(); ++j) {
+                        valuesLeft += characteristic->getDescriptor(j)->getLength();
+                    }
+                }
+                detail::RAIIGattService::destroy(service);
+            }
+        }
+        timer.stop();
+
+        if (!success) {
+            response->faillure("heap exhausted");
+            return;
+        }
+
+        JSONOutputStream& os = response->getResultStream();
+        os << startObject <<
+            key("total_us") << (uint32_t) timer.read_us() <<
+            key("declaration_size") << (uint32_t) declarationSize <<
+            key("declaration_used") << (uint32_t) declarationUsed <<
+            key("values_size") << (uint32_t) valuesSize <<
+            key("values_used") << (uint32_t) valuesUsed;
+#if defined(BENCH_HEAP_STATS)
+        mbed_stats_heap_get(&end);
+        os <<
+            key("allocations") << (uint32_t) (declared.alloc_cnt - start.alloc_cnt) <<
+            key("footprint") << (uint32_t) (declared.current_size - start.current_size) <<
+            key("leaked") << (uint32_t) (end.current_size - start.current_size);
+#else
+        os <<
+            key("allocations") << nil <<
+            key("footprint") << nil <<
+            key("leaked") << nil;
+#endif
+        os << endObject;
+
+        // each arena is sized to be held in a single chunk
+        if (declarationUsed > declarationSize || declarationChunks != 1 ||
+            valuesUsed > valuesSize || valuesChunks > 1 || valuesLeft) {
+            response->faillure();
+        } else {
+            response->success();
+        }
+    }
+};
+
+/*
+ * Procedure allocated but never started by the procedurePool benchmark; the
+ * payload sets the size class it falls in.
+ */
+template<std::size_t PayloadSize>
+struct PoolBenchProcedure : public AsyncProcedure {
+    PoolBenchProcedure(const CommandResponsePtr& res) : AsyncProcedure(res, 0) { }
+
+    virtual ~PoolBenchProcedure() { }
+
+    virtual bool doStart() {
+        return false;
+    }
+
+    uint8_t payload[PayloadSize];
+};
+
+DECLARE_CMD(ProcedurePoolCommand) {
+    CMD_NAME("procedurePool")
+
+    CMD_HELP(
+        "Allocate and release asynchronous procedures in the procedure pool. "
+        "Each cycle fills the small class, spills a small procedure in the "
+        "large class then allocates a large and an oversized procedure; they "
+        "are released in a different order. Heap figures require "
+        "MBED_HEAP_STATS_ENABLED and are null otherwise. The command fails "
+        "if a procedure cannot be allocated, if the slots in use differ "
+        "after the cycles or if heap is leaked."
+    )
+
+    CMD_ARGS(
+        CMD_ARG("uint32_t", "iterations", "Number of cycles.")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("uint32_t", "iterations", "Number of cycles."),
+        CMD_RESULT("uint32_t", "total_us", "Time spent in the cycles."),
+        CMD_RESULT("JSON Array", "classes", "Statistics of each size class of the pool after the cycles."),
+        CMD_RESULT("uint32_t", "classes[x].slot_size", "Size of the slots of the class."),
+        CMD_RESULT("uint32_t", "classes[x].slot_count", "Number of slots of the class."),
+        CMD_RESULT("uint32_t", "classes[x].used", "Slots in use."),
+        CMD_RESULT("uint32_t", "classes[x].peak", "Greatest number of slots used at once."),
+        CMD_RESULT("uint32_t", "classes[x].exhausted", "Allocations which found all the slots of the class in use."),
+        CMD_RESULT("uint32_t", "oversized", "Procedures of the cycles allocated on the heap because they do not fit in any class."),
+        CMD_RESULT("uint32_t", "allocation_failures", "Procedures of the cycles which could not be allocated."),
+        CMD_RESULT("uint32_t", "leaked", "Heap still used once the cycles are over."),
+        CMD_RESULT("bool", "balanced", "True if the slots in use are the same before and after the cycles.")
+    )
+
+    CMD_HANDLER(uint32_t iterations, CommandResponsePtr& response) {
+        typedef PoolBenchProcedure<16> SmallProcedure;
+        typedef PoolBenchProcedure<PROCEDURE_POOL_LARGE_SLOT_SIZE / 2> LargeProcedure;
+        typedef PoolBenchProcedure<PROCEDURE_POOL_LARGE_SLOT_SIZE> OversizedProcedure;
+        static const std::size_t SMALL_COUNT = PROCEDURE_POOL_SMALL_SLOT_COUNT + 1;
+        static const std::size_t CLASS_COUNT = 2;
+
+        AsyncProcedure::PoolStatistics statistics;
+        std::size_t usedBefore[CLASS_COUNT] = { 0 };
+        for (std::size_t i = 0; i < CLASS_COUNT && AsyncProcedure::getPoolStatistics(i, statistics); ++i) {
+            usedBefore[i] = statistics.used;
+        }
+        uint32_t oversizedBefore = AsyncProcedure::oversizedProcedures();
+
+#if defined(BENCH_HEAP_STATS)
+        mbed_stats_heap_t start;
+        mbed_stats_heap_t end;
+        mbed_stats_heap_get(&start);
+#endif
+
+        uint32_t allocationFailures = 0;
+        mbed::Timer timer;
+        timer.start();
+        for (uint32_t i = 0; i < iterations; ++i) {
+            SmallProcedure* small[SMALL_COUNT];
+            for (std::size_t j = 0; j < SMALL_COUNT; ++j) {
+                small[j] = new SmallProcedure(response);
+                allocationFailures += small[j] ? 0 : 1;
+            }
+            LargeProcedure* large = new LargeProcedure(response);
+            allocationFailures += large ? 0 : 1;
+            OversizedProcedure* oversized = new OversizedProcedure(response);
+            allocationFailures += oversized ? 0 : 1;
+
+            // release the odd slots first so the free lists are reordered
+            for (std::size_t j = 1; j < SMALL_COUNT; j += 2) {
+                delete small[j];
+            }
+            delete large;
+            for (std::size_t j = 0; j < SMALL_COUNT; j += 2) {
+                delete small[j];
+            }
+            delete oversized;
+        }
+        timer.stop();
+
+        JSONOutputStream& os = response->getResultStream();
+        os << startObject <<
+            key("iterations") << iterations <<
+            key("total_us") << (uint32_t) timer.read_us() <<
+            key("classes") << startArray;
+
+        bool balanced = true;
+        for (std::size_t i = 0; AsyncProcedure::getPoolStatistics(i, statistics); ++i) {
+            if (i < CLASS_COUNT && statistics.used != usedBefore[i]) {
+                balanced = false;
+            }
+            os << startObject <<
+                key("slot_size") << (uint32_t) statistics.slotSize <<
+                key("slot_count") << (uint32_t) statistics.slotCount <<
+                key("used") << (uint32_t) statistics.used <<
+                key("peak") << (uint32_t) statistics.peak <<
+                key("exhausted") << statistics.exhausted <<
+            endObject;
+        }
+
+        os << endArray <<
+            key("oversized") << (uint32_t) (AsyncProcedure::oversizedProcedures() - oversizedBefore) <<
+            key("allocation_failures") << allocationFailures;
+        uint32_t leaked = 0;
+#if defined(BENCH_HEAP_STATS)
+        mbed_stats_heap_get(&end);
+        leaked = end.current_size - start.current_size;
+        os << key("leaked") << leaked;
+#else
+        os << key("leaked") << nil;
+#endif
+        os << key("balanced") << balanced << endObject;
+
+        if (allocationFailures || !balanced || leaked) {
+            response->faillure();
+        } else {
+            response->success();
+        }
+    }
+};
+
+} // end of annonymous namespace
+
+
+DECLARE_SUITE_COMMANDS(BenchCommandSuiteDescription,
+    CMD_INSTANCE(SerializationCommand),
+    CMD_INSTANCE(AdvertisingDataCommand),
+    CMD_INSTANCE(FromStringCommand),
+    CMD_INSTANCE(DispatchCommand),
+    CMD_INSTANCE(PriorityQueueCommand),
+    CMD_INSTANCE(EventQueueCommand),
+    CMD_INSTANCE(VirtualClockCommand),
+    CMD_INSTANCE(ServiceDeclarationCommand),
+    CMD_INSTANCE(ProcedurePoolCommand)
+)
@@ -0,0 +1,25 @@
+#ifndef BLE_CLIAPP_BENCH_COMMANDS_H_
+#define BLE_CLIAPP_BENCH_COMMANDS_H_
+
+#include "CLICommand/CommandSuite.h"
+
+class BenchCommandSuiteDescription {
+
+public:
+    static const char* name() {
+        return "bench";
+    }
+
+    static const char* info() {
+        return "Micro benchmarks of the application hot paths";
+    }
+
+    static const char* man() {
+        return "bench <command> <command arguments>.";
+    }
+
+    // see implementation
+    static ConstArray<const Command*> commands();
+};
+
+#endif //BLE_CLIAPP_BENCH_COMMANDS_H_
@@ -6,6 +6,7 @@
 #include "Serialization/GapAdvertisingDataSerializer.h"
 #include "Serialization/GapAdvertisingParamsSerializer.h"
 #include "Serialization/BLECommonSerializer.h"
+#include "Serialization/SecurityManagerSerialization.h"
 #include "CLICommand/CommandSuite.h"
 #include "CLICommand/util/AsyncProcedure.h"
 #include "Common.h"
@@ -20,6 +21,7 @@
 #include "GapCommands.h"
 #include "GapV1Commands.h"
 #include "GapV2Commands.h"
+#include "util/ConnectionTable.h"
 
 using mbed::util::SharedPointer;
 
@@ -438,6 +440,10 @@ DECLARE_CMD(ReadPhyCommand) {
         ) {
             serialization::JSONOutputStream& os = response->getResultStream();
 
+            if (status == BLE_ERROR_NONE) {
+                ConnectionTable::updatePhy(connectionHandle, txPhy, rxPhy);
+            }
+
             response->success();
 
             os << serialization::startObject <<
@@ -509,6 +515,68 @@ DECLARE_CMD(SetPreferedPhysCommand) {
     }
 };
 
+DECLARE_CMD(GetConnectionsCommand) {
+    CMD_NAME("connections")
+    CMD_HELP("Dump the table of the live connections of the device.")
+
+    CMD_RESULTS(
+        CMD_RESULT("JSON Array", "", "Array of the live connections"),
+        CMD_RESULT("uint16_t", "[i].handle", "Handle of the connection"),
+        CMD_RESULT("Gap::Role_t", "[i].role", "Role of the device in the connection"),
+        CMD_RESULT("LegacyAddresstype_t", "[i].peerAddrType", "The address type of the peer"),
+        CMD_RESULT("MacAddress_t", "[i].peerAddr", "The address of the peer"),
+        CMD_RESULT("uint16_t", "[i].interval", "Connection interval in 1.25ms units"),
+        CMD_RESULT("uint16_t", "[i].latency", "Slave latency"),
+        CMD_RESULT("uint16_t", "[i].supervisionTimeout", "Supervision timeout in 10ms units"),
+        CMD_RESULT("ble::phy_t", "[i].txPhy", "PHY used to transmit"),
+        CMD_RESULT("ble::phy_t", "[i].rxPhy", "PHY used to receive"),
+        CMD_RESULT("uint16_t", "[i].attMtu", "ATT MTU negotiated"),
+        CMD_RESULT("SecurityManager_link_encryption_t", "[i].encryption", "Encryption state of the link"),
+        CMD_RESULT("uint32_t", "[i].duration", "Time in ms since the connection has been established"),
+        CMD_RESULT("uint32_t", "[i].hvxReceived", "Notifications and indications received"),
+        CMD_RESULT("uint32_t", "[i].writesReceived", "Writes received by the local GattServer"),
+        CMD_RESULT("uint32_t", "[i].gattProcedures", "GATT client procedures started"),
+    )
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        using namespace serialization;
+
+        response->success();
+        JSONOutputStream& os = response->getResultStream();
+
+        os << startArray;
+        for (std::size_t i = 0; i < ConnectionTable::CAPACITY; ++i) {
+            const ConnectionTable::Entry& entry = ConnectionTable::at(i);
+            if (!entry.used) {
+                continue;
+            }
+
+            // the encryption state is owned by the security manager
+            ble::link_encryption_t encryption(ble::link_encryption_t::NOT_ENCRYPTED);
+            sm().getLinkEncryption(entry.handle, &encryption);
+
+            os << startObject <<
+                key("handle") << entry.handle <<
+                key("role") << toString(entry.role) <<
+                key("peerAddrType") << toString(entry.peerAddressType) <<
+                key("peerAddr") << macAddressToString(entry.peerAddress).str <<
+                key("interval") << entry.interval <<
+                key("latency") << entry.latency <<
+                key("supervisionTimeout") << entry.supervisionTimeout <<
+                key("txPhy") << toString((ble::phy_t::type) entry.txPhy) <<
+                key("rxPhy") << toString((ble::phy_t::type) entry.rxPhy) <<
+                key("attMtu") << entry.attMtu <<
+                key("encryption") << encryption <<
+                key("duration") << ConnectionTable::connectionDuration(entry) <<
+                key("hvxReceived") << entry.hvxReceived <<
+                key("writesReceived") << entry.writesReceived <<
+                key("gattProcedures") << entry.gattProcedures <<
+            endObject;
+        }
+        os << endArray;
+    }
+};
+
 bool use_version(uint8_t);
 
 DECLARE_CMD(UseVersion) {
@@ -547,6 +615,7 @@ static const Command* const _commonCommandHandlers[] = {
     CMD_INSTANCE(SetPhyCommand),
     CMD_INSTANCE(SetPreferedPhysCommand),
     CMD_INSTANCE(ReadPhyCommand),
+    CMD_INSTANCE(GetConnectionsCommand),
     CMD_INSTANCE(UseVersion)
 };
 
@@ -8,6 +8,8 @@
 #include "Serialization/BLECommonSerializer.h"
 #include "CLICommand/CommandSuite.h"
 #include "CLICommand/util/AsyncProcedure.h"
+#include "CLICommand/util/ResultStream.h"
+#include "CLICommand/CommandEventQueue.h"
 #include "Common.h"
 #include "CLICommand/CommandHelper.h"
 
@@ -23,6 +25,13 @@
 #include "parameters/ScanParameters.h"
 #include "parameters/ConnectionParameters.h"
 #include "Serialization/Hex.h"
+#include "util/RecordQueue.h"
+#include "util/BumpArena.h"
+#include "util/ConnectionTable.h"
+
+#include <new>
+#include <string.h>
+#include <algorithm>
 
 using mbed::util::SharedPointer;
 
@@ -35,262 +44,1938 @@ const ble::AdvertisingParameters &getAdvertisingParameters() {
     return AdvertisingParametersCommandSuiteDescription::get();
 }
 
-const ble::ScanParameters &getScanParameters() {
-    return ScanParametersCommandSuiteDescription::get();
-}
+const ble::ScanParameters &getScanParameters() {
+    return ScanParametersCommandSuiteDescription::get();
+}
+
+const ble::ConnectionParameters &getConnectionParameters() {
+    return ConnectionParametersCommandSuiteDescription::get();
+}
+
+/*
+ * Gap events are not serialized in the BLE stack callbacks: each event is
+ * copied into a compact record pushed into gapEventQueue, the records are
+ * serialized later from the CLI event queue by flushGapEvents, one frame per
+ * turn of the event queue. By default a frame is a single event object; if
+ * BLE_CLIAPP_GAP_EVENT_FRAME_MAX_COUNT is greater than 1, pending events are
+ * coalesced and every frame is a JSON array of up to that many events. Events
+ * which do not fit in the queue are dropped and reported by an events_dropped
+ * event. The queue is allocated with the first event and released when Gap is
+ * shut down.
+ */
+#ifndef BLE_CLIAPP_GAP_EVENT_QUEUE_SIZE
+static const std::size_t GAP_EVENT_QUEUE_SIZE = 2048;
+#else
+static const std::size_t GAP_EVENT_QUEUE_SIZE = BLE_CLIAPP_GAP_EVENT_QUEUE_SIZE;
+#endif
+
+#ifndef BLE_CLIAPP_GAP_EVENT_FRAME_MAX_COUNT
+static const std::size_t GAP_EVENT_FRAME_MAX_COUNT = 1;
+#else
+static const std::size_t GAP_EVENT_FRAME_MAX_COUNT = BLE_CLIAPP_GAP_EVENT_FRAME_MAX_COUNT;
+#endif
+
+typedef util::RecordQueue<GAP_EVENT_QUEUE_SIZE> GapEventQueue_t;
+
+GapEventQueue_t* gapEventQueue = NULL;
+uint32_t gapEventsDropped = 0;
+bool gapEventsFlushPending = false;
+bool gapEventsShutdownRegistered = false;
+
+enum GapEventType_t {
+    SCAN_REQUEST_RECEIVED_EVENT,
+    ADVERTISING_END_EVENT,
+    ADVERTISING_REPORT_EVENT,
+    SCAN_TIMEOUT_EVENT,
+    PERIODIC_ADVERTISING_SYNC_ESTABLISHED_EVENT,
+    PERIODIC_ADVERTISING_REPORT_EVENT,
+    PERIODIC_ADVERTISING_SYNC_LOSS_EVENT,
+    CONNECTION_COMPLETE_EVENT,
+    UPDATE_CONNECTION_PARAMETERS_REQUEST_EVENT,
+    CONNECTION_PARAMETERS_UPDATE_COMPLETE_EVENT,
+    DISCONNECTION_COMPLETE_EVENT,
+    READ_PHY_EVENT,
+    PHY_UPDATE_COMPLETE_EVENT,
+    GAP_EVENT_TYPE_COUNT
+};
+
+const char* const gapEventNames[GAP_EVENT_TYPE_COUNT] = {
+    "scan_request_received",
+    "advertising_end",
+    "advertising_report",
+    "scan_timeout",
+    "periodic_advertising_sync_established",
+    "periodic_advertising_report",
+    "periodic_advertising_sync_loss",
+    "connection_complete",
+    "update_connection_parameters_request",
+    "on_connection_parameters_update_complete",
+    "disconnection_complete",
+    "read_phy",
+    "phy_update_complete"
+};
+
+/*
+ * Events can be filtered per type before they are recorded: unsubscribed
+ * events are discarded, sampling forwards one event out of N and rate limiting
+ * caps the number of events forwarded per second.
+ */
+struct GapEventFilter {
+    uint16_t sampling;
+    uint16_t sampleCount;
+    uint16_t rateLimit;
+    uint16_t windowCount;
+    uint32_t windowStart;
+    uint32_t filtered;
+};
+
+static const uint32_t ALL_GAP_EVENTS = (1 << GAP_EVENT_TYPE_COUNT) - 1;
+
+uint32_t gapEventSubscriptions = ALL_GAP_EVENTS;
+GapEventFilter gapEventFilters[GAP_EVENT_TYPE_COUNT];
+mbed::Timer gapEventClock;
+
+/*
+ * Return true if the event type is subscribed, the event is accounted as
+ * filtered otherwise.
+ */
+bool isGapEventSubscribed(uint8_t type) {
+    if ((gapEventSubscriptions & (1 << type)) == 0) {
+        ++gapEventFilters[type].filtered;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Apply the sampling and the rate limit of the event type to an event
+ * subscribed.
+ */
+bool throttleGapEvent(uint8_t type) {
+    GapEventFilter& filter = gapEventFilters[type];
+
+    if (filter.sampling > 1) {
+        bool skip = filter.sampleCount != 0;
+        filter.sampleCount = (filter.sampleCount + 1) % filter.sampling;
+        if (skip) {
+            ++filter.filtered;
+            return false;
+        }
+    }
+
+    if (filter.rateLimit) {
+        uint32_t now = gapEventClock.read_ms();
+        if ((now - filter.windowStart) >= 1000) {
+            filter.windowStart = now;
+            filter.windowCount = 0;
+        }
+
+        if (filter.windowCount >= filter.rateLimit) {
+            ++filter.filtered;
+            return false;
+        }
+        ++filter.windowCount;
+    }
+
+    return true;
+}
+
+bool acceptGapEvent(uint8_t type) {
+    return isGapEventSubscribed(type) && throttleGapEvent(type);
+}
+
+/*
+ * Convert an event name into a mask of event types; the name all select every
+ * event type.
+ */
+bool gapEventMaskFromString(const char* str, uint32_t& mask) {
+    if (strcmp(str, "all") == 0) {
+        mask = ALL_GAP_EVENTS;
+        return true;
+    }
+
+    for (uint8_t type = 0; type < GAP_EVENT_TYPE_COUNT; ++type) {
+        if (strcmp(str, gapEventNames[type]) == 0) {
+            mask = 1 << type;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool gapEventMaskFromArgs(const CommandArgs& args, uint32_t& mask) {
+    mask = 0;
+    for (std::size_t i = 0; i < args.count(); ++i) {
+        uint32_t eventMask;
+        if (!gapEventMaskFromString(args[i], eventMask)) {
+            return false;
+        }
+        mask |= eventMask;
+    }
+    return true;
+}
+
+struct ScanRequestRecord {
+    static const uint8_t TYPE = SCAN_REQUEST_RECEIVED_EVENT;
+
+    ScanRequestRecord(const ble::ScanRequestEvent &event) :
+        peerAddress(event.getPeerAddress()),
+        peerAddressType(event.getPeerAddressType()),
+        advertisingHandle(event.getAdvHandle()) { }
+
+    void serialize(serialization::JSONOutputStream& os) const {
+        using namespace serialization;
+
+        os << startObject <<
+            key("type") << "event" <<
+            key("name") << "scan_request_received" <<
+            key("value") << startObject <<
+                key("peer_address") << peerAddress <<
+                key("peer_address_type") << peerAddressType <<
+                key("advertising_handle") << advertisingHandle <<
+            endObject <<
+        endObject;
+    }
+
+    ble::address_t peerAddress;
+    ble::peer_address_type_t peerAddressType;
+    ble::advertising_handle_t advertisingHandle;
+};
+
+struct AdvertisingEndRecord {
+    static const uint8_t TYPE = ADVERTISING_END_EVENT;
+
+    AdvertisingEndRecord(const ble::AdvertisingEndEvent &event) :
+        advertisingHandle(event.getAdvHandle()),
+        connectionHandle(event.getConnection()),
+        completedEvents(event.getCompleted_events()),
+        connected(event.isConnected()) { }
+
+    void serialize(serialization::JSONOutputStream& os) const {
+        using namespace serialization;
+
+        os << startObject <<
+            key("type") << "event" <<
+            key("name") << "advertising_end" <<
+            key("value") << startObject <<
+                key("advertising_handle") << advertisingHandle <<
+                key("completed_events") << completedEvents <<
+                key("is_connected") << connected;
+        if (connected) {
+            os <<
+                key("connection_handle") << connectionHandle;
+        }
+        os <<
+            endObject <<
+        endObject;
+    }
+
+    ble::advertising_handle_t advertisingHandle;
+    ble::connection_handle_t connectionHandle;
+    uint8_t completedEvents;
+    bool connected;
+};
+
+/*
+ * The payload of the report is stored right after the record. The payload and
+ * data status may differ from the event ones if the report has been
+ * reassembled from several fragments.
+ */
+struct AdvertisingReportRecord {
+    static const uint8_t TYPE = ADVERTISING_REPORT_EVENT;
+
+    AdvertisingReportRecord(
+        const ble::AdvertisingReportEvent &event,
+        mbed::Span<const uint8_t> reportPayload,
+        ble::advertising_data_status_t reportDataStatus
+    ) :
+        type(event.getType()),
+        dataStatus(reportDataStatus),
+        peerAddressType(event.getPeerAddressType()),
+        peerAddress(event.getPeerAddress()),
+        directAddressType(event.getDirectAddressType()),
+        directAddress(event.getDirectAddress()),
+        primaryPhy(event.getPrimaryPhy()),
+        secondaryPhy(event.getSecondaryPhy()),
+        periodicInterval(event.getPeriodicInterval()),
+        periodicIntervalPresent(event.isPeriodicIntervalPresent()),
+        sid(event.getSID()),
+        txPower(event.getTxPower()),
+        rssi(event.getRssi()),
+        payloadLength(reportPayload.size()) {
+        std::copy(
+            reportPayload.data(), reportPayload.data() + reportPayload.size(),
+            reinterpret_cast<uint8_t*>(this + 1)
+        );
+    }
+
+    mbed::Span<const uint8_t> payload() const {
+        return mbed::make_Span(reinterpret_cast<const uint8_t*>(this + 1), payloadLength);
+    }
+
+    void serialize(serialization::JSONOutputStream& os) const {
+        using namespace serialization;
+
+        os << startObject <<
+            key("type") << "event" <<
+            key("name") << "advertising_report" <<
+            key("value") << startObject <<
+                key("connectable") << type.connectable() <<
+                key("scannable") << type.scannable_advertising() <<
+                key("scan_response") << type.scan_response() <<
+                key("directed") << type.directed_advertising() <<
+                key("legacy") << type.legacy_advertising() <<
+                key("rssi") << rssi <<
+                key("peer_address_type") << peerAddressType;
+
+        if (peerAddressType != ble::peer_address_type_t::ANONYMOUS) {
+            os << key("peer_address") << peerAddress;
+        }
+
+        if (type.directed_advertising()) {
+            os << key("direct_address_type") << directAddressType <<
+                  key("direct_address") << directAddress;
+        }
+
+        if (type.legacy_advertising() == false) {
+            os << key("sid") << sid <<
+                  key("tx_power") << txPower <<
+                  key("primary_phy") << primaryPhy <<
+                  key("secondary_phy") << secondaryPhy <<
+                  key("data_status");
+
+            switch (dataStatus.value()) {
+                case ble::advertising_data_status_t::COMPLETE:
+                    os << "COMPLETE";
+                    break;
+                case ble::advertising_data_status_t::INCOMPLETE_MORE_DATA:
+                    os << "INCOMPLETE_MORE_DATA";
+                    break;
+                case ble::advertising_data_status_t::INCOMPLETE_DATA_TRUNCATED:
+                    os << "INCOMPLETE_DATA_TRUNCATED";
+                    break;
+                default:
+                    os << "unknown";
+                    break;
+            }
+
+            if (periodicIntervalPresent) {
+                os << key("periodic_interval") << periodicInterval;
+            }
+        }
+
+        os <<   key("payload") << payload() <<
+            endObject <<
+        endObject;
+    }
+
+    ble::advertising_event_t type;
+    ble::advertising_data_status_t dataStatus;
+    ble::peer_address_type_t peerAddressType;
+    ble::address_t peerAddress;
+    ble::peer_address_type_t directAddressType;
+    ble::address_t directAddress;
+    ble::phy_t primaryPhy;
+    ble::phy_t secondaryPhy;
+    ble::periodic_interval_t periodicInterval;
+    bool periodicIntervalPresent;
+    ble::advertising_sid_t sid;
+    ble::advertising_power_t txPower;
+    ble::rssi_t rssi;
+    uint16_t payloadLength;
+};
+
+struct ScanTimeoutRecord {
+    static const uint8_t TYPE = SCAN_TIMEOUT_EVENT;
+
+    ScanTimeoutRecord(const ble::ScanTimeoutEvent &) { }
+
+    void serialize(serialization::JSONOutputStream& os) const {
+        using namespace serialization;
+
+        os << startObject <<
+            key("type") << "event" <<
+            key("name") << "scan_timeout" <<
+        endObject;
+    }
+};
+
+struct PeriodicAdvertisingSyncEstablishedRecord {
+    static const uint8_t TYPE = PERIODIC_ADVERTISING_SYNC_ESTABLISHED_EVENT;
+
+    PeriodicAdvertisingSyncEstablishedRecord(
+        const ble::PeriodicAdvertisingSyncEstablishedEvent &event
+    ) :
+        status(event.getStatus()),
+        peerAddressType(event.getPeerAddressType()),
+        peerAddress(event.getPeerAddress()),
+        syncHandle(event.getSyncHandle()),
+        advertisingInterval(event.getAdvertisingInterval()),
+        peerPhy(event.getPeerPhy()),
+        sid(event.getSid()),
+        peerClockAccuracy(event.getPeerClockAccuracy()) { }
+
+    void serialize(serialization::JSONOutputStream& os) const {
+        using namespace serialization;
+
+        os << startObject <<
+            key("type") << "event" <<
+            key("name") << "periodic_advertising_sync_established" <<
+            key("value") << startObject <<
+                key("status") << status;
+
+        if (status == BLE_ERROR_NONE) {
+            os <<
+                key("peer_address_type") << peerAddressType <<
+                key("peer_address") << peerAddress <<
+                key("sync_handle") << syncHandle <<
+                key("advertising_interval") << advertisingInterval <<
+                key("peer_phy") << peerPhy <<
+                key("sid") << sid <<
+                key("peer_clock_accuracy") << peerClockAccuracy.get_ppm();
+        }
+
+        os <<
+            endObject <<
+        endObject;
+    }
+
+    ble_error_t status;
+    ble::peer_address_type_t peerAddressType;
+    ble::address_t peerAddress;
+    ble::periodic_sync_handle_t syncHandle;
+    ble::periodic_interval_t advertisingInterval;
+    ble::phy_t peerPhy;
+    ble::advertising_sid_t sid;
+    ble::clock_accuracy_t peerClockAccuracy;
+};
+
+/*
+ * The payload of the report is stored right after the record.
+ */
+struct PeriodicAdvertisingReportRecord {
+    static const uint8_t TYPE = PERIODIC_ADVERTISING_REPORT_EVENT;
+
+    PeriodicAdvertisingReportRecord(const ble::PeriodicAdvertisingReportEvent &event) :
+        syncHandle(event.getSyncHandle()),
+        dataStatus(event.getDataStatus()),
+        txPower(event.getTxPower()),
+        rssi(event.getRssi()),
+        payloadLength(event.getPayload().size()) { }
+
+    mbed::Span<const uint8_t> payload() const {
+        return mbed::make_Span(reinterpret_cast<const uint8_t*>(this + 1), payloadLength);
+    }
+
+    void serialize(serialization::JSONOutputStream& os) const {
+        using namespace serialization;
+
+        os << startObject <<
+            key("type") << "event" <<
+            key("name") << "periodic_advertising_report" <<
+            key("value") << startObject <<
+                key("sync_handle") << syncHandle <<
+                key("rssi") << rssi <<
+                key("tx_power") << txPower <<
+                key("data_status") << dataStatus <<
+                key("data") << payload() <<
+            endObject <<
+        endObject;
+    }
+
+    ble::periodic_sync_handle_t syncHandle;
+    ble::advertising_data_status_t dataStatus;
+    ble::advertising_power_t txPower;
+    ble::rssi_t rssi;
+    uint16_t payloadLength;
+};
+
+struct PeriodicAdvertisingSyncLossRecord {
+    static const uint8_t TYPE = PERIODIC_ADVERTISING_SYNC_LOSS_EVENT;
+
+    PeriodicAdvertisingSyncLossRecord(const ble::PeriodicAdvertisingSyncLoss &event) :
+        syncHandle(event.getSyncHandle()) { }
+
+    void serialize(serialization::JSONOutputStream& os) const {
+        using namespace serialization;
+
+        os << startObject <<
+            key("type") << "event" <<
+            key("name") << "periodic_advertising_sync_loss" <<
+            key("value") << startObject <<
+                key("sync_handle") << syncHandle <<
+            endObject <<
+        endObject;
+    }
+
+    ble::periodic_sync_handle_t syncHandle;
+};
+
+struct ConnectionCompleteRecord {
+    static const uint8_t TYPE = CONNECTION_COMPLETE_EVENT;
+
+    ConnectionCompleteRecord(const ble::ConnectionCompleteEvent &event) :
+        status(event.getStatus()),
+        peerAddressType(event.getPeerAddressType()),
+        peerAddress(event.getPeerAddress()),
+        peerResolvablePrivateAddress(event.getPeerResolvablePrivateAddress()),
+        localResolvablePrivateAddress(event.getLocalResolvablePrivateAddress()),
+        interval(event.getConnectionInterval()),
+        latency(event.getConnectionLatency()),
+        supervisionTimeout(event.getSupervisionTimeout()),
+        connectionHandle(event.getConnectionHandle()),
+        ownRole(event.getOwnRole()),
+        masterClockAccuracy(event.getMasterClockAccuracy()) { }
+
+    void serialize(serialization::JSONOutputStream& os) const {
+        using namespace serialization;
+
+        os << startObject <<
+            key("type") << "event" <<
+            key("name") << "connection_complete" <<
+            key("value") << startObject <<
+                key("status") << status;
+
+        if (status != BLE_ERROR_NONE) {
+            os << endObject << endObject;
+            return;
+        }
+
+        os <<   key("peer_address_type") << peerAddressType <<
+                key("peer_address") << peerAddress <<
+                key("interval") << interval <<
+                key("latency") << latency.value() <<
+                key("supervision_timeout") << supervisionTimeout <<
+                key("connection_handle") << connectionHandle <<
+                key("own_role") << (ownRole == ble::connection_role_t::CENTRAL ? "CENTRAL" : "PERIPHERAL") <<
+                key("master_clock_accuracy") << masterClockAccuracy;
+
+        if (peerResolvablePrivateAddress != ble::address_t()) {
+            os << key("peer_resolvable_private_address") << peerResolvablePrivateAddress;
+        }
+
+        if (localResolvablePrivateAddress != ble::address_t()) {
+            os << key("local_resolvable_private_address") << localResolvablePrivateAddress;
+        }
+
+        os << endObject <<
+        endObject;
+    }
+
+    ble_error_t status;
+    ble::peer_address_type_t peerAddressType;
+    ble::address_t peerAddress;
+    ble::address_t peerResolvablePrivateAddress;
+    ble::address_t localResolvablePrivateAddress;
+    ble::conn_interval_t interval;
+    ble::slave_latency_t latency;
+    ble::supervision_timeout_t supervisionTimeout;
+    ble::connection_handle_t connectionHandle;
+    ble::connection_role_t ownRole;
+    uint16_t masterClockAccuracy;
+};
+
+struct UpdateConnectionParametersRequestRecord {
+    static const uint8_t TYPE = UPDATE_CONNECTION_PARAMETERS_REQUEST_EVENT;
+
+    UpdateConnectionParametersRequestRecord(
+        const ble::UpdateConnectionParametersRequestEvent &event
+    ) :
+        connectionHandle(event.getConnectionHandle()),
+        minConnectionInterval(event.getMinConnectionInterval()),
+        maxConnectionInterval(event.getMaxConnectionInterval()),
+        slaveLatency(event.getSlaveLatency()),
+        supervisionTimeout(event.getSupervisionTimeout()) { }
+
+    void serialize(serialization::JSONOutputStream& os) const {
+        using namespace serialization;
+
+        os << startObject <<
+            key("type") << "event" <<
+            key("name") << "update_connection_parameters_request" <<
+            key("value") << startObject <<
+                key("connection_handle") << connectionHandle <<
+                key("min_connection_interval") << minConnectionInterval <<
+                key("max_connection_interval") << maxConnectionInterval <<
+                key("slave_latency") << slaveLatency.value() <<
+                key("supervision_timeout") << supervisionTimeout <<
+            endObject <<
+        endObject;
+    }
+
+    ble::connection_handle_t connectionHandle;
+    ble::conn_interval_t minConnectionInterval;
+    ble::conn_interval_t maxConnectionInterval;
+    ble::slave_latency_t slaveLatency;
+    ble::supervision_timeout_t supervisionTimeout;
+};
+
+struct ConnectionParametersUpdateCompleteRecord {
+    static const uint8_t TYPE = CONNECTION_PARAMETERS_UPDATE_COMPLETE_EVENT;
+
+    ConnectionParametersUpdateCompleteRecord(
+        const ble::ConnectionParametersUpdateCompleteEvent &event
+    ) :
+        status(event.getStatus()),
+        connectionHandle(event.getConnectionHandle()),
+        connectionInterval(event.getConnectionInterval()),
+        slaveLatency(event.getSlaveLatency()),
+        supervisionTimeout(event.getSupervisionTimeout()) { }
+
+    void serialize(serialization::JSONOutputStream& os) const {
+        using namespace serialization;
+
+        os << startObject <<
+            key("type") << "event" <<
+            key("name") << "on_connection_parameters_update_complete" <<
+            key("value") << startObject <<
+                key("connection_handle") << connectionHandle <<
+                key("status") << status;
+
+        if (status == BLE_ERROR_NONE) {
+            os <<
+                key("connection_interval") << connectionInterval <<
+                key("slave_latency") << slaveLatency.value() <<
+                key("supervision_timeout") << supervisionTimeout;
+        }
+
+        os <<
+            endObject <<
+        endObject;
+    }
+
+    ble_error_t status;
+    ble::connection_handle_t connectionHandle;
+    ble::conn_interval_t connectionInterval;
+    ble::slave_latency_t slaveLatency;
+    ble::supervision_timeout_t supervisionTimeout;
+};
+
+struct DisconnectionCompleteRecord {
+    static const uint8_t TYPE = DISCONNECTION_COMPLETE_EVENT;
+
+    DisconnectionCompleteRecord(const ble::DisconnectionCompleteEvent &event) :
+        connectionHandle(event.getConnectionHandle()),
+        reason(event.getReason()) { }
+
+    void serialize(serialization::JSONOutputStream& os) const {
+        using namespace serialization;
+
+        os << startObject <<
+            key("type") << "event" <<
+            key("name") << "disconnection_complete" <<
+            key("value") << startObject <<
+                key("connection_handle") << connectionHandle <<
+                key("reason") << reason <<
+            endObject <<
+        endObject;
+    }
+
+    ble::connection_handle_t connectionHandle;
+    ble::disconnection_reason_t reason;
+};
+
+/*
+ * Record shared by the read_phy and phy_update_complete events.
+ */
+struct PhyRecord {
+    PhyRecord(
+        const char* eventName,
+        ble_error_t eventStatus,
+        ble::connection_handle_t eventConnectionHandle,
+        ble::phy_t eventTxPhy,
+        ble::phy_t eventRxPhy
+    ) :
+        name(eventName),
+        status(eventStatus),
+        connectionHandle(eventConnectionHandle),
+        txPhy(eventTxPhy),
+        rxPhy(eventRxPhy) { }
+
+    void serialize(serialization::JSONOutputStream& os) const {
+        using namespace serialization;
+
+        os << startObject <<
+            key("type") << "event" <<
+            key("name") << name <<
+            key("value") << startObject <<
+                key("connection_handle") << connectionHandle <<
+                key("status") << status;
+        if (status == BLE_ERROR_NONE) {
+            os <<
+                key("tx_phy") << txPhy <<
+                key("rx_phy") << rxPhy;
+        }
+        os <<
+            endObject <<
+        endObject;
+    }
+
+    const char* name;
+    ble_error_t status;
+    ble::connection_handle_t connectionHandle;
+    ble::phy_t txPhy;
+    ble::phy_t rxPhy;
+};
+
+void serializeGapEventsDropped(serialization::JSONOutputStream& os) {
+    using namespace serialization;
+
+    os << startObject <<
+        key("type") << "event" <<
+        key("name") << "events_dropped" <<
+        key("value") << startObject <<
+            key("count") << gapEventsDropped <<
+        endObject <<
+    endObject;
+
+    gapEventsDropped = 0;
+}
+
+void serializeGapEventRecord(serialization::JSONOutputStream& os, uint8_t type, const void* record) {
+    switch (type) {
+        case ScanRequestRecord::TYPE:
+            static_cast<const ScanRequestRecord*>(record)->serialize(os);
+            break;
+        case AdvertisingEndRecord::TYPE:
+            static_cast<const AdvertisingEndRecord*>(record)->serialize(os);
+            break;
+        case AdvertisingReportRecord::TYPE:
+            static_cast<const AdvertisingReportRecord*>(record)->serialize(os);
+            break;
+        case ScanTimeoutRecord::TYPE:
+            static_cast<const ScanTimeoutRecord*>(record)->serialize(os);
+            break;
+        case PeriodicAdvertisingSyncEstablishedRecord::TYPE:
+            static_cast<const PeriodicAdvertisingSyncEstablishedRecord*>(record)->serialize(os);
+            break;
+        case PeriodicAdvertisingReportRecord::TYPE:
+            static_cast<const PeriodicAdvertisingReportRecord*>(record)->serialize(os);
+            break;
+        case PeriodicAdvertisingSyncLossRecord::TYPE:
+            static_cast<const PeriodicAdvertisingSyncLossRecord*>(record)->serialize(os);
+            break;
+        case ConnectionCompleteRecord::TYPE:
+            static_cast<const ConnectionCompleteRecord*>(record)->serialize(os);
+            break;
+        case UpdateConnectionParametersRequestRecord::TYPE:
+            static_cast<const UpdateConnectionParametersRequestRecord*>(record)->serialize(os);
+            break;
+        case ConnectionParametersUpdateCompleteRecord::TYPE:
+            static_cast<const ConnectionParametersUpdateCompleteRecord*>(record)->serialize(os);
+            break;
+        case DisconnectionCompleteRecord::TYPE:
+            static_cast<const DisconnectionCompleteRecord*>(record)->serialize(os);
+            break;
+        case READ_PHY_EVENT:
+        case PHY_UPDATE_COMPLETE_EVENT:
+            static_cast<const PhyRecord*>(record)->serialize(os);
+            break;
+        default:
+            break;
+    }
+}
+
+void scheduleGapEventsFlush();
+
+/*
+ * Serialize the next frame of pending events then post the flush again if
+ * events remain; other tasks of the event queue run between two frames. A
+ * frame is a single event object or, when events are coalesced, an array of at
+ * most GAP_EVENT_FRAME_MAX_COUNT events. Events are not written while a result
+ * is streamed.
+ */
+void flushGapEvents() {
+    using namespace serialization;
+
+    gapEventsFlushPending = false;
+
+    // a result streamed since the flush has been posted; the events remain
+    // queued until it completes.
+    if (resultStreamActive()) {
+        scheduleGapEventsFlush();
+        return;
+    }
+
+    std::size_t pendingCount = gapEventQueue ? gapEventQueue->size() : 0;
+    if (!pendingCount && !gapEventsDropped) {
+        return;
+    }
+
+    const bool coalesced = GAP_EVENT_FRAME_MAX_COUNT > 1;
+    std::size_t frameCount = std::min(pendingCount, GAP_EVENT_FRAME_MAX_COUNT);
+    // events are dropped when the queue is full, the drop is reported after
+    // the events queued before it, in the last frame if it has room left.
+    bool frameDropped = gapEventsDropped &&
+        (frameCount == pendingCount) && (frameCount < GAP_EVENT_FRAME_MAX_COUNT);
+
+    {
+        JSONEventStream os;
+        if (coalesced) {
+            os << startArray;
+        }
+
+        for (std::size_t i = 0; i < frameCount; ++i) {
+            uint8_t type;
+            std::size_t size;
+            const void* record = gapEventQueue->front(type, size);
+            serializeGapEventRecord(os, type, record);
+            gapEventQueue->pop();
+        }
+
+        if (frameDropped) {
+            serializeGapEventsDropped(os);
+        }
+
+        if (coalesced) {
+            os << endArray;
+        }
+    }
+
+    if ((gapEventQueue && !gapEventQueue->empty()) || gapEventsDropped) {
+        scheduleGapEventsFlush();
+    }
+}
+
+void scheduleGapEventsFlush() {
+    if (gapEventsFlushPending) {
+        return;
+    }
+    gapEventsFlushPending = postAfterResultStreams(flushGapEvents);
+}
+
+/*
+ * Release the queue of events when Gap is shut down, events still pending are
+ * discarded.
+ */
+void whenGapEventsShutdown(const Gap *) {
+    delete gapEventQueue;
+    gapEventQueue = NULL;
+    gapEventsDropped = 0;
+
+    gap().onShutdown().detach(whenGapEventsShutdown);
+    gapEventsShutdownRegistered = false;
+}
+
+/*
+ * Reserve memory for an event record; the event is accounted as dropped if
+ * the queue is full.
+ */
+void* reserveGapEvent(uint8_t type, std::size_t size) {
+    if (gapEventQueue == NULL) {
+        gapEventQueue = new GapEventQueue_t();
+        if (gapEventsShutdownRegistered == false) {
+            gap().onShutdown(whenGapEventsShutdown);
+            gapEventsShutdownRegistered = true;
+        }
+    }
+
+    void* memory = gapEventQueue->reserve(type, size);
+    if (memory == NULL) {
+        ++gapEventsDropped;
+        scheduleGapEventsFlush();
+    }
+    return memory;
+}
+
+void commitGapEvent() {
+    gapEventQueue->commit();
+    scheduleGapEventsFlush();
+}
+
+template<typename Record, typename Event>
+void pushGapEvent(
+    const Event& event,
+    mbed::Span<const uint8_t> payload = mbed::Span<const uint8_t>()
+) {
+    if (!acceptGapEvent(Record::TYPE)) {
+        return;
+    }
+
+    void* memory = reserveGapEvent(Record::TYPE, sizeof(Record) + payload.size());
+    if (memory == NULL) {
+        return;
+    }
+
+    Record* record = new (memory) Record(event);
+    std::copy(
+        payload.data(), payload.data() + payload.size(),
+        reinterpret_cast<uint8_t*>(record + 1)
+    );
+    commitGapEvent();
+}
+
+void pushPhyEvent(
+    GapEventType_t type,
+    ble_error_t status,
+    ble::connection_handle_t connectionHandle,
+    ble::phy_t txPhy,
+    ble::phy_t rxPhy
+) {
+    if (!acceptGapEvent(type)) {
+        return;
+    }
+
+    void* memory = reserveGapEvent(type, sizeof(PhyRecord));
+    if (memory == NULL) {
+        return;
+    }
+
+    new (memory) PhyRecord(gapEventNames[type], status, connectionHandle, txPhy, rxPhy);
+    commitGapEvent();
+}
+
+/*
+ * Advertising reports can be filtered on the host before being recorded:
+ * - Fragments of extended advertising reports (data status
+ *   INCOMPLETE_MORE_DATA) are accumulated per advertiser and SID then reported
+ *   as a single event once the last fragment is received.
+ * - Reports carrying the same payload from the same advertiser and SID are
+ *   reported at most once per deduplication window. The cache keeps the most
+ *   recently reported advertisers.
+ * Both filters are disabled by default.
+ */
+#ifndef BLE_CLIAPP_GAP_ADVERTISING_DEDUPLICATION_ENTRY_COUNT
+static const std::size_t ADVERTISING_DEDUPLICATION_ENTRY_COUNT = 16;
+#else
+static const std::size_t ADVERTISING_DEDUPLICATION_ENTRY_COUNT = BLE_CLIAPP_GAP_ADVERTISING_DEDUPLICATION_ENTRY_COUNT;
+#endif
+
+#ifndef BLE_CLIAPP_GAP_ADVERTISING_REASSEMBLY_SLOT_COUNT
+static const std::size_t ADVERTISING_REASSEMBLY_SLOT_COUNT = 2;
+#else
+static const std::size_t ADVERTISING_REASSEMBLY_SLOT_COUNT = BLE_CLIAPP_GAP_ADVERTISING_REASSEMBLY_SLOT_COUNT;
+#endif
+
+#ifndef BLE_CLIAPP_GAP_ADVERTISING_REASSEMBLY_SIZE
+static const std::size_t ADVERTISING_REASSEMBLY_SIZE = 1650;
+#else
+static const std::size_t ADVERTISING_REASSEMBLY_SIZE = BLE_CLIAPP_GAP_ADVERTISING_REASSEMBLY_SIZE;
+#endif
+
+struct AdvertiserKey {
+    bool matches(const AdvertiserKey& other) const {
+        return addressType == other.addressType &&
+            sid == other.sid &&
+            address == other.address;
+    }
+
+    ble::address_t address;
+    uint8_t addressType;
+    uint8_t sid;
+};
+
+struct AdvertisingDeduplicationEntry {
+    AdvertiserKey advertiser;
+    uint32_t payloadHash;
+    uint32_t lastReport;
+    bool used;
+};
+
+/*
+ * A slot also tracks the reports of event types unsubscribed so their
+ * remaining fragments are discarded without being accumulated.
+ */
+struct AdvertisingReassemblySlot {
+    AdvertiserKey advertiser;
+    uint32_t lastUpdate;
+    uint16_t length;
+    bool truncated;
+    bool discarded;
+    bool used;
+};
+
+struct AdvertisingReportFilters {
+    uint32_t deduplicationWindow;
+    uint32_t duplicates;
+    uint32_t reassembled;
+    uint32_t reassemblyFailures;
+    uint32_t oversized;
+    uint8_t* reassemblyBuffer;
+    AdvertisingDeduplicationEntry entries[ADVERTISING_DEDUPLICATION_ENTRY_COUNT];
+    AdvertisingReassemblySlot slots[ADVERTISING_REASSEMBLY_SLOT_COUNT];
+};
+
+AdvertisingReportFilters advertisingReportFilters;
+
+uint32_t hashAdvertisingPayload(mbed::Span<const uint8_t> payload) {
+    // FNV-1a
+    uint32_t hash = 2166136261UL;
+    for (std::size_t i = 0; i < payload.size(); ++i) {
+        hash ^= payload.data()[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+/*
+ * Return true if the report has already been reported during the
+ * deduplication window; otherwise the report is registered in the cache.
+ */
+bool isDuplicateAdvertisingReport(const AdvertiserKey& advertiser, mbed::Span<const uint8_t> payload) {
+    AdvertisingReportFilters& filters = advertisingReportFilters;
+    uint32_t hash = hashAdvertisingPayload(payload);
+    uint32_t now = gapEventClock.read_ms();
+    AdvertisingDeduplicationEntry* victim = &filters.entries[0];
+
+    for (std::size_t i = 0; i < ADVERTISING_DEDUPLICATION_ENTRY_COUNT; ++i) {
+        AdvertisingDeduplicationEntry& entry = filters.entries[i];
+        if (!entry.used) {
+            if (victim->used) {
+                victim = &entry;
+            }
+            continue;
+        }
+
+        if (entry.payloadHash == hash && entry.advertiser.matches(advertiser)) {
+            if ((now - entry.lastReport) < filters.deduplicationWindow) {
+                ++filters.duplicates;
+                return true;
+            }
+            entry.lastReport = now;
+            return false;
+        }
+
+        if (victim->used && (now - entry.lastReport) > (now - victim->lastReport)) {
+            victim = &entry;
+        }
+    }
+
+    victim->advertiser = advertiser;
+    victim->payloadHash = hash;
+    victim->lastReport = now;
+    victim->used = true;
+    return false;
+}
+
+uint8_t* reassemblyBuffer(const AdvertisingReassemblySlot& slot) {
+    AdvertisingReportFilters& filters = advertisingReportFilters;
+    return filters.reassemblyBuffer + ((&slot - filters.slots) * ADVERTISING_REASSEMBLY_SIZE);
+}
+
+AdvertisingReassemblySlot* findReassemblySlot(const AdvertiserKey& advertiser) {
+    AdvertisingReportFilters& filters = advertisingReportFilters;
+    for (std::size_t i = 0; i < ADVERTISING_REASSEMBLY_SLOT_COUNT; ++i) {
+        if (filters.slots[i].used && filters.slots[i].advertiser.matches(advertiser)) {
+            return &filters.slots[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Return a free slot; if all the slots are in use, the least recently updated
+ * one is reclaimed and its fragments are lost.
+ */
+AdvertisingReassemblySlot* acquireReassemblySlot(const AdvertiserKey& advertiser) {
+    AdvertisingReportFilters& filters = advertisingReportFilters;
+    uint32_t now = gapEventClock.read_ms();
+    AdvertisingReassemblySlot* slot = &filters.slots[0];
+
+    for (std::size_t i = 0; i < ADVERTISING_REASSEMBLY_SLOT_COUNT; ++i) {
+        if (!filters.slots[i].used) {
+            slot = &filters.slots[i];
+            break;
+        }
+
+        if ((now - filters.slots[i].lastUpdate) > (now - slot->lastUpdate)) {
+            slot = &filters.slots[i];
+        }
+    }
+
+    if (slot->used && !slot->discarded) {
+        ++filters.reassemblyFailures;
+    }
+
+    slot->advertiser = advertiser;
+    slot->length = 0;
+    slot->truncated = false;
+    slot->discarded = false;
+    slot->used = true;
+    return slot;
+}
+
+void appendReassemblyFragment(AdvertisingReassemblySlot& slot, mbed::Span<const uint8_t> fragment) {
+    std::size_t length = fragment.size();
+    if ((slot.length + length) > ADVERTISING_REASSEMBLY_SIZE) {
+        length = ADVERTISING_REASSEMBLY_SIZE - slot.length;
+        slot.truncated = true;
+    }
+
+    std::copy(fragment.data(), fragment.data() + length, reassemblyBuffer(slot) + slot.length);
+    slot.length += length;
+    slot.lastUpdate = gapEventClock.read_ms();
+}
+
+/*
+ * Largest payload an advertising report record can carry in the event queue.
+ */
+std::size_t maxAdvertisingReportPayloadSize() {
+    return GapEventQueue_t::maxRecordSize() - sizeof(AdvertisingReportRecord);
+}
+
+void pushAdvertisingReport(const ble::AdvertisingReportEvent &event) {
+    AdvertisingReportFilters& filters = advertisingReportFilters;
+    mbed::Span<const uint8_t> payload = event.getPayload();
+    ble::advertising_data_status_t dataStatus = event.getType().data_status();
+    bool reassembly = filters.reassemblyBuffer && !event.getType().legacy_advertising();
+    AdvertisingReassemblySlot* slot = NULL;
+
+    AdvertiserKey advertiser;
+    advertiser.address = event.getPeerAddress();
+    advertiser.addressType = event.getPeerAddressType().value();
+    advertiser.sid = event.getSID();
+
+    if (reassembly) {
+        slot = findReassemblySlot(advertiser);
+    }
+
+    // the subscription applies to the first fragment of a report, the
+    // following fragments share its fate. Sampling and rate limiting apply to
+    // the complete report once it survived the deduplication.
+    bool accepted = slot ? !slot->discarded : isGapEventSubscribed(AdvertisingReportRecord::TYPE);
+
+    if (reassembly) {
+        if (dataStatus == ble::advertising_data_status_t::INCOMPLETE_MORE_DATA) {
+            if (slot == NULL) {
+                slot = acquireReassemblySlot(advertiser);
+                slot->discarded = !accepted;
+            }
+            if (accepted) {
+                appendReassemblyFragment(*slot, payload);
+            }
+            return;
+        }
+
+        if (slot) {
+            slot->used = false;
+            if (!accepted) {
+                return;
+            }
+            appendReassemblyFragment(*slot, payload);
+            payload = mbed::make_Span(reassemblyBuffer(*slot), slot->length);
+            if (slot->truncated) {
+                dataStatus = ble::advertising_data_status_t::INCOMPLETE_DATA_TRUNCATED;
+            }
+            ++filters.reassembled;
+        }
+    }
+
+    if (!accepted) {
+        return;
+    }
+
+    if (filters.deduplicationWindow && isDuplicateAdvertisingReport(advertiser, payload)) {
+        return;
+    }
+
+    if (!throttleGapEvent(AdvertisingReportRecord::TYPE)) {
+        return;
+    }
+
+    if (payload.size() > maxAdvertisingReportPayloadSize()) {
+        ++filters.oversized;
+        ++gapEventsDropped;
+        scheduleGapEventsFlush();
+        return;
+    }
+
+    void* memory = reserveGapEvent(
+        AdvertisingReportRecord::TYPE,
+        sizeof(AdvertisingReportRecord) + payload.size()
+    );
+    if (memory == NULL) {
+        return;
+    }
+
+    new (memory) AdvertisingReportRecord(event, payload, dataStatus);
+    commitGapEvent();
+}
+
+/*
+ * Periodic advertising sync manager.
+ *
+ * Syncs registered with addPeriodicSync are kept in a fixed table. The
+ * controller accepts a single pending sync creation at a time, the manager
+ * creates the syncs one after the other. When a sync is lost, or its creation
+ * fails, it is created again after PERIODIC_SYNC_RETRY_DELAY ms. Reports
+ * received on managed syncs are accounted in the statistics of the sync.
+ *
+ * A sync removed while it is being created stays in the table, in the
+ * CANCELING state, until the controller reports the end of the creation.
+ * Creations started by the createSync commands are not managed: the manager
+ * does not start a creation while one of them is pending and does not claim
+ * the sync established event which ends it.
+ */
+#ifndef BLE_CLIAPP_GAP_PERIODIC_SYNC_COUNT
+static const std::size_t PERIODIC_SYNC_COUNT = 4;
+#else
+static const std::size_t PERIODIC_SYNC_COUNT = BLE_CLIAPP_GAP_PERIODIC_SYNC_COUNT;
+#endif
+
+#ifndef BLE_CLIAPP_GAP_PERIODIC_SYNC_RETRY_DELAY
+static const uint32_t PERIODIC_SYNC_RETRY_DELAY = 100;
+#else
+static const uint32_t PERIODIC_SYNC_RETRY_DELAY = BLE_CLIAPP_GAP_PERIODIC_SYNC_RETRY_DELAY;
+#endif
+
+static const std::size_t NO_PERIODIC_SYNC = PERIODIC_SYNC_COUNT;
+
+enum PeriodicSyncState_t {
+    PERIODIC_SYNC_FREE,
+    PERIODIC_SYNC_WAITING,
+    PERIODIC_SYNC_CREATING,
+    PERIODIC_SYNC_CANCELING,
+    PERIODIC_SYNC_SYNCED
+};
+
+struct PeriodicSync {
+    PeriodicSyncState_t state;
+    ble::peer_address_type_t::type peerAddressType;
+    ble::address_t peerAddress;
+    ble::advertising_sid_t sid;
+    uint16_t maxPacketSkip;
+    uint16_t timeout;
+    ble::periodic_sync_handle_t syncHandle;
+    // advertising interval, in units of 1.25 ms
+    uint16_t interval;
+    uint32_t lastReport;
+    bool lastReportIncomplete;
+    uint32_t reports;
+    uint32_t bytes;
+    uint32_t missedEvents;
+    uint32_t losses;
+    uint32_t establishments;
+    uint32_t rssiCount;
+    int32_t rssiSum;
+    ble::rssi_t rssiMin;
+    ble::rssi_t rssiMax;
+    ble::rssi_t rssiLast;
+    ble_error_t lastError;
+};
+
+PeriodicSync periodicSyncs[PERIODIC_SYNC_COUNT];
+std::size_t creatingPeriodicSync = NO_PERIODIC_SYNC;
+bool periodicSyncsScheduled = false;
+bool unmanagedSyncCreationPending = false;
+
+const char* periodicSyncStateToString(PeriodicSyncState_t state) {
+    switch (state) {
+        case PERIODIC_SYNC_WAITING:
+            return "WAITING";
+        case PERIODIC_SYNC_CREATING:
+            return "CREATING";
+        case PERIODIC_SYNC_CANCELING:
+            return "CANCELING";
+        case PERIODIC_SYNC_SYNCED:
+            return "SYNCED";
+        default:
+            return "FREE";
+    }
+}
+
+PeriodicSync* findPeriodicSync(ble::periodic_sync_handle_t syncHandle) {
+    for (std::size_t i = 0; i < PERIODIC_SYNC_COUNT; ++i) {
+        if (periodicSyncs[i].state == PERIODIC_SYNC_SYNCED &&
+            periodicSyncs[i].syncHandle == syncHandle) {
+            return &periodicSyncs[i];
+        }
+    }
+    return NULL;
+}
+
+void createPeriodicSyncs();
+
+void schedulePeriodicSyncs(uint32_t delay) {
+    if (periodicSyncsScheduled) {
+        return;
+    }
+    periodicSyncsScheduled = getCLICommandEventQueue()->post_in(createPeriodicSyncs, delay) != NULL;
+}
+
+/*
+ * Start the creation of the next waiting sync if no creation is in progress.
+ */
+void createPeriodicSyncs() {
+    periodicSyncsScheduled = false;
+
+    if (creatingPeriodicSync != NO_PERIODIC_SYNC || unmanagedSyncCreationPending) {
+        return;
+    }
+
+    for (std::size_t i = 0; i < PERIODIC_SYNC_COUNT; ++i) {
+        PeriodicSync& sync = periodicSyncs[i];
+        if (sync.state != PERIODIC_SYNC_WAITING) {
+            continue;
+        }
+
+        sync.lastError = gap().createSync(
+            sync.peerAddressType,
+            sync.peerAddress,
+            sync.sid,
+            sync.maxPacketSkip,
+            ble::sync_timeout_t(sync.timeout)
+        );
+
+        if (sync.lastError == BLE_ERROR_NONE) {
+            sync.state = PERIODIC_SYNC_CREATING;
+            creatingPeriodicSync = i;
+        } else {
+            schedulePeriodicSyncs(PERIODIC_SYNC_RETRY_DELAY);
+        }
+        return;
+    }
+}
+
+void whenPeriodicSyncEstablished(const ble::PeriodicAdvertisingSyncEstablishedEvent &event) {
+    if (unmanagedSyncCreationPending) {
+        // end of a creation started by the createSync commands
+        unmanagedSyncCreationPending = false;
+        schedulePeriodicSyncs(0);
+        return;
+    }
+
+    if (creatingPeriodicSync == NO_PERIODIC_SYNC) {
+        // sync not created by the manager
+        return;
+    }
+
+    PeriodicSync& sync = periodicSyncs[creatingPeriodicSync];
+    creatingPeriodicSync = NO_PERIODIC_SYNC;
+
+    if (sync.state == PERIODIC_SYNC_CANCELING) {
+        // the sync may have been established before the cancellation
+        if (event.getStatus() == BLE_ERROR_NONE) {
+            gap().terminateSync(event.getSyncHandle());
+        }
+        sync.state = PERIODIC_SYNC_FREE;
+        schedulePeriodicSyncs(0);
+        return;
+    }
+
+    sync.lastError = event.getStatus();
+
+    if (event.getStatus() == BLE_ERROR_NONE) {
+        sync.state = PERIODIC_SYNC_SYNCED;
+        sync.syncHandle = event.getSyncHandle();
+        sync.interval = event.getAdvertisingInterval().value();
+        sync.lastReport = gapEventClock.read_ms();
+        sync.lastReportIncomplete = false;
+        ++sync.establishments;
+        schedulePeriodicSyncs(0);
+    } else {
+        sync.state = PERIODIC_SYNC_WAITING;
+        schedulePeriodicSyncs(PERIODIC_SYNC_RETRY_DELAY);
+    }
+}
+
+void whenPeriodicAdvertisingReport(const ble::PeriodicAdvertisingReportEvent &event) {
+    PeriodicSync* sync = findPeriodicSync(event.getSyncHandle());
+    if (sync == NULL) {
+        return;
+    }
+
+    uint32_t now = gapEventClock.read_ms();
+
+    // fragments of the same advertising event are not accounted as events.
+    if (!sync->lastReportIncomplete) {
+        ++sync->reports;
+        if (sync->interval) {
+            // elapsed time and interval in units of 0.25 ms, rounded to the
+            // nearest event
+            uint64_t elapsed = (uint64_t) (now - sync->lastReport) * 4;
+            uint64_t interval = (uint64_t) sync->interval * 5;
+            uint32_t elapsedEvents = (elapsed + (interval / 2)) / interval;
+            if (elapsedEvents > 1) {
+                sync->missedEvents += elapsedEvents - 1;
+            }
+        }
+        sync->lastReport = now;
+    }
+    sync->lastReportIncomplete =
+        event.getDataStatus() == ble::advertising_data_status_t::INCOMPLETE_MORE_DATA;
+
+    sync->bytes += event.getPayload().size();
+
+    // 127 means that the RSSI is not available
+    ble::rssi_t rssi = event.getRssi();
+    if (rssi != 127) {
+        if (sync->rssiCount == 0 || rssi < sync->rssiMin) {
+            sync->rssiMin = rssi;
+        }
+        if (sync->rssiCount == 0 || rssi > sync->rssiMax) {
+            sync->rssiMax = rssi;
+        }
+        sync->rssiLast = rssi;
+        sync->rssiSum += rssi;
+        ++sync->rssiCount;
+    }
+}
+
+void whenPeriodicSyncLoss(const ble::PeriodicAdvertisingSyncLoss &event) {
+    PeriodicSync* sync = findPeriodicSync(event.getSyncHandle());
+    if (sync == NULL) {
+        return;
+    }
+
+    ++sync->losses;
+    sync->state = PERIODIC_SYNC_WAITING;
+    schedulePeriodicSyncs(0);
+}
+
+/*
+ * Advertising orchestrator: a batch of advertising sets created, configured
+ * and started by a single command. Each set can have several payloads which
+ * are rotated periodically from the event queue. Payloads are stored in an
+ * arena released when the sets are stopped or when the BLE instance is shut
+ * down.
+ */
+#ifndef BLE_CLIAPP_GAP_ORCHESTRATED_SET_COUNT
+static const std::size_t ORCHESTRATED_SET_COUNT = 8;
+#else
+static const std::size_t ORCHESTRATED_SET_COUNT = BLE_CLIAPP_GAP_ORCHESTRATED_SET_COUNT;
+#endif
+
+#ifndef BLE_CLIAPP_GAP_ORCHESTRATED_PAYLOAD_COUNT
+static const std::size_t ORCHESTRATED_PAYLOAD_COUNT = 4;
+#else
+static const std::size_t ORCHESTRATED_PAYLOAD_COUNT = BLE_CLIAPP_GAP_ORCHESTRATED_PAYLOAD_COUNT;
+#endif
+
+struct OrchestratedPayload {
+    const uint8_t* data;
+    uint16_t length;
+};
+
+struct OrchestratedSet {
+    mbed::Span<const uint8_t> payload(std::size_t index) const {
+        return mbed::make_Span(payloads[index].data, payloads[index].length);
+    }
+
+    ble::advertising_handle_t handle;
+    uint8_t payloadCount;
+    uint8_t currentPayload;
+    OrchestratedPayload payloads[ORCHESTRATED_PAYLOAD_COUNT];
+};
+
+struct AdvertisingOrchestrator {
+    util::BumpArena arena;
+    OrchestratedSet sets[ORCHESTRATED_SET_COUNT];
+    uint8_t setCount;
+    eq::EventQueue::event_handle_t rotation;
+    uint32_t rotations;
+    uint32_t rotationErrors;
+};
+
+AdvertisingOrchestrator advertisingOrchestrator;
+bool orchestratorShutdownRegistered = false;
+
+/*
+ * Parse the description of a set: a comma separated list of payloads in hex.
+ */
+bool orchestratedSetFromString(const char* str, OrchestratedSet& set, util::BumpArena& arena) {
+    set.payloadCount = 0;
+    set.currentPayload = 0;
+
+    while (true) {
+        const char* end = str;
+        while (*end && *end != ',') {
+            ++end;
+        }
+
+        std::size_t digits = end - str;
+        if (digits == 0 || (digits % 2) || (digits / 2) > 0xFFFF ||
+            set.payloadCount == ORCHESTRATED_PAYLOAD_COUNT) {
+            return false;
+        }
+
+        uint8_t* data = static_cast<uint8_t*>(arena.allocate(digits / 2));
+        if (data == NULL) {
+            return false;
+        }
+
+        for (std::size_t i = 0; i < (digits / 2); ++i) {
+            if (!asciiHexByteToByte(str[i * 2], str[(i * 2) + 1], data[i])) {
+                return false;
+            }
+        }
+
+        set.payloads[set.payloadCount].data = data;
+        set.payloads[set.payloadCount].length = digits / 2;
+        ++set.payloadCount;
+
+        if (*end == '\0') {
+            return true;
+        }
+        str = end + 1;
+    }
+}
+
+void rotateOrchestratedPayloads() {
+    AdvertisingOrchestrator& orchestrator = advertisingOrchestrator;
+
+    for (uint8_t i = 0; i < orchestrator.setCount; ++i) {
+        OrchestratedSet& set = orchestrator.sets[i];
+        if (set.payloadCount < 2) {
+            continue;
+        }
+
+        set.currentPayload = (set.currentPayload + 1) % set.payloadCount;
+        ble_error_t err = gap().setAdvertisingPayload(set.handle, set.payload(set.currentPayload));
+        if (err) {
+            ++orchestrator.rotationErrors;
+        }
+    }
+
+    ++orchestrator.rotations;
+}
+
+/*
+ * Stop and destroy the sets of the orchestrator, errors are ignored as the sets
+ * may be partially configured.
+ */
+void stopOrchestratedSets() {
+    AdvertisingOrchestrator& orchestrator = advertisingOrchestrator;
+
+    if (orchestrator.rotation) {
+        getCLICommandEventQueue()->cancel(orchestrator.rotation);
+        orchestrator.rotation = NULL;
+    }
+
+    for (uint8_t i = 0; i < orchestrator.setCount; ++i) {
+        ble::advertising_handle_t handle = orchestrator.sets[i].handle;
+        if (gap().isAdvertisingActive(handle)) {
+            gap().stopAdvertising(handle);
+        }
+        gap().destroyAdvertisingSet(handle);
+    }
+
+    orchestrator.setCount = 0;
+    orchestrator.arena.clear();
+}
+
+/*
+ * The sets do not survive the shutdown of the BLE instance: stop the rotation
+ * and release the state of the orchestrator without calling into Gap.
+ */
+void whenOrchestratorShutdown(const Gap *) {
+    AdvertisingOrchestrator& orchestrator = advertisingOrchestrator;
+
+    if (orchestrator.rotation) {
+        getCLICommandEventQueue()->cancel(orchestrator.rotation);
+        orchestrator.rotation = NULL;
+    }
+
+    orchestrator.setCount = 0;
+    orchestrator.arena.clear();
+
+    gap().onShutdown().detach(whenOrchestratorShutdown);
+    orchestratorShutdownRegistered = false;
+}
+
+/*
+ * Multi-peer connection: a single procedure connects to a list of peers. The
+ * controller accepts one connection creation at a time; the next one is
+ * started as soon as the previous one completes. Each attempt is cancelled
+ * after MULTI_CONNECT_ATTEMPT_TIMEOUT ms; failed attempts are retried after a
+ * delay doubled at each attempt, other peers are connected in the meantime.
+ * Peers connected must fit in the connection table, otherwise the state and
+ * activity of their connections would not be tracked.
+ */
+#ifndef BLE_CLIAPP_GAP_MULTI_CONNECT_PEER_COUNT
+static const std::size_t MULTI_CONNECT_PEER_COUNT = ConnectionTable::CAPACITY;
+#else
+static const std::size_t MULTI_CONNECT_PEER_COUNT = BLE_CLIAPP_GAP_MULTI_CONNECT_PEER_COUNT;
+#endif
+
+// fails to compile if BLE_CLIAPP_GAP_MULTI_CONNECT_PEER_COUNT is greater than
+// BLE_CLIAPP_CONNECTION_TABLE_SIZE
+typedef char multi_connect_peer_count_exceeds_connection_table[
+    (MULTI_CONNECT_PEER_COUNT <= ConnectionTable::CAPACITY) ? 1 : -1
+];
+
+#ifndef BLE_CLIAPP_GAP_MULTI_CONNECT_ATTEMPT_TIMEOUT
+static const uint32_t MULTI_CONNECT_ATTEMPT_TIMEOUT = 2000;
+#else
+static const uint32_t MULTI_CONNECT_ATTEMPT_TIMEOUT = BLE_CLIAPP_GAP_MULTI_CONNECT_ATTEMPT_TIMEOUT;
+#endif
+
+#ifndef BLE_CLIAPP_GAP_MULTI_CONNECT_MAX_ATTEMPTS
+static const uint8_t MULTI_CONNECT_MAX_ATTEMPTS = 3;
+#else
+static const uint8_t MULTI_CONNECT_MAX_ATTEMPTS = BLE_CLIAPP_GAP_MULTI_CONNECT_MAX_ATTEMPTS;
+#endif
+
+#ifndef BLE_CLIAPP_GAP_MULTI_CONNECT_RETRY_DELAY
+static const uint32_t MULTI_CONNECT_RETRY_DELAY = 50;
+#else
+static const uint32_t MULTI_CONNECT_RETRY_DELAY = BLE_CLIAPP_GAP_MULTI_CONNECT_RETRY_DELAY;
+#endif
+
+static const std::size_t NO_MULTI_CONNECT_PEER = MULTI_CONNECT_PEER_COUNT;
+
+enum MultiConnectPeerState_t {
+    MULTI_CONNECT_PENDING,
+    MULTI_CONNECT_CONNECTING,
+    MULTI_CONNECT_CONNECTED,
+    MULTI_CONNECT_FAILED
+};
+
+struct MultiConnectPeer {
+    MultiConnectPeerState_t state;
+    ble::peer_address_type_t::type peerAddressType;
+    ble::address_t peerAddress;
+    ble::connection_handle_t handle;
+    uint8_t attempts;
+    uint32_t retryAt;
+    uint32_t attemptStart;
+    uint32_t latency;
+    uint32_t elapsed;
+    ble_error_t lastError;
+};
+
+struct MultiConnectProcedure;
+
+struct MultiConnect {
+    MultiConnectProcedure* procedure;
+    MultiConnectPeer peers[MULTI_CONNECT_PEER_COUNT];
+    std::size_t peerCount;
+    // number of advertisers to collect before connecting, 0 if the peers are known
+    std::size_t advertiserCount;
+    ble::rssi_t minRssi;
+    std::size_t connecting;
+    uint32_t start;
+    eq::EventQueue::event_handle_t attemptTimeout;
+    eq::EventQueue::event_handle_t nextConnection;
+};
+
+MultiConnect multiConnect;
+
+void connectNextPeer();
+
+void scheduleNextPeerConnection(uint32_t delay) {
+    if (multiConnect.nextConnection) {
+        getCLICommandEventQueue()->cancel(multiConnect.nextConnection);
+    }
+    multiConnect.nextConnection = getCLICommandEventQueue()->post_in(connectNextPeer, delay);
+}
+
+void whenPeerAttemptFailed(MultiConnectPeer& peer, ble_error_t error) {
+    peer.lastError = error;
+    if (peer.attempts >= MULTI_CONNECT_MAX_ATTEMPTS) {
+        peer.state = MULTI_CONNECT_FAILED;
+    } else {
+        peer.state = MULTI_CONNECT_PENDING;
+        peer.retryAt = gapEventClock.read_ms() + (MULTI_CONNECT_RETRY_DELAY << (peer.attempts - 1));
+    }
+}
+
+/*
+ * Cancel the connection attempt in progress, the failure is reported by the
+ * connection complete event.
+ */
+void cancelPeerConnection() {
+    multiConnect.attemptTimeout = NULL;
+    if (multiConnect.connecting != NO_MULTI_CONNECT_PEER) {
+        gap().cancelConnect();
+    }
+}
+
+struct MultiConnectProcedure : public AsyncProcedure {
+    MultiConnectProcedure(const CommandResponsePtr& res, uint32_t procedureTimeout) :
+        AsyncProcedure(res, procedureTimeout) {
+    }
+
+    virtual ~MultiConnectProcedure() {
+        eq::EventQueue* queue = getCLICommandEventQueue();
+        if (multiConnect.attemptTimeout) {
+            queue->cancel(multiConnect.attemptTimeout);
+        }
+        if (multiConnect.nextConnection) {
+            queue->cancel(multiConnect.nextConnection);
+        }
+        multiConnect.attemptTimeout = NULL;
+        multiConnect.nextConnection = NULL;
+        multiConnect.procedure = NULL;
+    }
+
+    virtual bool doStart() {
+        multiConnect.procedure = this;
+        multiConnect.connecting = NO_MULTI_CONNECT_PEER;
+        multiConnect.start = gapEventClock.read_ms();
+
+        if (multiConnect.advertiserCount == 0) {
+            scheduleNextPeerConnection(0);
+            return true;
+        }
+
+        ble_error_t err = gap().setScanParameters(getScanParameters());
+        if (err == BLE_ERROR_NONE) {
+            err = gap().startScan();
+        }
+        if (err) {
+            response->faillure(err);
+            return false;
+        }
+        return true;
+    }
+
+    virtual void doWhenTimeout() {
+        if (multiConnect.advertiserCount) {
+            gap().stopScan();
+        }
+        if (multiConnect.connecting != NO_MULTI_CONNECT_PEER) {
+            gap().cancelConnect();
+        }
+        report(false);
+    }
+
+    void whenAdvertisingReport(const ble::AdvertisingReportEvent &event) {
+        if (!event.getType().connectable() || event.getRssi() < multiConnect.minRssi) {
+            return;
+        }
+
+        for (std::size_t i = 0; i < multiConnect.peerCount; ++i) {
+            if (multiConnect.peers[i].peerAddress == event.getPeerAddress()) {
+                return;
+            }
+        }
+
+        MultiConnectPeer& peer = multiConnect.peers[multiConnect.peerCount++];
+        peer = MultiConnectPeer();
+        peer.state = MULTI_CONNECT_PENDING;
+        peer.peerAddressType = event.getPeerAddressType().value();
+        peer.peerAddress = event.getPeerAddress();
+
+        if (multiConnect.peerCount == multiConnect.advertiserCount) {
+            gap().stopScan();
+            multiConnect.advertiserCount = 0;
+            scheduleNextPeerConnection(0);
+        }
+    }
+
+    void whenConnectionComplete(const ble::ConnectionCompleteEvent &event) {
+        // Connections initiated by peers are not accounted; the controller
+        // creates a single connection at a time as central.
+        if (multiConnect.connecting == NO_MULTI_CONNECT_PEER ||
+            (event.getStatus() == BLE_ERROR_NONE &&
+             event.getOwnRole() != ble::connection_role_t::CENTRAL)) {
+            return;
+        }
+
+        MultiConnectPeer& peer = multiConnect.peers[multiConnect.connecting];
+        multiConnect.connecting = NO_MULTI_CONNECT_PEER;
+        if (multiConnect.attemptTimeout) {
+            getCLICommandEventQueue()->cancel(multiConnect.attemptTimeout);
+            multiConnect.attemptTimeout = NULL;
+        }
+
+        if (event.getStatus() == BLE_ERROR_NONE) {
+            uint32_t now = gapEventClock.read_ms();
+            peer.state = MULTI_CONNECT_CONNECTED;
+            peer.handle = event.getConnectionHandle();
+            peer.latency = now - peer.attemptStart;
+            peer.elapsed = now - multiConnect.start;
+            peer.lastError = BLE_ERROR_NONE;
+        } else {
+            whenPeerAttemptFailed(peer, event.getStatus());
+        }
+
+        scheduleNextPeerConnection(0);
+    }
+
+    /*
+     * Start the connection of the next peer ready. Terminate the procedure
+     * once every peer is connected or failed.
+     */
+    void connectNext() {
+        multiConnect.nextConnection = NULL;
+        if (multiConnect.connecting != NO_MULTI_CONNECT_PEER) {
+            return;
+        }
+
+        uint32_t now = gapEventClock.read_ms();
+        bool pending = false;
+        uint32_t nextRetry = 0;
+
+        for (std::size_t i = 0; i < multiConnect.peerCount; ++i) {
+            MultiConnectPeer& peer = multiConnect.peers[i];
+            if (peer.state != MULTI_CONNECT_PENDING) {
+                continue;
+            }
+
+            int32_t wait = (int32_t) (peer.retryAt - now);
+            if (wait > 0) {
+                if (!pending || (uint32_t) wait < nextRetry) {
+                    nextRetry = wait;
+                }
+                pending = true;
+                continue;
+            }
+
+            ++peer.attempts;
+            peer.attemptStart = now;
+            ble_error_t err = gap().connect(
+                peer.peerAddressType,
+                peer.peerAddress,
+                getConnectionParameters()
+            );
+
+            if (err) {
+                whenPeerAttemptFailed(peer, err);
+                if (peer.state == MULTI_CONNECT_PENDING) {
+                    wait = (int32_t) (peer.retryAt - now);
+                    if (!pending || (uint32_t) wait < nextRetry) {
+                        nextRetry = wait;
+                    }
+                    pending = true;
+                }
+                continue;
+            }
+
+            peer.state = MULTI_CONNECT_CONNECTING;
+            multiConnect.connecting = i;
+            multiConnect.attemptTimeout = getCLICommandEventQueue()->post_in(
+                cancelPeerConnection, MULTI_CONNECT_ATTEMPT_TIMEOUT
+            );
+            return;
+        }
+
+        if (pending) {
+            scheduleNextPeerConnection(nextRetry);
+            return;
+        }
+
+        bool allConnected = true;
+        for (std::size_t i = 0; i < multiConnect.peerCount; ++i) {
+            if (multiConnect.peers[i].state != MULTI_CONNECT_CONNECTED) {
+                allConnected = false;
+            }
+        }
+        report(allConnected);
+        terminate();
+    }
+
+    void report(bool success) {
+        using namespace serialization;
 
-const ble::ConnectionParameters &getConnectionParameters() {
-    return ConnectionParametersCommandSuiteDescription::get();
+        if (success) {
+            response->success();
+        } else {
+            response->faillure();
+        }
+
+        JSONOutputStream& os = response->getResultStream();
+        os << startArray;
+        for (std::size_t i = 0; i < multiConnect.peerCount; ++i) {
+            const MultiConnectPeer& peer = multiConnect.peers[i];
+            os << startObject <<
+                key("peer_address_type") << ble::peer_address_type_t(peer.peerAddressType) <<
+                key("peer_address") << peer.peerAddress <<
+                key("attempts") << peer.attempts;
+            if (peer.state == MULTI_CONNECT_CONNECTED) {
+                os <<
+                    key("handle") << peer.handle <<
+                    key("latency") << peer.latency <<
+                    key("elapsed") << peer.elapsed;
+            } else {
+                os << key("error") << peer.lastError;
+            }
+            os << endObject;
+        }
+        os << endArray;
+    }
+};
+
+void connectNextPeer() {
+    if (multiConnect.procedure) {
+        multiConnect.procedure->connectNext();
+    }
 }
 
 void enable_event_handling() {
-    using namespace serialization;
-
     struct EventHandler : public ble::Gap::EventHandler {
         virtual void onScanRequestReceived(const ble::ScanRequestEvent &event)
         {
-            JSONEventStream() << startObject <<
-                key("type") << "event" <<
-                key("name") << "scan_request_received" <<
-                key("value") << startObject <<
-                    key("peer_address") << event.getPeerAddress() <<
-                    key("peer_address_type") << event.getPeerAddressType() <<
-                    key("advertising_handle") << event.getAdvHandle() <<
-                endObject <<
-            endObject;
+            pushGapEvent<ScanRequestRecord>(event);
         }
 
         virtual void onAdvertisingEnd(const ble::AdvertisingEndEvent &event)
         {
-            JSONEventStream output;
-            output << startObject <<
-                key("type") << "event" <<
-                key("name") << "advertising_end" <<
-                key("value") << startObject <<
-                    key("advertising_handle") << event.getAdvHandle() <<
-                    key("completed_events") << event.getCompleted_events() <<
-                    key("is_connected") << event.isConnected();
-            if (event.isConnected()) {
-                output <<
-                    key("connection_handle") << event.getConnection();
-            }
-            output <<
-                endObject <<
-            endObject;
+            pushGapEvent<AdvertisingEndRecord>(event);
         }
 
         virtual void onAdvertisingReport(const ble::AdvertisingReportEvent &event)
         {
-            JSONEventStream os;
-
-            os << startObject <<
-                key("type") << "event" <<
-                key("name") << "advertising_report" <<
-                key("value") << startObject <<
-                    key("connectable") << event.getType().connectable() <<
-                    key("scannable") << event.getType().scannable_advertising() <<
-                    key("scan_response") << event.getType().scan_response() <<
-                    key("directed") << event.getType().directed_advertising() <<
-                    key("legacy") << event.getType().legacy_advertising() <<
-                    key("rssi") << event.getRssi() <<
-                    key("peer_address_type") << event.getPeerAddressType();
-
-            if (event.getPeerAddressType() != ble::peer_address_type_t::ANONYMOUS) {
-                os << key("peer_address") << event.getPeerAddress();
-            }
-
-            if (event.getType().directed_advertising()) {
-                os << key("direct_address_type") << event.getDirectAddressType() <<
-                      key("direct_address") << event.getDirectAddress();
-            }
-
-            if (event.getType().legacy_advertising() == false) {
-                os << key("sid") << event.getSID() <<
-                      key("tx_power") << event.getTxPower() <<
-                      key("primary_phy") << event.getPrimaryPhy() <<
-                      key("secondary_phy") << event.getSecondaryPhy() <<
-                      key("data_status");
-
-                switch (event.getType().data_status().value()) {
-                    case ble::advertising_data_status_t::COMPLETE:
-                        os << "COMPLETE";
-                        break;
-                    case ble::advertising_data_status_t::INCOMPLETE_MORE_DATA:
-                        os << "INCOMPLETE_MORE_DATA";
-                        break;
-                    case ble::advertising_data_status_t::INCOMPLETE_DATA_TRUNCATED:
-                        os << "INCOMPLETE_DATA_TRUNCATED";
-                        break;
-                    default:
-                        os << "unknown";
-                        break;
-                }
-
-                if (event.isPeriodicIntervalPresent()) {
-                    os << key("periodic_interval") << event.getPeriodicInterval();
-                }
+            if (multiConnect.procedure && multiConnect.advertiserCount) {
+                multiConnect.procedure->whenAdvertisingReport(event);
             }
-
-            os <<   key("payload") << event.getPayload() <<
-                endObject <<
-            endObject;
+            pushAdvertisingReport(event);
         }
 
         virtual void onScanTimeout(const ble::ScanTimeoutEvent &event)
         {
-            JSONEventStream() << startObject <<
-                key("type") << "event" <<
-                key("name") << "scan_timeout" <<
-            endObject;
+            pushGapEvent<ScanTimeoutRecord>(event);
         }
 
         virtual void onPeriodicAdvertisingSyncEstablished(
             const ble::PeriodicAdvertisingSyncEstablishedEvent &event
         )
         {
-            JSONEventStream output;
-
-            output << startObject <<
-                key("type") << "event" <<
-                key("name") << "periodic_advertising_sync_established" <<
-                key("value") << startObject <<
-                    key("status") << event.getStatus();
-
-            if (event.getStatus() == BLE_ERROR_NONE) {
-                output <<
-                    key("peer_address_type") << event.getPeerAddressType() <<
-                    key("peer_address") << event.getPeerAddress() <<
-                    key("sync_handle") << event.getSyncHandle() <<
-                    key("advertising_interval") << event.getAdvertisingInterval() <<
-                    key("peer_phy") << event.getPeerPhy() <<
-                    key("sid") << event.getSid() <<
-                    key("peer_clock_accuracy") << ble::clock_accuracy_t(event.getPeerClockAccuracy()).get_ppm();
-            }
-
-            output <<
-                endObject <<
-            endObject;
+            whenPeriodicSyncEstablished(event);
+            pushGapEvent<PeriodicAdvertisingSyncEstablishedRecord>(event);
         }
 
         virtual void onPeriodicAdvertisingReport(
             const ble::PeriodicAdvertisingReportEvent &event
         )
         {
-            JSONEventStream() << startObject <<
-                key("type") << "event" <<
-                key("name") << "periodic_advertising_report" <<
-                key("value") << startObject <<
-                    key("sync_handle") << event.getSyncHandle() <<
-                    key("rssi") << event.getRssi() <<
-                    key("tx_power") << event.getTxPower() <<
-                    key("data_status") << event.getDataStatus() <<
-                    key("data") << event.getPayload() <<
-                endObject <<
-            endObject;
+            whenPeriodicAdvertisingReport(event);
+            pushGapEvent<PeriodicAdvertisingReportRecord>(event, event.getPayload());
         }
 
         virtual void onPeriodicAdvertisingSyncLoss(
             const ble::PeriodicAdvertisingSyncLoss &event
         )
         {
-            JSONEventStream() << startObject <<
-                key("type") << "event" <<
-                key("name") << "periodic_advertising_sync_loss" <<
-                key("value") << startObject <<
-                    key("sync_handle") << event.getSyncHandle() <<
-                endObject <<
-            endObject;
+            whenPeriodicSyncLoss(event);
+            pushGapEvent<PeriodicAdvertisingSyncLossRecord>(event);
         }
 
         virtual void onConnectionComplete(const ble::ConnectionCompleteEvent &event)
         {
-            JSONEventStream os;
-
-            os << startObject <<
-                key("type") << "event" <<
-                key("name") << "connection_complete" <<
-                key("value") << startObject <<
-                    key("status") << event.getStatus();
-
-            if (event.getStatus() != BLE_ERROR_NONE) {
-                os << endObject << endObject;
-                return;
-            }
-
-            os <<   key("peer_address_type") << event.getPeerAddressType() <<
-                    key("peer_address") << event.getPeerAddress() <<
-                    key("interval") << event.getConnectionInterval() <<
-                    key("latency") << event.getConnectionLatency().value() <<
-                    key("supervision_timeout") << event.getSupervisionTimeout() <<
-                    key("connection_handle") << event.getConnectionHandle() <<
-                    key("own_role") << (event.getOwnRole() == ble::connection_role_t::CENTRAL ? "CENTRAL" : "PERIPHERAL") <<
-                    key("master_clock_accuracy") << event.getMasterClockAccuracy();
-
-            if (event.getPeerResolvablePrivateAddress() != ble::address_t()) {
-                os << key("peer_resolvable_private_address") << event.getPeerResolvablePrivateAddress();
+            if (multiConnect.procedure) {
+                multiConnect.procedure->whenConnectionComplete(event);
             }
-
-            if (event.getLocalResolvablePrivateAddress() != ble::address_t()) {
-                os << key("local_resolvable_private_address") << event.getLocalResolvablePrivateAddress();
-            }
-
-            os << endObject <<
-            endObject;
+            pushGapEvent<ConnectionCompleteRecord>(event);
         }
 
         virtual void onUpdateConnectionParametersRequest(
             const ble::UpdateConnectionParametersRequestEvent &event
         )
         {
-            JSONEventStream() << startObject <<
-                key("type") << "event" <<
-                key("name") << "update_connection_parameters_request" <<
-                key("value") << startObject <<
-                    key("connection_handle") << event.getConnectionHandle() <<
-                    key("min_connection_interval") << event.getMinConnectionInterval() <<
-                    key("max_connection_interval") << event.getMaxConnectionInterval() <<
-                    key("slave_latency") << event.getSlaveLatency().value() <<
-                    key("supervision_timeout") << event.getSupervisionTimeout() <<
-                endObject <<
-            endObject;
+            pushGapEvent<UpdateConnectionParametersRequestRecord>(event);
         }
 
         virtual void onConnectionParametersUpdateComplete(
             const ble::ConnectionParametersUpdateCompleteEvent &event
         )
         {
-            JSONEventStream os;
-
-            os << startObject <<
-                key("type") << "event" <<
-                key("name") << "on_connection_parameters_update_complete" <<
-                key("value") << startObject <<
-                    key("connection_handle") << event.getConnectionHandle() <<
-                    key("status") << event.getStatus();
-
             if (event.getStatus() == BLE_ERROR_NONE) {
-                os <<
-                    key("connection_interval") << event.getConnectionInterval() <<
-                    key("slave_latency") << event.getSlaveLatency().value() <<
-                    key("supervision_timeout") << event.getSupervisionTimeout();
+                ConnectionTable::updateConnectionParameters(
+                    event.getConnectionHandle(),
+                    event.getConnectionInterval().value(),
+                    event.getSlaveLatency().value(),
+                    event.getSupervisionTimeout().value()
+                );
             }
-
-            os <<
-                endObject <<
-            endObject;
+            pushGapEvent<ConnectionParametersUpdateCompleteRecord>(event);
         }
 
         virtual void onDisconnectionComplete(const ble::DisconnectionCompleteEvent &event)
         {
-            JSONEventStream() << startObject <<
-                key("type") << "event" <<
-                key("name") << "disconnection_complete" <<
-                key("value") << startObject <<
-                    key("connection_handle") << event.getConnectionHandle() <<
-                    key("reason") << event.getReason() <<
-                endObject <<
-            endObject;
-
+            pushGapEvent<DisconnectionCompleteRecord>(event);
         }
 
         virtual void onReadPhy(
@@ -300,21 +1985,10 @@ void enable_event_handling() {
             ble::phy_t rxPhy
         )
         {
-            JSONEventStream os;
-            os << startObject <<
-                key("type") << "event" <<
-                key("name") << "read_phy" <<
-                key("value") << startObject <<
-                    key("connection_handle") << connectionHandle <<
-                    key("status") << status;
             if (status == BLE_ERROR_NONE) {
-                os <<
-                    key("tx_phy") << txPhy <<
-                    key("rx_phy") << rxPhy;
+                ConnectionTable::updatePhy(connectionHandle, txPhy, rxPhy);
             }
-            os <<
-                endObject <<
-            endObject;
+            pushPhyEvent(READ_PHY_EVENT, status, connectionHandle, txPhy, rxPhy);
         }
 
         virtual void onPhyUpdateComplete(
@@ -324,26 +1998,17 @@ void enable_event_handling() {
             ble::phy_t rxPhy
         )
         {
-            JSONEventStream os;
-            os << startObject <<
-                key("type") << "event" <<
-                key("name") << "phy_update_complete" <<
-                key("value") << startObject <<
-                    key("connection_handle") << connectionHandle <<
-                    key("status") << status;
             if (status == BLE_ERROR_NONE) {
-                os <<
-                    key("tx_phy") << txPhy <<
-                    key("rx_phy") << rxPhy;
+                ConnectionTable::updatePhy(connectionHandle, txPhy, rxPhy);
             }
-            os <<
-                endObject <<
-            endObject;
+            pushPhyEvent(PHY_UPDATE_COMPLETE_EVENT, status, connectionHandle, txPhy, rxPhy);
         }
     };
 
     static EventHandler handler;
 
+    gapEventClock.start();
+
     gap().setEventHandler(&handler);
 }
 
@@ -583,6 +2248,9 @@ DECLARE_CMD(CreateSync) {
             maxPacketSkip,
             timeout
         );
+        if (err == BLE_ERROR_NONE) {
+            unmanagedSyncCreationPending = true;
+        }
         reportErrorOrSuccess(response, err);
     }
 };
@@ -603,6 +2271,9 @@ DECLARE_CMD(CreateSyncFromList) {
             maxPacketSkip,
             timeout
         );
+        if (err == BLE_ERROR_NONE) {
+            unmanagedSyncCreationPending = true;
+        }
         reportErrorOrSuccess(response, err);
     }
 };
@@ -813,6 +2484,592 @@ DECLARE_CMD(IsFeatureSupported) {
     }
 };
 
+DECLARE_CMD(SubscribeEvents) {
+    CMD_NAME("subscribeEvents")
+    CMD_HELP("Forward the events listed; the name all select every event.")
+    CMD_ARGS(
+        CMD_ARG("string", "event", "Name of the event to subscribe to")
+    )
+
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return GAP_EVENT_TYPE_COUNT;
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        uint32_t mask;
+        if (!gapEventMaskFromArgs(args, mask)) {
+            response->invalidParameters("Unknown event name");
+            return;
+        }
+
+        gapEventSubscriptions |= mask;
+        response->success();
+    }
+};
+
+DECLARE_CMD(UnsubscribeEvents) {
+    CMD_NAME("unsubscribeEvents")
+    CMD_HELP("Discard the events listed; the name all select every event.")
+    CMD_ARGS(
+        CMD_ARG("string", "event", "Name of the event to unsubscribe from")
+    )
+
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return GAP_EVENT_TYPE_COUNT;
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        uint32_t mask;
+        if (!gapEventMaskFromArgs(args, mask)) {
+            response->invalidParameters("Unknown event name");
+            return;
+        }
+
+        gapEventSubscriptions &= ~mask;
+        response->success();
+    }
+};
+
+DECLARE_CMD(SetEventRateLimit) {
+    CMD_NAME("setEventRateLimit")
+    CMD_HELP("Limit the number of events of a given type forwarded per second.")
+    CMD_ARGS(
+        CMD_ARG("string", "event", "Name of the event; all select every event"),
+        CMD_ARG("uint16_t", "rate", "Maximum number of events per second, 0 to remove the limit")
+    )
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        uint32_t mask;
+        if (!gapEventMaskFromString(args[0], mask)) {
+            response->invalidParameters("Unknown event name");
+            return;
+        }
+
+        uint16_t rate;
+        if (!fromString(args[1], rate)) {
+            response->invalidParameters("The rate is ill formed");
+            return;
+        }
+
+        for (uint8_t type = 0; type < GAP_EVENT_TYPE_COUNT; ++type) {
+            if (mask & (1 << type)) {
+                gapEventFilters[type].rateLimit = rate;
+                gapEventFilters[type].windowCount = 0;
+            }
+        }
+        response->success();
+    }
+};
+
+DECLARE_CMD(SetEventSampling) {
+    CMD_NAME("setEventSampling")
+    CMD_HELP("Forward one event out of ratio events of a given type.")
+    CMD_ARGS(
+        CMD_ARG("string", "event", "Name of the event; all select every event"),
+        CMD_ARG("uint16_t", "ratio", "Sampling ratio, 0 or 1 forward every event")
+    )
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        uint32_t mask;
+        if (!gapEventMaskFromString(args[0], mask)) {
+            response->invalidParameters("Unknown event name");
+            return;
+        }
+
+        uint16_t ratio;
+        if (!fromString(args[1], ratio)) {
+            response->invalidParameters("The ratio is ill formed");
+            return;
+        }
+
+        for (uint8_t type = 0; type < GAP_EVENT_TYPE_COUNT; ++type) {
+            if (mask & (1 << type)) {
+                gapEventFilters[type].sampling = ratio;
+                gapEventFilters[type].sampleCount = 0;
+            }
+        }
+        response->success();
+    }
+};
+
+DECLARE_CMD(GetEventSubscriptions) {
+    CMD_NAME("getEventSubscriptions")
+    CMD_HELP("Return the subscription state and filters of each event.")
+    CMD_RESULTS(
+        CMD_RESULT("JSON Array", "", "Description of each event"),
+        CMD_RESULT("string", "[].name", "Name of the event"),
+        CMD_RESULT("bool", "[].subscribed", "True if the event is forwarded"),
+        CMD_RESULT("uint16_t", "[].rate_limit", "Maximum number of events forwarded per second, 0 if unlimited"),
+        CMD_RESULT("uint16_t", "[].sampling", "Sampling ratio of the event"),
+        CMD_RESULT("uint32_t", "[].filtered", "Number of events discarded by the filters")
+    )
+    CMD_HANDLER(CommandResponsePtr& response) {
+        using namespace serialization;
+
+        response->success();
+        JSONOutputStream& os = response->getResultStream();
+
+        os << startArray;
+        for (uint8_t type = 0; type < GAP_EVENT_TYPE_COUNT; ++type) {
+            const GapEventFilter& filter = gapEventFilters[type];
+            os << startObject <<
+                key("name") << gapEventNames[type] <<
+                key("subscribed") << ((gapEventSubscriptions & (1 << type)) != 0) <<
+                key("rate_limit") << filter.rateLimit <<
+                key("sampling") << filter.sampling <<
+                key("filtered") << filter.filtered <<
+            endObject;
+        }
+        os << endArray;
+    }
+};
+
+DECLARE_CMD(SetAdvertisingReportDeduplication) {
+    CMD_NAME("setAdvertisingReportDeduplication")
+    CMD_HELP("Report identical advertising reports from an advertiser at most once per window.")
+    CMD_ARGS(
+        CMD_ARG("uint32_t", "window", "Deduplication window in ms, 0 to disable the deduplication")
+    )
+    CMD_HANDLER(uint32_t window, CommandResponsePtr& response) {
+        AdvertisingReportFilters& filters = advertisingReportFilters;
+        for (std::size_t i = 0; i < ADVERTISING_DEDUPLICATION_ENTRY_COUNT; ++i) {
+            filters.entries[i].used = false;
+        }
+        filters.deduplicationWindow = window;
+        filters.duplicates = 0;
+        response->success();
+    }
+};
+
+DECLARE_CMD(SetAdvertisingReportReassembly) {
+    CMD_NAME("setAdvertisingReportReassembly")
+    CMD_HELP("Report fragmented extended advertising reports as a single event.")
+    CMD_ARGS(
+        CMD_ARG("bool", "enable", "Enable or disable the reassembly")
+    )
+    CMD_HANDLER(bool enable, CommandResponsePtr& response) {
+        AdvertisingReportFilters& filters = advertisingReportFilters;
+
+        for (std::size_t i = 0; i < ADVERTISING_REASSEMBLY_SLOT_COUNT; ++i) {
+            filters.slots[i].used = false;
+        }
+
+        if (enable && filters.reassemblyBuffer == NULL) {
+            filters.reassemblyBuffer = new uint8_t[
+                ADVERTISING_REASSEMBLY_SLOT_COUNT * ADVERTISING_REASSEMBLY_SIZE
+            ];
+        } else if (!enable) {
+            delete[] filters.reassemblyBuffer;
+            filters.reassemblyBuffer = NULL;
+        }
+
+        filters.reassembled = 0;
+        filters.reassemblyFailures = 0;
+        filters.oversized = 0;
+        response->success();
+    }
+};
+
+DECLARE_CMD(GetAdvertisingReportFilters) {
+    CMD_NAME("getAdvertisingReportFilters")
+    CMD_HELP("Return the configuration and statistics of the advertising report filters.")
+    CMD_RESULTS(
+        CMD_RESULT("JSON Object", "", "Configuration and statistics of the filters"),
+        CMD_RESULT("uint32_t", "deduplication_window", "Deduplication window in ms, 0 if disabled"),
+        CMD_RESULT("uint32_t", "duplicates", "Number of reports suppressed by the deduplication"),
+        CMD_RESULT("bool", "reassembly", "True if fragmented reports are reassembled"),
+        CMD_RESULT("uint32_t", "reassembled", "Number of reports reassembled"),
+        CMD_RESULT("uint32_t", "reassembly_failures", "Number of partial reports lost"),
+        CMD_RESULT("uint32_t", "oversized", "Number of reports dropped because they do not fit in the event queue")
+    )
+    CMD_HANDLER(CommandResponsePtr& response) {
+        using namespace serialization;
+
+        const AdvertisingReportFilters& filters = advertisingReportFilters;
+
+        response->success();
+        response->getResultStream() << startObject <<
+            key("deduplication_window") << filters.deduplicationWindow <<
+            key("duplicates") << filters.duplicates <<
+            key("reassembly") << (filters.reassemblyBuffer != NULL) <<
+            key("reassembled") << filters.reassembled <<
+            key("reassembly_failures") << filters.reassemblyFailures <<
+            key("oversized") << filters.oversized <<
+        endObject;
+    }
+};
+
+DECLARE_CMD(AddPeriodicSync) {
+    CMD_NAME("addPeriodicSync")
+    CMD_HELP("Register a periodic advertising sync in the sync manager. The sync is "
+             "created as soon as possible and created again whenever it is lost.")
+    CMD_ARGS(
+        CMD_ARG("ble::peer_address_type_t::type", "peerAddressType", "Type of the address of the advertiser"),
+        CMD_ARG("ble::address_t", "peerAddress", "Address of the advertiser"),
+        CMD_ARG("uint8_t", "sid", "Advertising set identifier"),
+        CMD_ARG("uint16_t", "maxPacketSkip", "Number of events which can be skipped"),
+        CMD_ARG("ble::sync_timeout_t", "timeout", "Sync timeout")
+    )
+    CMD_RESULTS(
+        CMD_RESULT("uint8_t", "", "Index of the sync in the sync manager")
+    )
+    CMD_HANDLER(
+        ble::peer_address_type_t::type peerAddressType,
+        ble::address_t &peerAddress,
+        uint8_t sid,
+        uint16_t maxPacketSkip,
+        ble::sync_timeout_t timeout,
+        CommandResponsePtr& response
+    ) {
+        for (std::size_t i = 0; i < PERIODIC_SYNC_COUNT; ++i) {
+            PeriodicSync& sync = periodicSyncs[i];
+            if (sync.state != PERIODIC_SYNC_FREE) {
+                continue;
+            }
+
+            sync = PeriodicSync();
+            sync.state = PERIODIC_SYNC_WAITING;
+            sync.peerAddressType = peerAddressType;
+            sync.peerAddress = peerAddress;
+            sync.sid = sid;
+            sync.maxPacketSkip = maxPacketSkip;
+            sync.timeout = timeout.value();
+            schedulePeriodicSyncs(0);
+
+            response->success((uint8_t) i);
+            return;
+        }
+
+        response->faillure("The sync table is full");
+    }
+};
+
+DECLARE_CMD(RemovePeriodicSync) {
+    CMD_NAME("removePeriodicSync")
+    CMD_HELP("Remove a sync from the sync manager and terminate it. A sync being created "
+             "is released once the controller acknowledges the cancellation.")
+    CMD_ARGS(
+        CMD_ARG("uint8_t", "index", "Index of the sync in the sync manager")
+    )
+    CMD_HANDLER(uint8_t index, CommandResponsePtr& response) {
+        if (index >= PERIODIC_SYNC_COUNT ||
+            periodicSyncs[index].state == PERIODIC_SYNC_FREE ||
+            periodicSyncs[index].state == PERIODIC_SYNC_CANCELING) {
+            response->invalidParameters("Unknown sync");
+            return;
+        }
+
+        PeriodicSync& sync = periodicSyncs[index];
+        ble_error_t err = BLE_ERROR_NONE;
+        PeriodicSyncState_t nextState = PERIODIC_SYNC_FREE;
+        if (sync.state == PERIODIC_SYNC_SYNCED) {
+            err = gap().terminateSync(sync.syncHandle);
+        } else if (sync.state == PERIODIC_SYNC_CREATING) {
+            // the next creation starts when the cancellation is reported by
+            // the sync established event
+            err = gap().cancelCreateSync();
+            nextState = PERIODIC_SYNC_CANCELING;
+        }
+
+        if (err == BLE_ERROR_NONE) {
+            sync.state = nextState;
+        }
+        reportErrorOrSuccess(response, err);
+    }
+};
+
+DECLARE_CMD(GetPeriodicSyncs) {
+    CMD_NAME("getPeriodicSyncs")
+    CMD_HELP("Return the state and statistics of the syncs of the sync manager.")
+    CMD_RESULTS(
+        CMD_RESULT("JSON Array", "", "Syncs registered in the sync manager"),
+        CMD_RESULT("uint8_t", "[].index", "Index of the sync"),
+        CMD_RESULT("string", "[].state", "WAITING, CREATING, CANCELING or SYNCED"),
+        CMD_RESULT("ble::peer_address_type_t", "[].peer_address_type", "Type of the address of the advertiser"),
+        CMD_RESULT("ble::address_t", "[].peer_address", "Address of the advertiser"),
+        CMD_RESULT("uint8_t", "[].sid", "Advertising set identifier"),
+        CMD_RESULT("uint16_t", "[].sync_handle", "Handle of the sync, present if synced"),
+        CMD_RESULT("uint32_t", "[].reports", "Number of advertising events received"),
+        CMD_RESULT("uint32_t", "[].bytes", "Number of bytes received"),
+        CMD_RESULT("uint32_t", "[].missed_events", "Estimation of the number of advertising events missed"),
+        CMD_RESULT("uint32_t", "[].losses", "Number of sync losses"),
+        CMD_RESULT("uint32_t", "[].establishments", "Number of times the sync has been established"),
+        CMD_RESULT("ble_error_t", "[].last_error", "Last error reported when the sync was created"),
+        CMD_RESULT("JSON Object", "[].rssi", "RSSI last, min, mean and max; null if not available")
+    )
+    CMD_HANDLER(CommandResponsePtr& response) {
+        using namespace serialization;
+
+        response->success();
+        JSONOutputStream& os = response->getResultStream();
+
+        os << startArray;
+        for (std::size_t i = 0; i < PERIODIC_SYNC_COUNT; ++i) {
+            const PeriodicSync& sync = periodicSyncs[i];
+            if (sync.state == PERIODIC_SYNC_FREE) {
+                continue;
+            }
+
+            os << startObject <<
+                key("index") << (uint8_t) i <<
+                key("state") << periodicSyncStateToString(sync.state) <<
+                key("peer_address_type") << ble::peer_address_type_t(sync.peerAddressType) <<
+                key("peer_address") << sync.peerAddress <<
+                key("sid") << sync.sid;
+            if (sync.state == PERIODIC_SYNC_SYNCED) {
+                os << key("sync_handle") << sync.syncHandle;
+            }
+            os <<
+                key("reports") << sync.reports <<
+                key("bytes") << sync.bytes <<
+                key("missed_events") << sync.missedEvents <<
+                key("losses") << sync.losses <<
+                key("establishments") << sync.establishments <<
+                key("last_error") << sync.lastError <<
+                key("rssi");
+            if (sync.rssiCount) {
+                os << startObject <<
+                    key("last") << sync.rssiLast <<
+                    key("min") << sync.rssiMin <<
+                    key("mean") << (int32_t) (sync.rssiSum / (int32_t) sync.rssiCount) <<
+                    key("max") << sync.rssiMax <<
+                endObject;
+            } else {
+                os << nil;
+            }
+            os << endObject;
+        }
+        os << endArray;
+    }
+};
+
+DECLARE_CMD(StartAdvertisingSets) {
+    CMD_NAME("startAdvertisingSets")
+    CMD_HELP("Create, configure and start a batch of advertising sets with the current "
+             "advertising parameters. Each set is described by a comma separated list "
+             "of payloads; sets with several payloads rotate them every period.")
+    CMD_ARGS(
+        CMD_ARG("uint32_t", "period", "Rotation period of the payloads in ms, 0 to disable the rotation"),
+        CMD_ARG("string", "set", "Comma separated list of payloads in hex of the set")
+    )
+    CMD_RESULTS(
+        CMD_RESULT("JSON Array", "", "Handles of the advertising sets started")
+    )
+
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 1 + ORCHESTRATED_SET_COUNT;
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        using namespace serialization;
+
+        AdvertisingOrchestrator& orchestrator = advertisingOrchestrator;
+
+        if (orchestrator.setCount) {
+            response->invalidParameters("Advertising sets already started");
+            return;
+        }
+
+        uint32_t period;
+        if (!fromString(args[0], period)) {
+            response->invalidParameters("The period is ill formed");
+            return;
+        }
+
+        uint8_t setCount = args.count() - 1;
+        for (uint8_t i = 0; i < setCount; ++i) {
+            if (!orchestratedSetFromString(args[i + 1], orchestrator.sets[i], orchestrator.arena)) {
+                orchestrator.arena.clear();
+                response->invalidParameters("A set description is ill formed");
+                return;
+            }
+        }
+
+        for (uint8_t i = 0; i < setCount; ++i) {
+            OrchestratedSet& set = orchestrator.sets[i];
+            const char* operation = "createAdvertisingSet";
+            ble_error_t err = gap().createAdvertisingSet(&set.handle, getAdvertisingParameters());
+            if (err == BLE_ERROR_NONE) {
+                orchestrator.setCount = i + 1;
+                operation = "setAdvertisingPayload";
+                err = gap().setAdvertisingPayload(set.handle, set.payload(0));
+            }
+            if (err == BLE_ERROR_NONE) {
+                operation = "startAdvertising";
+                err = gap().startAdvertising(set.handle);
+            }
+
+            if (err) {
+                stopOrchestratedSets();
+                response->faillure();
+                response->getResultStream() << startObject <<
+                    key("set") << i <<
+                    key("operation") << operation <<
+                    key("error") << err <<
+                endObject;
+                return;
+            }
+        }
+
+        if (orchestratorShutdownRegistered == false) {
+            gap().onShutdown(whenOrchestratorShutdown);
+            orchestratorShutdownRegistered = true;
+        }
+
+        orchestrator.rotations = 0;
+        orchestrator.rotationErrors = 0;
+        if (period) {
+            orchestrator.rotation = getCLICommandEventQueue()->post_every(
+                rotateOrchestratedPayloads, period
+            );
+        }
+
+        response->success();
+        JSONOutputStream& os = response->getResultStream();
+        os << startArray;
+        for (uint8_t i = 0; i < setCount; ++i) {
+            os << orchestrator.sets[i].handle;
+        }
+        os << endArray;
+    }
+};
+
+DECLARE_CMD(StopAdvertisingSets) {
+    CMD_NAME("stopAdvertisingSets")
+    CMD_HELP("Stop and destroy the advertising sets started by startAdvertisingSets.")
+    CMD_HANDLER(CommandResponsePtr& response) {
+        stopOrchestratedSets();
+        response->success();
+    }
+};
+
+DECLARE_CMD(GetAdvertisingSets) {
+    CMD_NAME("getAdvertisingSets")
+    CMD_HELP("Return the state of the advertising sets started by startAdvertisingSets.")
+    CMD_RESULTS(
+        CMD_RESULT("JSON Object", "", "State of the advertising sets"),
+        CMD_RESULT("JSON Array", "sets", "Advertising sets started"),
+        CMD_RESULT("ble::advertising_handle_t", "sets[].handle", "Handle of the set"),
+        CMD_RESULT("uint8_t", "sets[].payload_count", "Number of payloads of the set"),
+        CMD_RESULT("uint8_t", "sets[].current_payload", "Index of the payload advertised"),
+        CMD_RESULT("uint32_t", "rotations", "Number of payload rotations"),
+        CMD_RESULT("uint32_t", "rotation_errors", "Number of payload updates which failed")
+    )
+    CMD_HANDLER(CommandResponsePtr& response) {
+        using namespace serialization;
+
+        const AdvertisingOrchestrator& orchestrator = advertisingOrchestrator;
+
+        response->success();
+        JSONOutputStream& os = response->getResultStream();
+
+        os << startObject << key("sets") << startArray;
+        for (uint8_t i = 0; i < orchestrator.setCount; ++i) {
+            const OrchestratedSet& set = orchestrator.sets[i];
+            os << startObject <<
+                key("handle") << set.handle <<
+                key("payload_count") << set.payloadCount <<
+                key("current_payload") << set.currentPayload <<
+            endObject;
+        }
+        os << endArray <<
+            key("rotations") << orchestrator.rotations <<
+            key("rotation_errors") << orchestrator.rotationErrors <<
+        endObject;
+    }
+};
+
+DECLARE_CMD(ConnectPeers) {
+    CMD_NAME("connectPeers")
+    CMD_HELP("Connect to a list of peers with the current connection parameters. "
+             "Connections are created one after the other and failed attempts are "
+             "retried with an increasing delay.")
+    CMD_ARGS(
+        CMD_ARG("uint32_t", "timeout", "Maximum duration of the procedure in ms"),
+        CMD_ARG("ble::peer_address_type_t::type", "peerAddressType", "Type of the address of the peer"),
+        CMD_ARG("ble::address_t", "peerAddress", "Address of the peer")
+    )
+    CMD_RESULTS(
+        CMD_RESULT("JSON Array", "", "Result of the connection to each peer"),
+        CMD_RESULT("ble::peer_address_type_t", "[].peer_address_type", "Type of the address of the peer"),
+        CMD_RESULT("ble::address_t", "[].peer_address", "Address of the peer"),
+        CMD_RESULT("uint8_t", "[].attempts", "Number of connection attempts"),
+        CMD_RESULT("uint16_t", "[].handle", "Handle of the connection, present if connected"),
+        CMD_RESULT("uint32_t", "[].latency", "Duration in ms of the successful attempt"),
+        CMD_RESULT("uint32_t", "[].elapsed", "Time in ms between the procedure start and the connection"),
+        CMD_RESULT("ble_error_t", "[].error", "Last error, present if not connected")
+    )
+
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 1 + (2 * MULTI_CONNECT_PEER_COUNT);
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        if (multiConnect.procedure) {
+            response->invalidParameters("A multi connection procedure is running");
+            return;
+        }
+
+        uint32_t timeout;
+        if (!fromString(args[0], timeout)) {
+            response->invalidParameters("The timeout is ill formed");
+            return;
+        }
+
+        if (args.count() < 3 || (args.count() % 2) == 0) {
+            response->invalidParameters("Peers are described by an address type and an address");
+            return;
+        }
+
+        multiConnect.peerCount = 0;
+        multiConnect.advertiserCount = 0;
+        for (std::size_t i = 1; i < args.count(); i += 2) {
+            MultiConnectPeer& peer = multiConnect.peers[multiConnect.peerCount];
+            peer = MultiConnectPeer();
+            peer.state = MULTI_CONNECT_PENDING;
+            if (!fromString(args[i], peer.peerAddressType) ||
+                !fromString(args[i + 1], peer.peerAddress)) {
+                response->invalidParameters("A peer description is ill formed");
+                return;
+            }
+            ++multiConnect.peerCount;
+        }
+
+        startProcedure<MultiConnectProcedure>(response, timeout);
+    }
+};
+
+DECLARE_CMD(ConnectAdvertisers) {
+    CMD_NAME("connectAdvertisers")
+    CMD_HELP("Scan with the current scan parameters then connect to the first "
+             "connectable advertisers received. The results are reported as in "
+             "connectPeers.")
+    CMD_ARGS(
+        CMD_ARG("uint32_t", "timeout", "Maximum duration of the procedure in ms"),
+        CMD_ARG("uint8_t", "count", "Number of advertisers to connect to"),
+        CMD_ARG("int8_t", "minRssi", "Advertisers received with a lower RSSI are ignored")
+    )
+    CMD_HANDLER(uint32_t timeout, uint8_t count, int8_t minRssi, CommandResponsePtr& response) {
+        if (multiConnect.procedure) {
+            response->invalidParameters("A multi connection procedure is running");
+            return;
+        }
+
+        if (count == 0 || count > MULTI_CONNECT_PEER_COUNT) {
+            response->invalidParameters("Invalid number of advertisers");
+            return;
+        }
+
+        multiConnect.peerCount = 0;
+        multiConnect.advertiserCount = count;
+        multiConnect.minRssi = minRssi;
+
+        startProcedure<MultiConnectProcedure>(response, timeout);
+    }
+};
+
 } // end of annonymous namespace
 
 
@@ -850,7 +3107,23 @@ DECLARE_SUITE_COMMANDS(GapV2CommandSuiteDescription,
     CMD_INSTANCE(AcceptConnectionParametersUpdate),
     CMD_INSTANCE(RejectConnectionParametersUpdate),
     CMD_INSTANCE(Disconnect),
-    CMD_INSTANCE(IsFeatureSupported)
+    CMD_INSTANCE(IsFeatureSupported),
+    CMD_INSTANCE(SubscribeEvents),
+    CMD_INSTANCE(UnsubscribeEvents),
+    CMD_INSTANCE(SetEventRateLimit),
+    CMD_INSTANCE(SetEventSampling),
+    CMD_INSTANCE(GetEventSubscriptions),
+    CMD_INSTANCE(SetAdvertisingReportDeduplication),
+    CMD_INSTANCE(SetAdvertisingReportReassembly),
+    CMD_INSTANCE(GetAdvertisingReportFilters),
+    CMD_INSTANCE(AddPeriodicSync),
+    CMD_INSTANCE(RemovePeriodicSync),
+    CMD_INSTANCE(GetPeriodicSyncs),
+    CMD_INSTANCE(StartAdvertisingSets),
+    CMD_INSTANCE(StopAdvertisingSets),
+    CMD_INSTANCE(GetAdvertisingSets),
+    CMD_INSTANCE(ConnectPeers),
+    CMD_INSTANCE(ConnectAdvertisers)
 )
 
 void GapV2CommandSuiteDescription::init()
@@ -11,12 +11,24 @@
 #include "Serialization/DiscoveredCharacteristic.h"
 #include "Serialization/GattCallbackParamTypes.h"
 #include "CLICommand/util/AsyncProcedure.h"
+#include "CLICommand/CommandEventQueue.h"
 
 #include "CLICommand/CommandSuite.h"
 
 #include "Common.h"
 #include "CLICommand/CommandHelper.h"
 
+#include "util/CircularBuffer.h"
+#include "util/AttributeEventRecord.h"
+#include "util/Log2Histogram.h"
+#include "util/ConnectionTable.h"
+
+#ifdef YOTTA_CFG
+#include "mbed-drivers/Timer.h"
+#else
+#include "Timer.h"
+#endif
+
 #include "GattClientCommands.h"
 
 using mbed::util::SharedPointer;
@@ -80,6 +92,8 @@ DECLARE_CMD(DiscoverAllServicesAndCharacteristicsCommand) {
                 return false;
             }
 
+            ConnectionTable::registerGattProcedure(connectionHandle);
+
             client().onServiceDiscoveryTermination(makeFunctionPointer(
                 this, &DiscoverAllServicesAndCharacteristicsProcedure::whenServiceDiscoveryTerminated
             ));
@@ -207,6 +221,8 @@ DECLARE_CMD(DiscoverAllServicesCommand) {
                 return false;
             }
 
+            ConnectionTable::registerGattProcedure(connectionHandle);
+
             client().onServiceDiscoveryTermination(makeFunctionPointer(
                 this, &DiscoverAllServicesProcedure::whenServiceDiscoveryTerminated
             ));
@@ -310,6 +326,8 @@ DECLARE_CMD(DiscoverPrimaryServicesByUUIDCommand) {
                 return false;
             }
 
+            ConnectionTable::registerGattProcedure(connectionHandle);
+
             client().onServiceDiscoveryTermination(makeFunctionPointer(
                 this, &DiscoverServicesByUUIDProcedure::whenServiceDiscoveryTerminated
             ));
@@ -489,6 +507,8 @@ struct DiscoverAllCharacteristicsDescriptorsCommand : public BaseCommand {
                 return false;
             }
 
+            ConnectionTable::registerGattProcedure(characteristic.getConnectionHandle());
+
             gap().onDisconnection(makeFunctionPointer(
                 this, &DiscoverAllCharacteristicsDescriptorsProcedure::whenDisconnected
             ));
@@ -589,6 +609,8 @@ struct ReadProcedure : public AsyncProcedure {
             return false;
         }
 
+        ConnectionTable::registerGattProcedure(connectionHandle);
+
         // attach callbacks
         client().onDataRead(makeFunctionPointer(this, &ReadProcedure::whenDataRead));
         return true;
@@ -704,6 +726,8 @@ struct WriteProcedure : public AsyncProcedure {
             return false;
         }
 
+        ConnectionTable::registerGattProcedure(connectionHandle);
+
         // in this case, no response is expected from the server
         if (cmd == GattClient::GATT_OP_WRITE_CMD ||
             cmd == GattClient::GATT_OP_SIGNED_WRITE_CMD) {
@@ -913,9 +937,94 @@ struct WriteLongCharacteristicDescriptorCommand : public BaseCommand {
 };
 
 
+/**
+ * @brief Filter applied to HVX events by the listenHVX commands.
+ */
+struct HVXFilter {
+    bool match(const GattHVXCallbackParams* hvx_event) const {
+        if (filterConnection && hvx_event->connHandle != connectionHandle) {
+            return false;
+        }
+        if (filterAttribute && hvx_event->handle != attributeHandle) {
+            return false;
+        }
+        return true;
+    }
+
+    bool filterConnection;
+    uint16_t connectionHandle;
+    bool filterAttribute;
+    uint16_t attributeHandle;
+};
+
+
+/**
+ * @brief Parse an optional handle filter of the listenHVX commands.
+ * @details The filter is either an uint16_t or "*" which match any handle.
+ *
+ * @param str The string to parse.
+ * @param filterEnabled Set to true if the filter match a specific handle.
+ * @param handle The handle to match.
+ * @return true if the string has been successfully parsed and false otherwise.
+ */
+static bool hvxHandleFilterFromString(const char* str, bool& filterEnabled, uint16_t& handle) {
+    if (strcmp(str, "*") == 0) {
+        filterEnabled = false;
+        return true;
+    }
+
+    filterEnabled = true;
+    return fromString(str, handle);
+}
+
+
+/**
+ * @brief Parse the optional connection and attribute handle filters of the
+ * listenHVX commands; they follow the timeout in args.
+ *
+ * @param args The arguments of the command.
+ * @param filter The filter to fill.
+ * @return NULL if the filters were successfully parsed and an error message
+ * otherwise.
+ */
+static const char* hvxFilterFromArgs(const CommandArgs& args, HVXFilter& filter) {
+    filter.filterConnection = false;
+    filter.filterAttribute = false;
+
+    if (args.count() > 1 &&
+        !hvxHandleFilterFromString(args[1], filter.filterConnection, filter.connectionHandle)) {
+        return "invalid connection handle";
+    }
+
+    if (args.count() > 2 &&
+        !hvxHandleFilterFromString(args[2], filter.filterAttribute, filter.attributeHandle)) {
+        return "invalid attribute handle";
+    }
+
+    return NULL;
+}
+
+
+/**
+ * Counters of the last capture made by listenHVX, the result of listenHVX
+ * only contains the events.
+ */
+struct HVXCaptureCounters {
+    uint32_t received;
+    uint32_t dropped;
+    uint32_t maxBurst;
+};
+
+HVXCaptureCounters lastHVXCapture = { 0 };
+
+
 DECLARE_CMD(ListenHVXCommand) {
     CMD_NAME("listenHVX")
-    CMD_HELP("Listen and display notification or indication for a given time.")
+    CMD_HELP(
+        "Listen and display notification or indication for a given time. "
+        "Optional arguments filter events by connection handle then by "
+        "attribute handle, use * to match any handle."
+    )
 
     CMD_ARGS(
         CMD_ARG("uint16_t", "timeout", "Maximum time - in ms - allowed for this procedure")
@@ -927,26 +1036,70 @@ DECLARE_CMD(ListenHVXCommand) {
         CMD_RESULT("uint16_t", "[x].connHandle", "Connection of the GATT server which has issued the notification"),
         CMD_RESULT("uint16_t", "[x].handle", "Attribute handle which has issued the notification or indication."),
         CMD_RESULT("HVXType_t", "[x].type", "The type of event (notification or indication)."),
-        CMD_RESULT("HexString_t", "[x].data", "Event payload.")
+        CMD_RESULT("uint32_t", "[x].timestamp", "Reception time - in us - relative to the start of the procedure."),
+        CMD_RESULT("uint16_t", "[x].length", "Length of the payload received."),
+        CMD_RESULT("HexString_t", "[x].data", "Event payload, truncated if longer than the capture record.")
     )
 
-    CMD_HANDLER(uint16_t timeout, CommandResponsePtr& response) {
-        response->success();
-        startProcedure<ListenHVXProcedure>(response, timeout);
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 3;
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        uint16_t timeout;
+        if (!fromString(args[0], timeout)) {
+            response->invalidParameters("invalid timeout");
+            return;
+        }
+
+        HVXFilter filter;
+        const char* filterError = hvxFilterFromArgs(args, filter);
+        if (filterError) {
+            response->invalidParameters(filterError);
+            return;
+        }
+
+        startProcedure<ListenHVXProcedure>(response, timeout, filter);
     }
 
+    /**
+     * HVX events are copied in a fixed size ring from the stack callback then
+     * serialized later from the event queue. It keeps the callback short
+     * whatever the notification rate is; if the serial link can't keep up,
+     * events are dropped and accounted instead of stalling the stack.
+     */
     struct ListenHVXProcedure : public AsyncProcedure {
-        ListenHVXProcedure(const SharedPointer<CommandResponse>& res, uint32_t procedureTimeout) :
-            AsyncProcedure(res, procedureTimeout) {
+#ifndef BLE_CLIAPP_HVX_CAPTURE_RECORD_COUNT
+        static const std::size_t RECORD_COUNT = 16;
+#else
+        static const std::size_t RECORD_COUNT = BLE_CLIAPP_HVX_CAPTURE_RECORD_COUNT;
+#endif
+
+#ifndef BLE_CLIAPP_HVX_CAPTURE_PAYLOAD_SIZE
+        static const std::size_t PAYLOAD_SIZE = 32;
+#else
+        static const std::size_t PAYLOAD_SIZE = BLE_CLIAPP_HVX_CAPTURE_PAYLOAD_SIZE;
+#endif
+
+        typedef AttributeEventRecord<PAYLOAD_SIZE> HVXRecord;
+
+        ListenHVXProcedure(const SharedPointer<CommandResponse>& res, uint32_t procedureTimeout, const HVXFilter& hvxFilter) :
+            AsyncProcedure(res, procedureTimeout), filter(hvxFilter), flushHandle(NULL),
+            received(0), dropped(0), maxBurst(0) {
         }
 
         virtual ~ListenHVXProcedure() {
+            if (flushHandle) {
+                getCLICommandEventQueue()->cancel(flushHandle);
+            }
         }
 
         virtual bool doStart() {
-            // the response will be an array of scan sample, start this array right now
+            // the response will be an array of events, start this array right now
             response->success();
             response->getResultStream() << serialization::startArray;
+            timer.start();
             client().onHVX().add(
                 makeFunctionPointer(
                     this, &ListenHVXProcedure::whenHVX
@@ -956,25 +1109,294 @@ DECLARE_CMD(ListenHVXCommand) {
         }
 
         void whenHVX(const GattHVXCallbackParams* hvx_event) {
+            if (!filter.match(hvx_event)) {
+                return;
+            }
+
+            ++received;
+            if (records.full()) {
+                ++dropped;
+                return;
+            }
+
+            HVXRecord record;
+            record.set(
+                timer.read_us(), hvx_event->connHandle, hvx_event->handle,
+                hvx_event->type, hvx_event->data, hvx_event->len
+            );
+            records.push(record);
+
+            if (records.size() > maxBurst) {
+                maxBurst = records.size();
+            }
+
+            if (!flushHandle) {
+                flushHandle = getCLICommandEventQueue()->post(&ListenHVXProcedure::flushFromQueue, this);
+            }
+        }
+
+        // flush posted by whenHVX, the handle is released by the queue
+        void flushFromQueue() {
+            flushHandle = NULL;
+            flush();
+        }
+
+        void flush() {
             using namespace serialization;
             serialization::JSONOutputStream& os = response->getResultStream();
 
-            os << startObject <<
-                key("connHandle") << hvx_event->connHandle <<
-                key("handle") << hvx_event->handle <<
-                key("type") << hvx_event->type <<
-                key("data");
-                serializeRawDataToHexString(os, hvx_event->data, (uint8_t) hvx_event->len) <<
-            endObject;
+            HVXRecord record;
+            while (records.pop(record)) {
+                os << startObject <<
+                    key("connHandle") << record.connectionHandle <<
+                    key("handle") << record.attributeHandle <<
+                    key("type") << (HVXType_t) record.type <<
+                    key("timestamp") << record.timestamp <<
+                    key("length") << record.length <<
+                    key("data");
+                    serializeRawDataToHexString(os, record.data, record.storedLength()) <<
+                endObject;
+            }
         }
 
         virtual void doWhenTimeout() {
+            using namespace serialization;
             client().onHVX().detach(makeFunctionPointer(this, &ListenHVXProcedure::whenHVX));
-            response->getResultStream() << serialization::endArray;
+            // the procedure is deleted after the timeout, a pending flush
+            // must not run on it
+            if (flushHandle) {
+                getCLICommandEventQueue()->cancel(flushHandle);
+                flushHandle = NULL;
+            }
+            flush();
+            response->getResultStream() << endArray;
+
+            lastHVXCapture.received = received;
+            lastHVXCapture.dropped = dropped;
+            lastHVXCapture.maxBurst = maxBurst;
+        }
+
+        HVXFilter filter;
+        util::CircularBuffer<HVXRecord, RECORD_COUNT> records;
+        mbed::Timer timer;
+        eq::EventQueue::event_handle_t flushHandle;
+        uint32_t received;
+        uint32_t dropped;
+        uint32_t maxBurst;
+    };
+
+    ASYNC_PROCEDURE_FITS_POOL(ListenHVXProcedure);
+};
+
+
+DECLARE_CMD(GetListenHVXCountersCommand) {
+    CMD_NAME("getListenHVXCounters")
+    CMD_HELP("Return the counters of the last capture made by listenHVX.")
+
+    CMD_RESULTS(
+        CMD_RESULT("uint32_t", "received", "Number of events matching the filters."),
+        CMD_RESULT("uint32_t", "dropped", "Number of events dropped because the capture buffer was full."),
+        CMD_RESULT("uint32_t", "max_burst", "Maximum number of events waiting for serialization.")
+    )
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        using namespace serialization;
+        response->success();
+        response->getResultStream() << startObject <<
+            key("received") << lastHVXCapture.received <<
+            key("dropped") << lastHVXCapture.dropped <<
+            key("max_burst") << lastHVXCapture.maxBurst <<
+        endObject;
+    }
+};
+
+
+DECLARE_CMD(ListenHVXStatisticsCommand) {
+    CMD_NAME("listenHVXStatistics")
+    CMD_HELP(
+        "Listen to notification or indication for a given time and report "
+        "statistics per connection and attribute handle instead of every event. "
+        "Optional arguments filter events by connection handle then by "
+        "attribute handle, use * to match any handle."
+    )
+
+    CMD_ARGS(
+        CMD_ARG("uint32_t", "timeout", "Maximum time - in ms - allowed for this procedure")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("JSON Object", "", "Statistics of the events received"),
+        CMD_RESULT("uint32_t", "received", "Number of events matching the filters."),
+        CMD_RESULT("uint32_t", "untracked", "Number of events received from attributes which do not fit in the statistics table."),
+        CMD_RESULT("JSON Array", "statistics", "Statistics per connection and attribute handle"),
+        CMD_RESULT("uint16_t", "statistics[x].connHandle", "Connection of the GATT server which has issued the events"),
+        CMD_RESULT("uint16_t", "statistics[x].handle", "Attribute handle which has issued the events."),
+        CMD_RESULT("uint32_t", "statistics[x].count", "Number of events received."),
+        CMD_RESULT("uint64_t", "statistics[x].bytes", "Number of payload bytes received."),
+        CMD_RESULT("JSON Object", "statistics[x].inter_arrival", "Time - in us - between two consecutive events or null if less than two events were received."),
+        CMD_RESULT("uint32_t", "statistics[x].inter_arrival.min", "Minimum inter arrival time."),
+        CMD_RESULT("uint32_t", "statistics[x].inter_arrival.mean", "Mean inter arrival time."),
+        CMD_RESULT("uint32_t", "statistics[x].inter_arrival.max", "Maximum inter arrival time."),
+        CMD_RESULT("uint32_t", "statistics[x].inter_arrival.p99", "Upper bound of the 99th percentile of the inter arrival time.")
+    )
+
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 3;
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        uint32_t timeout;
+        if (!fromString(args[0], timeout)) {
+            response->invalidParameters("invalid timeout");
+            return;
+        }
+
+        HVXFilter filter;
+        const char* filterError = hvxFilterFromArgs(args, filter);
+        if (filterError) {
+            response->invalidParameters(filterError);
+            return;
+        }
+
+        startProcedure<ListenHVXStatisticsProcedure>(response, timeout, filter);
+    }
+
+    /**
+     * Only statistics are computed in the stack callback, nothing is
+     * serialized until the end of the procedure.
+     */
+    struct ListenHVXStatisticsProcedure : public AsyncProcedure {
+#ifndef BLE_CLIAPP_HVX_STATISTICS_ENTRY_COUNT
+        static const std::size_t ENTRY_COUNT = 8;
+#else
+        static const std::size_t ENTRY_COUNT = BLE_CLIAPP_HVX_STATISTICS_ENTRY_COUNT;
+#endif
+
+        struct Entry {
+            uint16_t connectionHandle;
+            uint16_t attributeHandle;
+            uint64_t bytes;
+            uint32_t lastTimestamp;
+            uint32_t count;
+            // 2^23 us is more than 8 seconds, larger values fall in the last bucket
+            util::Log2Histogram<24> interArrival;
+        };
+
+        ListenHVXStatisticsProcedure(const SharedPointer<CommandResponse>& res, uint32_t procedureTimeout, const HVXFilter& hvxFilter) :
+            AsyncProcedure(res, procedureTimeout), filter(hvxFilter),
+            entryCount(0), received(0), untracked(0) {
+        }
+
+        virtual ~ListenHVXStatisticsProcedure() {
+        }
+
+        virtual bool doStart() {
+            timer.start();
+            client().onHVX().add(
+                makeFunctionPointer(
+                    this, &ListenHVXStatisticsProcedure::whenHVX
+                )
+            );
+            return true;
         }
+
+        void whenHVX(const GattHVXCallbackParams* hvx_event) {
+            if (!filter.match(hvx_event)) {
+                return;
+            }
+
+            ++received;
+            // the timer wraps after 71 minutes but differences computed in
+            // uint32_t remain valid as long as events are less than 71 minutes
+            // apart.
+            uint32_t now = timer.read_us();
+
+            Entry* entry = findEntry(hvx_event->connHandle, hvx_event->handle);
+            if (!entry) {
+                ++untracked;
+                return;
+            }
+
+            if (entry->count) {
+                entry->interArrival.record(now - entry->lastTimestamp);
+            }
+            entry->lastTimestamp = now;
+            entry->bytes += hvx_event->len;
+            ++entry->count;
+        }
+
+        Entry* findEntry(uint16_t connectionHandle, uint16_t attributeHandle) {
+            for (std::size_t i = 0; i < entryCount; ++i) {
+                if (entries[i].connectionHandle == connectionHandle &&
+                    entries[i].attributeHandle == attributeHandle) {
+                    return &entries[i];
+                }
+            }
+
+            if (entryCount == ENTRY_COUNT) {
+                return NULL;
+            }
+
+            Entry* entry = &entries[entryCount++];
+            entry->connectionHandle = connectionHandle;
+            entry->attributeHandle = attributeHandle;
+            entry->bytes = 0;
+            entry->lastTimestamp = 0;
+            entry->count = 0;
+            entry->interArrival.reset();
+            return entry;
+        }
+
+        virtual void doWhenTimeout() {
+            using namespace serialization;
+            client().onHVX().detach(makeFunctionPointer(this, &ListenHVXStatisticsProcedure::whenHVX));
+
+            response->success();
+            serialization::JSONOutputStream& os = response->getResultStream();
+            os << startObject <<
+                key("received") << received <<
+                key("untracked") << untracked <<
+                key("statistics") << startArray;
+
+            for (std::size_t i = 0; i < entryCount; ++i) {
+                const Entry& entry = entries[i];
+                os << startObject <<
+                    key("connHandle") << entry.connectionHandle <<
+                    key("handle") << entry.attributeHandle <<
+                    key("count") << entry.count <<
+                    key("bytes") << entry.bytes <<
+                    key("inter_arrival");
+
+                if (entry.interArrival.count()) {
+                    os << startObject <<
+                        key("min") << entry.interArrival.min() <<
+                        key("mean") << entry.interArrival.mean() <<
+                        key("max") << entry.interArrival.max() <<
+                        key("p99") << entry.interArrival.percentile(99) <<
+                    endObject;
+                } else {
+                    os << nil;
+                }
+
+                os << endObject;
+            }
+
+            os << endArray << endObject;
+        }
+
+        HVXFilter filter;
+        Entry entries[ENTRY_COUNT];
+        std::size_t entryCount;
+        mbed::Timer timer;
+        uint32_t received;
+        uint32_t untracked;
     };
+
+    ASYNC_PROCEDURE_FITS_POOL(ListenHVXStatisticsProcedure);
 };
 
+
 } // end of annonymous namespace
 
 
@@ -1000,5 +1422,7 @@ DECLARE_SUITE_COMMANDS(GattClientCommandSuiteDescription,
     CMD_INSTANCE(ReadLongCharacteristicDescriptorCommand),
     CMD_INSTANCE(WriteCharacteristicDescriptorCommand),
     CMD_INSTANCE(WriteLongCharacteristicDescriptorCommand),
-    CMD_INSTANCE(ListenHVXCommand)
+    CMD_INSTANCE(ListenHVXCommand),
+    CMD_INSTANCE(GetListenHVXCountersCommand),
+    CMD_INSTANCE(ListenHVXStatisticsCommand)
 )
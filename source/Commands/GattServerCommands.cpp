@@ -1,4 +1,5 @@
 
+#include <string.h>
 #include "ble/BLE.h"
 #include "ble/Gap.h"
 #include "ble/services/HeartRateService.h"
@@ -11,7 +12,18 @@
 #include "Serialization/GattCallbackParamTypes.h"
 
 #include "util/ServiceBuilder.h"
+#include "util/AttributeEventRecord.h"
+#include "util/ConnectionTable.h"
+#include "util/CircularBuffer.h"
 #include "CLICommand/util/AsyncProcedure.h"
+#include "CLICommand/util/ResultStream.h"
+#include "CLICommand/CommandEventQueue.h"
+
+#ifdef YOTTA_CFG
+#include "mbed-drivers/Timer.h"
+#else
+#include "Timer.h"
+#endif
 
 #include "Common.h"
 
@@ -24,21 +36,22 @@ using mbed::util::SharedPointer;
 namespace {
 
 static ServiceBuilder* serviceBuilder = NULL;
+// true if the service being declared has been started by importService
+static bool serviceImported = false;
 
-static detail::RAIIGattService** gattServices = NULL;
-static size_t gattServicesCount = 0;
+// list of the services committed
+static detail::RAIIGattService* gattServices = NULL;
 static bool cleanupRegistered = false;
 
 static void cleanupServiceBuilder();
 
 static void whenShutdown(const GattServer *) {
     cleanupServiceBuilder();
-    for(size_t i = 0; i < gattServicesCount; ++i) {
-        delete gattServices[i];
+    while(gattServices) {
+        detail::RAIIGattService* next = gattServices->next();
+        detail::RAIIGattService::destroy(gattServices);
+        gattServices = next;
     }
-    std::free(gattServices);
-    gattServices = NULL;
-    gattServicesCount = 0;
     gattServer().onShutdown().detach(whenShutdown);
     cleanupRegistered = false;
 }
@@ -50,13 +63,18 @@ static void cleanupServiceBuilder() {
 
     delete serviceBuilder;
     serviceBuilder = NULL;
+    serviceImported = false;
 }
 
-static bool initServiceBuilder(const UUID& uuid) {
+static bool initServiceBuilder(const UUID& uuid, std::size_t arenaSize = 0, std::size_t valuesSize = 0) {
     if(serviceBuilder) {
         return false;
     }
-    serviceBuilder = new ServiceBuilder(uuid);
+    serviceBuilder = new ServiceBuilder(uuid, arenaSize, valuesSize);
+    if(!serviceBuilder->isValid()) {
+        cleanupServiceBuilder();
+        return false;
+    }
     if(cleanupRegistered == false) {
         gattServer().onShutdown(whenShutdown);
         cleanupRegistered = true;
@@ -65,6 +83,190 @@ static bool initServiceBuilder(const UUID& uuid) {
 }
 
 
+/**
+ * @brief Serialize a service committed in the GattServer, one attribute per
+ * fragment. Attribute values are split in fragments of VALUE_FRAGMENT_SIZE
+ * bytes.
+ * @note The service is owned by the list of services committed which is only
+ * released on shutdown; a shutdown can't be requested while the response of
+ * the commit is still open. The GattServer holds its own copy of the values,
+ * the values of the service are released once they have been streamed.
+ */
+class ServiceSerializer : public serialization::ChunkedSerializer {
+public:
+    static const uint16_t VALUE_FRAGMENT_SIZE = 32;
+
+    ServiceSerializer(detail::RAIIGattService* s) :
+        service(s), state(SERVICE), characteristicIndex(0),
+        descriptorIndex(0), valueOffset(0) {
+    }
+
+    virtual ~ServiceSerializer() {
+        service->releaseAttributesValue();
+    }
+
+    virtual bool next(serialization::JSONOutputStream& os) {
+        using namespace serialization;
+
+        switch(state) {
+            case SERVICE:
+                os << startObject <<
+                    key("UUID") << service->getUUID() <<
+                    key("handle") << service->getHandle() <<
+                    key("characteristics") << startArray;
+                state = CHARACTERISTIC;
+                return true;
+
+            case CHARACTERISTIC: {
+                if(characteristicIndex == service->getCharacteristicCount()) {
+                    os << endArray << endObject;
+                    return false;
+                }
+
+                GattAttribute& attribute = characteristic().getValueAttribute();
+                os << startObject <<
+                    key("UUID") << attribute.getUUID() <<
+                    key("value_handle") << attribute.getHandle() <<
+                    key("properties");  serializeCharacteristicProperties(os, characteristic().getProperties()) <<
+                    key("length") << attribute.getLength() <<
+                    key("max_length") << attribute.getMaxLength() <<
+                    key("has_variable_length") << attribute.hasVariableLength();
+                state = CHARACTERISTIC_VALUE;
+                return true;
+            }
+
+            case CHARACTERISTIC_VALUE:
+                if(writeValueFragment(os, characteristic().getValueAttribute())) {
+                    return true;
+                }
+                os << key("descriptors") << startArray;
+                descriptorIndex = 0;
+                state = DESCRIPTOR;
+                return true;
+
+            case DESCRIPTOR: {
+                if(descriptorIndex == characteristic().getDescriptorCount()) {
+                    os << endArray << endObject;
+                    ++characteristicIndex;
+                    state = CHARACTERISTIC;
+                    return true;
+                }
+
+                GattAttribute& attribute = descriptor();
+                os << startObject <<
+                    key("UUID") << attribute.getUUID() <<
+                    key("handle") << attribute.getHandle() <<
+                    key("length") << attribute.getLength() <<
+                    key("max_length") << attribute.getMaxLength() <<
+                    key("has_variable_length") << attribute.hasVariableLength();
+                state = DESCRIPTOR_VALUE;
+                return true;
+            }
+
+            case DESCRIPTOR_VALUE:
+                if(writeValueFragment(os, descriptor())) {
+                    return true;
+                }
+                os << endObject;
+                ++descriptorIndex;
+                state = DESCRIPTOR;
+                return true;
+        }
+
+        return false;
+    }
+
+private:
+    enum State_t {
+        SERVICE,
+        CHARACTERISTIC,
+        CHARACTERISTIC_VALUE,
+        DESCRIPTOR,
+        DESCRIPTOR_VALUE
+    };
+
+    GattCharacteristic& characteristic() const {
+        return *service->getCharacteristic(characteristicIndex);
+    }
+
+    GattAttribute& descriptor() const {
+        return *characteristic().getDescriptor(descriptorIndex);
+    }
+
+    /**
+     * @brief Write the next fragment of the value of an attribute.
+     * @return true if fragments of the value remain to be written.
+     */
+    bool writeValueFragment(serialization::JSONOutputStream& os, GattAttribute& attribute) {
+        using namespace serialization;
+
+        uint16_t length = attribute.getLength();
+        if(valueOffset == 0) {
+            os << key("value");
+            if(!length) {
+                os << "";
+                return false;
+            }
+            os.put('"');
+        }
+
+        uint16_t count = length - valueOffset;
+        if(count > VALUE_FRAGMENT_SIZE) {
+            count = VALUE_FRAGMENT_SIZE;
+        }
+        writeHexDigits(os, attribute.getValuePtr() + valueOffset, count);
+        valueOffset += count;
+
+        if(valueOffset < length) {
+            return true;
+        }
+
+        os.put('"');
+        os.commitValue();
+        valueOffset = 0;
+        return false;
+    }
+
+    detail::RAIIGattService* service;
+    State_t state;
+    uint16_t characteristicIndex;
+    uint16_t descriptorIndex;
+    uint16_t valueOffset;
+};
+
+/**
+ * @brief Commit the service being declared in the GattServer then stream the
+ * service declared, with its handles, in the response. The service is streamed
+ * in chunks, see streamResult.
+ */
+static void commitServiceDeclaration(const CommandResponsePtr& response) {
+    using namespace serialization;
+
+    detail::RAIIGattService* service = serviceBuilder->release();
+    if(!service) {
+        response->faillure("Impossible to complete the service declaration");
+        cleanupServiceBuilder();
+        return;
+    }
+
+    ble_error_t err = gattServer().addService(*service);
+    if(err) {
+        response->faillure(err);
+        detail::RAIIGattService::destroy(service);
+    } else {
+        response->success();
+        streamResult(response, new ServiceSerializer(service));
+
+        // add the service inside the list of instantiated services
+        service->setNext(gattServices);
+        gattServices = service;
+    }
+
+    // anyway, everything is cleaned up
+    cleanupServiceBuilder();
+}
+
+
 DECLARE_CMD(DeclareServiceCommand) {
     CMD_NAME("declareService")
 
@@ -77,10 +279,15 @@ DECLARE_CMD(DeclareServiceCommand) {
     )
 
     CMD_HANDLER(UUID serviceUUID, CommandResponsePtr& response) {
+        if(serviceBuilder) {
+            response->faillure("Impossible to start a service declaration, a service is already being declared");
+            return;
+        }
+
         if(initServiceBuilder(serviceUUID)) {
             response->success();
         } else {
-            response->faillure("Impossible to start a service declaration, a service is already being declared");
+            response->faillure("Impossible to allocate the service declaration");
         }
     }
 };
@@ -103,9 +310,11 @@ DECLARE_CMD(DeclareCharacteristicCommand) {
             return;
         }
 
-        serviceBuilder->declareCharacteristic(characteristicUUID);
-        response->success();
-
+        if(serviceBuilder->declareCharacteristic(characteristicUUID)) {
+            response->success();
+        } else {
+            response->faillure("Impossible to declare a characteristic");
+        }
     }
 };
 
@@ -368,106 +577,313 @@ DECLARE_CMD(CommitServiceCommand) {
     )
 
     CMD_HANDLER(CommandResponsePtr& response) {
-        using namespace serialization;
+        if(!serviceBuilder) {
+            response->faillure("Their is no service being declared");
+            return;
+        }
+
+        commitServiceDeclaration(response);
+    }
+};
 
+
+DECLARE_CMD(CancelServiceDeclarationCommand) {
+    CMD_NAME("cancelServiceDeclaration")
+
+    CMD_HELP("cancel the service declaration")
+
+    CMD_HANDLER(CommandResponsePtr& response) {
         if(!serviceBuilder) {
             response->faillure("Their is no service being declared");
             return;
         }
+        response->success();
+        cleanupServiceBuilder();
+    }
+};
 
-        serviceBuilder->commit();
-        detail::RAIIGattService* service = serviceBuilder->release();
 
-        ble_error_t err = gattServer().addService(*service);
-        if(err) {
-            response->faillure(err);
-            delete service;
-        } else {
-            response->success();
-            // iterate over all handles
-            serialization::JSONOutputStream& os = response->getResultStream() << startObject <<
-                key("UUID") << service->getUUID() <<
-                key("handle") << service->getHandle() <<
-                key("characteristics") << startArray;
+/**
+ * @brief Types of the records of a service imported with importService.
+ */
+enum ServiceRecordType_t {
+    SERVICE_RECORD = 0x01,
+    CHARACTERISTIC_RECORD = 0x02,
+    CHARACTERISTIC_VALUE_RECORD = 0x03,
+    CHARACTERISTIC_PROPERTIES_RECORD = 0x04,
+    CHARACTERISTIC_SECURITY_RECORD = 0x05,
+    CHARACTERISTIC_VARIABLE_LENGTH_RECORD = 0x06,
+    CHARACTERISTIC_MAX_LENGTH_RECORD = 0x07,
+    DESCRIPTOR_RECORD = 0x08,
+    DESCRIPTOR_VALUE_RECORD = 0x09,
+    DESCRIPTOR_VARIABLE_LENGTH_RECORD = 0x0A,
+    DESCRIPTOR_MAX_LENGTH_RECORD = 0x0B,
+    COMMIT_RECORD = 0xFF
+};
 
-            for(uint16_t i = 0; i < service->getCharacteristicCount(); ++i) {
-                GattCharacteristic& characteristic = *service->getCharacteristic(i);
-                GattAttribute& characteristicAttribute = characteristic.getValueAttribute();
+/**
+ * @brief Read bytes from an hexadecimal string.
+ */
+struct HexStringReader {
+    HexStringReader(const char* str) : pos(str) { }
 
-                os << startObject <<
-                    key("UUID") << characteristicAttribute.getUUID() <<
-                    key("value_handle") << characteristicAttribute.getHandle() <<
-                    key("properties");  serializeCharacteristicProperties(os, characteristic.getProperties()) <<
-                    key("length") << characteristicAttribute.getLength() <<
-                    key("max_length") << characteristicAttribute.getMaxLength() <<
-                    key("has_variable_length") << characteristicAttribute.hasVariableLength();
-
-                if(characteristicAttribute.getLength()) {
-                    os << key("value");
-                    serializeRawDataToHexString(
-                        os,
-                        characteristicAttribute.getValuePtr(),
-                        characteristicAttribute.getLength()
-                    );
-                } else {
-                    os << key("value") << "";
-                }
+    bool empty() const {
+        return *pos == 0;
+    }
 
-                os << key("descriptors") << startArray;
-                for(uint16_t j = 0; j < characteristic.getDescriptorCount(); ++j) {
-                    GattAttribute& descriptor = *characteristic.getDescriptor(j);
-                    os << startObject <<
-                        key("UUID") << descriptor.getUUID() <<
-                        key("handle") << descriptor.getHandle() <<
-                        key("length") << descriptor.getLength() <<
-                        key("max_length") << descriptor.getMaxLength() <<
-                        key("has_variable_length") << descriptor.hasVariableLength();
-
-                    if(descriptor.getLength()) {
-                        os << key("value");
-                        serializeRawDataToHexString(
-                            os,
-                            descriptor.getValuePtr(),
-                            descriptor.getLength()
-                        );
-                    } else {
-                        os << key("value") << "";
-                    }
-                    os << endObject;
-                }
-                os << endArray;
-                os << endObject;
+    bool read(uint8_t& byte) {
+        if(pos[0] == 0 || pos[1] == 0 || !asciiHexByteToByte(pos[0], pos[1], byte)) {
+            return false;
+        }
+        pos += 2;
+        return true;
+    }
+
+    bool read(uint8_t* bytes, std::size_t count) {
+        for(std::size_t i = 0; i < count; ++i) {
+            if(!read(bytes[i])) {
+                return false;
             }
-            os << endArray;
-            os << endObject;
+        }
+        return true;
+    }
+
+    const char* pos;
+};
+
+/**
+ * @brief Convert the payload of a record into an UUID. 16 bits and 128 bits
+ * UUIDs are expressed in the same byte order as their string representation.
+ */
+static bool uuidFromRecord(const uint8_t* payload, uint8_t length, UUID& uuid) {
+    if(length == 2) {
+        uuid = UUID((UUID::ShortUUIDBytes_t) ((payload[0] << 8) | payload[1]));
+        return true;
+    }
+
+    if(length == UUID::LENGTH_OF_LONG_UUID) {
+        uuid = UUID(payload, UUID::MSB);
+        return true;
+    }
+
+    return false;
+}
 
-            // add the service inside the list of instantiated services
-            gattServices = static_cast<detail::RAIIGattService**>(std::realloc(gattServices, sizeof(*gattServices) * (gattServicesCount + 1)));
-            gattServices[gattServicesCount] = service;
-            gattServicesCount += 1;
+/**
+ * @brief Compute the size of the arenas needed by the records of an import.
+ * @details Records which are ill formed are ignored, they are reported when
+ * the records are applied.
+ * @param arenaSize Size of the arena holding the declaration.
+ * @param valuesSize Size of the arena holding the values.
+ */
+static void importedDeclarationSize(const CommandArgs& args, std::size_t& arenaSize, std::size_t& valuesSize) {
+    std::size_t characteristicCount = 0;
+    std::size_t descriptorCount = 0;
+    valuesSize = 0;
+
+    for(std::size_t i = 0; i < args.count(); ++i) {
+        serialization::HexStringReader reader(args[i]);
+
+        while(!reader.empty()) {
+            uint8_t type;
+            uint8_t length;
+            uint8_t payload[0xFF];
+
+            if(!reader.read(type) || !reader.read(length) || !reader.read(payload, length)) {
+                break;
+            }
 
-            // release unused memory
-            service->releaseAttributesValue();
+            switch(type) {
+                case CHARACTERISTIC_RECORD:
+                    ++characteristicCount;
+                    break;
+                case DESCRIPTOR_RECORD:
+                    ++descriptorCount;
+                    break;
+                case CHARACTERISTIC_VALUE_RECORD:
+                case DESCRIPTOR_VALUE_RECORD:
+                    valuesSize += util::BumpArena::alignedSize(length);
+                    break;
+                default:
+                    break;
+            }
         }
+    }
 
-        // anyway, everything is cleaned up
-        cleanupServiceBuilder();
+    arenaSize = detail::RAIIGattService::declarationSize(characteristicCount, descriptorCount);
+}
+
+/**
+ * @brief Apply a record of a service imported to the service being declared.
+ * @param arenaSize Size of the arena allocated if the record starts a service.
+ * @param valuesSize Size of the arena of values allocated if the record starts
+ * a service.
+ * @return NULL in case of success and an error message otherwise.
+ */
+static const char* applyServiceRecord(
+    uint8_t type, const uint8_t* payload, uint8_t length, std::size_t arenaSize, std::size_t valuesSize
+) {
+    UUID uuid;
+
+    if(type == SERVICE_RECORD) {
+        if(serviceBuilder) {
+            return "a service is already being declared";
+        }
+        if(!uuidFromRecord(payload, length, uuid)) {
+            return "invalid service UUID";
+        }
+        if(!initServiceBuilder(uuid, arenaSize, valuesSize)) {
+            return "impossible to allocate the service declaration";
+        }
+        serviceImported = true;
+        return NULL;
     }
-};
 
+    if(!serviceBuilder) {
+        return "there is no service being declared";
+    }
 
-DECLARE_CMD(CancelServiceDeclarationCommand) {
-    CMD_NAME("cancelServiceDeclaration")
+    switch(type) {
+        case CHARACTERISTIC_RECORD:
+            if(!uuidFromRecord(payload, length, uuid)) {
+                return "invalid characteristic UUID";
+            }
+            return serviceBuilder->declareCharacteristic(uuid) ? NULL : "impossible to declare a characteristic";
 
-    CMD_HELP("cancel the service declaration")
+        case CHARACTERISTIC_VALUE_RECORD:
+            return serviceBuilder->setCharacteristicValue(payload, length) ? NULL : "impossible to set a characteristic value";
 
-    CMD_HANDLER(CommandResponsePtr& response) {
-        if(!serviceBuilder) {
-            response->faillure("Their is no service being declared");
+        case CHARACTERISTIC_PROPERTIES_RECORD:
+            if(length != 1 || !serviceBuilder->setCharacteristicProperties(payload[0])) {
+                return "impossible to set characteristic properties";
+            }
+            return NULL;
+
+        case CHARACTERISTIC_SECURITY_RECORD:
+            if(length != 1 || payload[0] > SecurityManager::SECURITY_MODE_SIGNED_WITH_MITM ||
+               !serviceBuilder->setCharacteristicSecurity((SecurityManager::SecurityMode_t) payload[0])) {
+                return "impossible to set characteristic security";
+            }
+            return NULL;
+
+        case CHARACTERISTIC_VARIABLE_LENGTH_RECORD:
+            if(length != 1 || !serviceBuilder->setCharacteristicVariableLength(payload[0] != 0)) {
+                return "impossible to set characteristic variable length";
+            }
+            return NULL;
+
+        case CHARACTERISTIC_MAX_LENGTH_RECORD:
+            if(length != 2 || !serviceBuilder->setCharacteristicMaxLength(payload[0] | (payload[1] << 8))) {
+                return "impossible to set characteristic max length";
+            }
+            return NULL;
+
+        case DESCRIPTOR_RECORD:
+            if(!uuidFromRecord(payload, length, uuid)) {
+                return "invalid descriptor UUID";
+            }
+            return serviceBuilder->declareDescriptor(uuid) ? NULL : "impossible to declare a descriptor";
+
+        case DESCRIPTOR_VALUE_RECORD:
+            return serviceBuilder->setDescriptorValue(payload, length) ? NULL : "impossible to set a descriptor value";
+
+        case DESCRIPTOR_VARIABLE_LENGTH_RECORD:
+            if(length != 1 || !serviceBuilder->setDescriptorVariableLength(payload[0] != 0)) {
+                return "impossible to set descriptor variable length";
+            }
+            return NULL;
+
+        case DESCRIPTOR_MAX_LENGTH_RECORD:
+            if(length != 2 || !serviceBuilder->setDescriptorMaxLength(payload[0] | (payload[1] << 8))) {
+                return "impossible to set descriptor max length";
+            }
+            return NULL;
+
+        default:
+            return "unknown record type";
+    }
+}
+
+
+DECLARE_CMD(ImportServiceCommand) {
+    CMD_NAME("importService")
+
+    CMD_HELP("Declare a service from a list of records, each record is made of a type "
+             "(1 byte), a length (1 byte) and a payload. Records are the equivalent of "
+             "the service declaration commands; the commit record commit the service. "
+             "Large services can be imported with several invocations of this command.")
+
+    CMD_ARGS(
+        CMD_ARG("HexString", "records...", "The records to apply to the service being declared")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("JSON object", "", "If the service has been committed, the service declared; see commitService.")
+    )
+
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 0xFF;
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        using namespace serialization;
+
+        // a service declared with the declaration commands is not discarded
+        // by an import
+        if(serviceBuilder && !serviceImported) {
+            response->faillure("a service is being declared, commit or cancel it before importing a service");
             return;
         }
+
+        // the arenas of a service imported in a single invocation are
+        // allocated at once
+        std::size_t arenaSize;
+        std::size_t valuesSize;
+        importedDeclarationSize(args, arenaSize, valuesSize);
+
+        uint16_t recordIndex = 0;
+        for(std::size_t i = 0; i < args.count(); ++i) {
+            HexStringReader reader(args[i]);
+
+            while(!reader.empty()) {
+                uint8_t type;
+                uint8_t length;
+                uint8_t payload[0xFF];
+                const char* error = NULL;
+
+                if(!reader.read(type) || !reader.read(length) || !reader.read(payload, length)) {
+                    error = "ill formed record";
+                } else if(type == COMMIT_RECORD) {
+                    if(length || !reader.empty() || (i + 1) != args.count()) {
+                        error = "the commit record should be the last record";
+                    } else if(!serviceBuilder) {
+                        error = "there is no service being declared";
+                    }
+                } else {
+                    error = applyServiceRecord(type, payload, length, arenaSize, valuesSize);
+                }
+
+                if(error) {
+                    cleanupServiceBuilder();
+                    response->invalidParameters();
+                    response->getResultStream() << startObject <<
+                        key("record") << recordIndex <<
+                        key("error") << error <<
+                    endObject;
+                    return;
+                }
+
+                if(type == COMMIT_RECORD) {
+                    commitServiceDeclaration(response);
+                    return;
+                }
+
+                ++recordIndex;
+            }
+        }
+
         response->success();
-        cleanupServiceBuilder();
     }
 };
 
@@ -506,48 +922,56 @@ DECLARE_CMD(ReadCommand) {
             return;
         }
 
-        if(args.count() == 2) {
-            Gap::Handle_t connectionHandle;
-            if(!fromString(args[1], connectionHandle)) {
-                response->invalidParameters("The connection handle is ill formed");
-                return;
-            }
+        bool hasConnection = args.count() == 2;
+        Gap::Handle_t connectionHandle = 0;
+        if(hasConnection && !fromString(args[1], connectionHandle)) {
+            response->invalidParameters("The connection handle is ill formed");
+            return;
+        }
 
-            uint16_t length = 0;
-            ble_error_t err = server.read(connectionHandle, attributeHandle, NULL, &length);
-            if(err) {
-                response->faillure(err);
-                return;
-            }
+        // Most values fit in a buffer on the stack and are read once; larger
+        // values are read again in a buffer sized to their length.
+        uint8_t stackBuffer[READ_BUFFER_SIZE];
+        uint16_t length = sizeof(stackBuffer);
+        ble_error_t err = readAttribute(server, hasConnection, connectionHandle, attributeHandle, stackBuffer, length);
+        if(err) {
+            response->faillure(err);
+            return;
+        }
 
-            uint8_t* buffer = new uint8_t[length];
-            err = server.read(connectionHandle, attributeHandle, buffer, &length);
-            if(err) {
-                response->faillure(err);
-            } else {
-                serializeRawDataToHexString(response->getResultStream(), buffer, length);
-                response->success();
-            }
-            delete[] buffer;
+        if(length <= sizeof(stackBuffer)) {
+            serializeRawDataToHexString(response->getResultStream(), stackBuffer, length);
+            response->success();
+            return;
+        }
+
+        uint8_t* buffer = new uint8_t[length];
+        err = readAttribute(server, hasConnection, connectionHandle, attributeHandle, buffer, length);
+        if(err) {
+            response->faillure(err);
         } else {
-            uint16_t length = 0;
-            ble_error_t err = server.read(attributeHandle, NULL, &length);
-            if(err) {
-                response->faillure(err);
-                return;
-            }
+            serializeRawDataToHexString(response->getResultStream(), buffer, length);
+            response->success();
+        }
+        delete[] buffer;
+    }
 
-            uint8_t* buffer = new uint8_t[length];
-            err = server.read(attributeHandle, buffer, &length);
-            if(err) {
-                response->faillure(err);
-            } else {
-                serializeRawDataToHexString(response->getResultStream(), buffer, length);
-                response->success();
-            }
-            delete[] buffer;
+    static ble_error_t readAttribute(
+        GattServer& server, bool hasConnection, Gap::Handle_t connectionHandle,
+        GattAttribute::Handle_t attributeHandle, uint8_t* buffer, uint16_t& length
+    ) {
+        if(hasConnection) {
+            return server.read(connectionHandle, attributeHandle, buffer, &length);
         }
+        return server.read(attributeHandle, buffer, &length);
     }
+
+#ifndef BLE_CLIAPP_GATT_SERVER_READ_BUFFER_SIZE
+    // values up to this length are read in a buffer on the stack
+    static const std::size_t READ_BUFFER_SIZE = 64;
+#else
+    static const std::size_t READ_BUFFER_SIZE = BLE_CLIAPP_GATT_SERVER_READ_BUFFER_SIZE;
+#endif
 };
 
 
@@ -624,6 +1048,11 @@ DECLARE_CMD(WaitForDataWrittenCommand) {
     )
 
     CMD_HANDLER(Gap::Handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, uint16_t procedureTimeout, CommandResponsePtr& response) {
+        if (ConnectionTable::find(connectionHandle) == NULL) {
+            response->invalidParameters("Unknown connection handle");
+            return;
+        }
+
         startProcedure<WaitForDataWrittenProcedure>(
             response,
             procedureTimeout,
@@ -664,6 +1093,487 @@ DECLARE_CMD(WaitForDataWrittenCommand) {
     };
 };
 
+
+DECLARE_CMD(CaptureDataWrittenCommand) {
+    CMD_NAME("captureDataWritten")
+
+    CMD_HELP("Record all the writes made by clients for a given time. The capture can be "
+             "restricted to a set of attribute handles passed after the timeout.")
+
+    CMD_ARGS(
+        CMD_ARG("uint32_t", "timeout", "Duration - in ms - of the capture")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("JSON Object", "", "Writes captured and capture counters"),
+        CMD_RESULT("JSON Array", "writes", "Writes captured, in order of reception"),
+        CMD_RESULT("uint16_t", "writes[].connection_handle", "The handle of the connection where the write occur"),
+        CMD_RESULT("uint16_t", "writes[].attribute_handle", "The handle of the attribute written"),
+        CMD_RESULT("GattWriteCallbackParams::WriteOp_t", "writes[].write_operation_type", "The type of write operation"),
+        CMD_RESULT("uint16_t", "writes[].offset", "Offset of the data written"),
+        CMD_RESULT("uint16_t", "writes[].length", "Length of the data written"),
+        CMD_RESULT("uint32_t", "writes[].timestamp", "Reception time - in us - relative to the start of the capture"),
+        CMD_RESULT("HexString", "writes[].data", "Data written, truncated if longer than the capture record"),
+        CMD_RESULT("uint32_t", "received", "Number of writes matching the handle set"),
+        CMD_RESULT("uint32_t", "dropped", "Number of writes dropped because the capture buffer was full")
+    )
+
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 1 + HandleSet::MAX_COUNT;
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        uint32_t timeout;
+        if(!fromString(args[0], timeout)) {
+            response->invalidParameters("The timeout is ill formed");
+            return;
+        }
+
+        HandleSet handles = { 0 };
+        for(std::size_t i = 1; i < args.count(); ++i) {
+            if(!fromString(args[i], handles.values[handles.count])) {
+                response->invalidParameters("An attribute handle is ill formed");
+                return;
+            }
+            ++handles.count;
+        }
+
+        startProcedure<CaptureDataWrittenProcedure>(response, timeout, handles);
+    }
+
+    struct HandleSet {
+        bool contains(GattAttribute::Handle_t handle) const {
+            // an empty set match all handles
+            if(count == 0) {
+                return true;
+            }
+
+            for(uint8_t i = 0; i < count; ++i) {
+                if(values[i] == handle) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static const uint8_t MAX_COUNT = 8;
+
+        uint8_t count;
+        GattAttribute::Handle_t values[MAX_COUNT];
+    };
+
+    /**
+     * Writes are copied in a fixed size buffer as they arrive and serialized
+     * once the capture is over.
+     */
+    struct CaptureDataWrittenProcedure : public AsyncProcedure {
+#ifndef BLE_CLIAPP_WRITE_CAPTURE_RECORD_COUNT
+        static const std::size_t RECORD_COUNT = 32;
+#else
+        static const std::size_t RECORD_COUNT = BLE_CLIAPP_WRITE_CAPTURE_RECORD_COUNT;
+#endif
+
+#ifndef BLE_CLIAPP_WRITE_CAPTURE_PAYLOAD_SIZE
+        static const std::size_t PAYLOAD_SIZE = 32;
+#else
+        static const std::size_t PAYLOAD_SIZE = BLE_CLIAPP_WRITE_CAPTURE_PAYLOAD_SIZE;
+#endif
+
+        typedef AttributeEventRecord<PAYLOAD_SIZE> WriteRecord;
+
+        CaptureDataWrittenProcedure(CommandResponsePtr& res, uint32_t procedureTimeout, const HandleSet& handleSet) :
+            AsyncProcedure(res, procedureTimeout), handles(handleSet), received(0), dropped(0) {
+        }
+
+        virtual ~CaptureDataWrittenProcedure() {
+            gattServer().onDataWritten().detach(makeFunctionPointer(this, &CaptureDataWrittenProcedure::whenDataWritten));
+        }
+
+        virtual bool doStart() {
+            timer.start();
+            gattServer().onDataWritten(this, &CaptureDataWrittenProcedure::whenDataWritten);
+            return true;
+        }
+
+        void whenDataWritten(const GattWriteCallbackParams* params) {
+            if(!handles.contains(params->handle)) {
+                return;
+            }
+
+            ++received;
+            if(records.full()) {
+                ++dropped;
+                return;
+            }
+
+            WriteRecord record;
+            record.set(
+                timer.read_us(), params->connHandle, params->handle,
+                params->writeOp, params->data, params->len, params->offset
+            );
+            records.push(record);
+        }
+
+        virtual void doWhenTimeout() {
+            using namespace serialization;
+
+            response->success();
+            serialization::JSONOutputStream& os = response->getResultStream();
+            os << startObject << key("writes") << startArray;
+
+            WriteRecord record;
+            while(records.pop(record)) {
+                os << startObject <<
+                    key("connection_handle") << record.connectionHandle <<
+                    key("attribute_handle") << record.attributeHandle <<
+                    key("write_operation_type") << (GattWriteCallbackParams::WriteOp_t) record.type <<
+                    key("offset") << record.offset <<
+                    key("length") << record.length <<
+                    key("timestamp") << record.timestamp <<
+                    key("data");
+                serializeRawDataToHexString(os, record.data, record.storedLength()) << endObject;
+            }
+
+            os << endArray <<
+                key("received") << received <<
+                key("dropped") << dropped <<
+            endObject;
+        }
+
+        HandleSet handles;
+        util::CircularBuffer<WriteRecord, RECORD_COUNT> records;
+        mbed::Timer timer;
+        uint32_t received;
+        uint32_t dropped;
+    };
+
+    ASYNC_PROCEDURE_FITS_POOL(CaptureDataWrittenProcedure);
+};
+
+/**
+ * @brief Description of the values pushed by the writeBurst command.
+ */
+struct WriteBurstDescription {
+    // maximum length of the values generated
+    static const uint16_t MAX_PATTERN_LENGTH = 512;
+
+    GattAttribute::Handle_t attributeHandle;
+    uint32_t count;
+    uint16_t period;
+    // length of the generated values, 0 if values are supplied
+    uint16_t patternLength;
+    // values supplied, stored one after the other
+    RawData_t values;
+    container::Vector<uint16_t> valuesLength;
+};
+
+
+DECLARE_CMD(WriteBurstCommand) {
+    CMD_NAME("writeBurst")
+
+    CMD_HELP("Write a sequence of values in an attribute of the GATT server; subscribed "
+             "clients are notified of each update. Values are either generated: "
+             "'pattern <length>' or supplied: 'values <value>...'. A period of 0 send "
+             "the values as fast as the stack accept them.")
+
+    CMD_ARGS(
+        CMD_ARG("uint16_t", "handle", "The handle of the attribute to write"),
+        CMD_ARG("uint32_t", "count", "The number of values to write"),
+        CMD_ARG("uint16_t", "period", "Time - in ms - between two writes, 0 to write as fast as possible"),
+        CMD_ARG("uint32_t", "timeout", "Maximum time - in ms - allowed for this procedure"),
+        CMD_ARG("String", "source", "pattern or values"),
+        CMD_ARG("uint16_t|HexString...", "source_args", "The length of the values generated or the list of values to write")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("uint32_t", "sent", "Number of values written"),
+        CMD_RESULT("uint64_t", "bytes", "Number of bytes written"),
+        CMD_RESULT("uint32_t", "tx_stalls", "Number of writes rejected because the stack TX buffers were full"),
+        CMD_RESULT("uint32_t", "duration", "Time - in ms - spent writing values"),
+        CMD_RESULT("uint32_t", "throughput", "Bytes written per second"),
+        CMD_RESULT("bool", "completed", "true if all the values have been written before the timeout")
+    )
+
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 0xFF;
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        WriteBurstDescription description;
+        uint32_t timeout;
+
+        if(!fromString(args[0], description.attributeHandle)) {
+            response->invalidParameters("The attribute handle is ill formed");
+            return;
+        }
+
+        if(!fromString(args[1], description.count) || description.count == 0) {
+            response->invalidParameters("The count is ill formed");
+            return;
+        }
+
+        if(!fromString(args[2], description.period)) {
+            response->invalidParameters("The period is ill formed");
+            return;
+        }
+
+        if(!fromString(args[3], timeout)) {
+            response->invalidParameters("The timeout is ill formed");
+            return;
+        }
+
+        description.patternLength = 0;
+        if(strcmp(args[4], "pattern") == 0) {
+            if(args.count() != 6 ||
+               !fromString(args[5], description.patternLength) ||
+               description.patternLength == 0 ||
+               description.patternLength > WriteBurstDescription::MAX_PATTERN_LENGTH) {
+                response->invalidParameters("pattern expect a length between 1 and 512");
+                return;
+            }
+        } else if(strcmp(args[4], "values") == 0) {
+            for(std::size_t i = 5; i < args.count(); ++i) {
+                RawData_t value = hexStringToRawData(args[i]);
+                if(value.size() == 0) {
+                    response->invalidParameters("A value to write is ill formed");
+                    return;
+                }
+                for(std::size_t j = 0; j < value.size(); ++j) {
+                    description.values.push_back(value[j]);
+                }
+                description.valuesLength.push_back(value.size());
+            }
+        } else {
+            response->invalidParameters("The source should be pattern or values");
+            return;
+        }
+
+        startProcedure<WriteBurstProcedure>(response, timeout, description);
+    }
+
+    /**
+     * Values are written from the event queue: either on a periodic event or,
+     * if no period is set, by chunks until the stack refuses a write; the
+     * procedure then waits for the onDataSent event to resume.
+     */
+    struct WriteBurstProcedure : public AsyncProcedure {
+        // maximum number of writes issued in a single event queue turn
+        static const uint8_t CHUNK_SIZE = 8;
+
+        WriteBurstProcedure(CommandResponsePtr& res, uint32_t procedureTimeout,
+            const WriteBurstDescription& burstDescription) :
+            AsyncProcedure(res, procedureTimeout),
+            description(burstDescription),
+            sendHandle(NULL), waitingTxBuffers(false),
+            valueIndex(0), valueOffset(0),
+            sent(0), bytes(0), txStalls(0) {
+        }
+
+        virtual ~WriteBurstProcedure() {
+            if(sendHandle) {
+                getCLICommandEventQueue()->cancel(sendHandle);
+            }
+            gattServer().onDataSent().detach(makeFunctionPointer(this, &WriteBurstProcedure::whenDataSent));
+        }
+
+        virtual bool doStart() {
+            timer.start();
+
+            if(!description.period) {
+                // without subscriber, onDataSent never resumes a stalled pump
+                if(!hasSubscriber()) {
+                    response->faillure("No client subscribed to the attribute");
+                    return false;
+                }
+
+                ble_error_t err = sendNext();
+                if(err && err != BLE_ERROR_NO_MEM && err != BLE_STACK_BUSY) {
+                    response->faillure(err);
+                    return false;
+                }
+
+                if(sent == description.count) {
+                    reportResults(true);
+                    return false;
+                }
+            }
+
+            gattServer().onDataSent(this, &WriteBurstProcedure::whenDataSent);
+
+            if(description.period) {
+                sendHandle = getCLICommandEventQueue()->post_every(
+                    &WriteBurstProcedure::tick, this, description.period
+                );
+            } else {
+                sendHandle = getCLICommandEventQueue()->post(&WriteBurstProcedure::pump, this);
+            }
+
+            if(!sendHandle) {
+                response->faillure("The event queue is full");
+                return false;
+            }
+
+            return true;
+        }
+
+        /*
+         * Return false if the attribute is the value of a characteristic
+         * committed with this module and no client has subscribed to it.
+         */
+        bool hasSubscriber() {
+            for(detail::RAIIGattService* service = gattServices; service; service = service->next()) {
+                for(uint8_t i = 0; i < service->getCharacteristicCount(); ++i) {
+                    GattCharacteristic* characteristic = service->getCharacteristic(i);
+                    if(characteristic->getValueHandle() != description.attributeHandle) {
+                        continue;
+                    }
+
+                    bool enabled = false;
+                    if(gattServer().areUpdatesEnabled(*characteristic, &enabled)) {
+                        return true;
+                    }
+                    return enabled;
+                }
+            }
+
+            // attributes declared elsewhere can't be checked
+            return true;
+        }
+
+        void tick() {
+            ble_error_t err = sendNext();
+            if(err == BLE_ERROR_NO_MEM || err == BLE_STACK_BUSY) {
+                // retry on next tick
+                return;
+            }
+
+            if(err) {
+                response->faillure(err);
+                terminate();
+            } else if(sent == description.count) {
+                reportResults(true);
+                terminate();
+            }
+        }
+
+        void pump() {
+            sendHandle = NULL;
+
+            for(uint8_t i = 0; i < CHUNK_SIZE; ++i) {
+                ble_error_t err = sendNext();
+                if(err == BLE_ERROR_NO_MEM || err == BLE_STACK_BUSY) {
+                    // resume once the stack has sent some data
+                    waitingTxBuffers = true;
+                    return;
+                }
+
+                if(err) {
+                    response->faillure(err);
+                    terminate();
+                    return;
+                }
+
+                if(sent == description.count) {
+                    reportResults(true);
+                    terminate();
+                    return;
+                }
+            }
+
+            // give a chance to other events to be processed
+            sendHandle = getCLICommandEventQueue()->post(&WriteBurstProcedure::pump, this);
+            if(!sendHandle) {
+                waitingTxBuffers = true;
+            }
+        }
+
+        void whenDataSent(unsigned) {
+            if(description.period || !waitingTxBuffers) {
+                return;
+            }
+
+            sendHandle = getCLICommandEventQueue()->post(&WriteBurstProcedure::pump, this);
+            if(sendHandle) {
+                waitingTxBuffers = false;
+            }
+        }
+
+        ble_error_t sendNext() {
+            const uint8_t* value;
+            uint16_t length;
+
+            if(description.patternLength) {
+                // the sequence number of the value followed by an incrementing pattern
+                for(uint16_t i = 0; i < description.patternLength; ++i) {
+                    patternBuffer[i] = (i < sizeof(sent)) ? (uint8_t) (sent >> (i * 8)) : (uint8_t) (sent + i);
+                }
+                value = patternBuffer;
+                length = description.patternLength;
+            } else {
+                value = description.values.begin() + valueOffset;
+                length = description.valuesLength[valueIndex];
+            }
+
+            ble_error_t err = gattServer().write(description.attributeHandle, value, length);
+            if(err == BLE_ERROR_NO_MEM || err == BLE_STACK_BUSY) {
+                ++txStalls;
+                return err;
+            }
+
+            if(err) {
+                return err;
+            }
+
+            ++sent;
+            bytes += length;
+
+            if(!description.patternLength) {
+                valueOffset += length;
+                ++valueIndex;
+                if(valueIndex == description.valuesLength.size()) {
+                    valueIndex = 0;
+                    valueOffset = 0;
+                }
+            }
+
+            return BLE_ERROR_NONE;
+        }
+
+        void reportResults(bool completed) {
+            using namespace serialization;
+
+            uint32_t duration = timer.read_ms();
+            uint32_t throughput = duration ? (uint32_t) ((bytes * 1000) / duration) : 0;
+
+            response->success();
+            response->getResultStream() << startObject <<
+                key("sent") << sent <<
+                key("bytes") << bytes <<
+                key("tx_stalls") << txStalls <<
+                key("duration") << duration <<
+                key("throughput") << throughput <<
+                key("completed") << completed <<
+            endObject;
+        }
+
+        virtual void doWhenTimeout() {
+            reportResults(false);
+        }
+
+        WriteBurstDescription description;
+        uint8_t patternBuffer[WriteBurstDescription::MAX_PATTERN_LENGTH];
+        mbed::Timer timer;
+        eq::EventQueue::event_handle_t sendHandle;
+        bool waitingTxBuffers;
+        std::size_t valueIndex;
+        std::size_t valueOffset;
+        uint32_t sent;
+        uint64_t bytes;
+        uint32_t txStalls;
+    };
+};
 } // end of annonymous namespace
 
 
@@ -681,7 +1591,10 @@ DECLARE_SUITE_COMMANDS(GattServerCommandSuiteDescription,
     CMD_INSTANCE(SetDescriptorMaxLengthCommand),
     CMD_INSTANCE(CommitServiceCommand),
     CMD_INSTANCE(CancelServiceDeclarationCommand),
+    CMD_INSTANCE(ImportServiceCommand),
     CMD_INSTANCE(ReadCommand),
     CMD_INSTANCE(WriteCommand),
-    CMD_INSTANCE(WaitForDataWrittenCommand)
+    CMD_INSTANCE(WaitForDataWrittenCommand),
+    CMD_INSTANCE(CaptureDataWrittenCommand),
+    CMD_INSTANCE(WriteBurstCommand)
 )
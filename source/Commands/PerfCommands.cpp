@@ -0,0 +1,273 @@
+#include "util/Perf.h"
+
+#if defined(ENABLE_PERF_INSTRUMENTATION)
+
+#include "Serialization/Serializer.h"
+#include "CLICommand/CommandHelper.h"
+
+#include "PerfCommands.h"
+
+using namespace serialization;
+
+// isolation
+namespace {
+
+DECLARE_CMD(DumpCommand) {
+    CMD_NAME("dump")
+
+    CMD_HELP(
+        "Return the histogram of each probe. Probes may nest: handler "
+        "execution includes argument parsing."
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("string", "unit", "Unit of the measures: cycles, us or ns."),
+        CMD_RESULT("JSON Array", "probes", "Histogram of each probe."),
+        CMD_RESULT("string", "probes[x].name", "Name of the probe."),
+        CMD_RESULT("uint32_t", "probes[x].count", "Number of measures."),
+        CMD_RESULT("uint32_t", "probes[x].min", "Shortest measure."),
+        CMD_RESULT("uint32_t", "probes[x].mean", "Mean of the measures."),
+        CMD_RESULT("uint32_t", "probes[x].max", "Longest measure."),
+        CMD_RESULT("uint32_t", "probes[x].p50", "Upper bound of the median."),
+        CMD_RESULT("uint32_t", "probes[x].p99", "Upper bound of the 99th percentile."),
+        CMD_RESULT("JSON Array", "probes[x].buckets", "Number of measures in each bucket, bucket i holds measures in the range [2^(i - 1), 2^i - 1].")
+    )
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        JSONOutputStream& os = response->getResultStream();
+        os << startObject <<
+            key("unit") << perf::unit() <<
+            key("probes") << startArray;
+
+        for (std::size_t i = 0; i < perf::PROBE_COUNT; ++i) {
+            perf::probe_t probe = static_cast<perf::probe_t>(i);
+            const perf::histogram_t& histogram = perf::histogram(probe);
+
+            os << startObject <<
+                key("name") << perf::name(probe) <<
+                key("count") << histogram.count() <<
+                key("min") << histogram.min() <<
+                key("mean") << histogram.mean() <<
+                key("max") << histogram.max() <<
+                key("p50") << histogram.percentile(50) <<
+                key("p99") << histogram.percentile(99) <<
+                key("buckets") << startArray;
+
+            // trailing empty buckets are not reported
+            std::size_t bucketCount = histogram.bucketCount();
+            while (bucketCount && histogram.bucket(bucketCount - 1) == 0) {
+                --bucketCount;
+            }
+            for (std::size_t j = 0; j < bucketCount; ++j) {
+                os << histogram.bucket(j);
+            }
+
+            os << endArray << endObject;
+        }
+
+        os << endArray << endObject;
+        response->success();
+    }
+};
+
+static uint32_t meanOf(uint64_t sum, uint32_t count) {
+    return count ? (uint32_t) (sum / count) : 0;
+}
+
+DECLARE_CMD(CommandsCommand) {
+    CMD_NAME("commands")
+
+    CMD_HELP(
+        "Return the latency of each command traced, from the reception of its "
+        "line to the closing of its response. The latency is split in exclusive "
+        "phases: parse, handler, async wait and output."
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("string", "unit", "Unit of the measures: always us."),
+        CMD_RESULT("uint32_t", "dropped", "Invocations not accounted because the command table was full."),
+        CMD_RESULT("JSON Array", "commands", "Latency of each command."),
+        CMD_RESULT("string", "commands[x].module", "Module of the command."),
+        CMD_RESULT("string", "commands[x].name", "Name of the command."),
+        CMD_RESULT("uint32_t", "commands[x].count", "Number of invocations."),
+        CMD_RESULT("uint32_t", "commands[x].min", "Shortest latency."),
+        CMD_RESULT("uint32_t", "commands[x].mean", "Mean latency."),
+        CMD_RESULT("uint32_t", "commands[x].max", "Longest latency."),
+        CMD_RESULT("uint32_t", "commands[x].p50", "Upper bound of the median latency."),
+        CMD_RESULT("uint32_t", "commands[x].p99", "Upper bound of the 99th percentile of the latency."),
+        CMD_RESULT("uint32_t", "commands[x].parse", "Mean time spent looking up the command and decoding its arguments."),
+        CMD_RESULT("uint32_t", "commands[x].handler", "Mean time spent in the handler."),
+        CMD_RESULT("uint32_t", "commands[x].async_wait", "Mean time between the return of the handler and the closing of the response."),
+        CMD_RESULT("uint32_t", "commands[x].output", "Mean time spent writing JSON output.")
+    )
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        JSONOutputStream& os = response->getResultStream();
+        os << startObject <<
+            key("unit") << "us" <<
+            key("dropped") << perf::droppedCommands() <<
+            key("commands") << startArray;
+
+        for (std::size_t i = 0; i < perf::commandCount(); ++i) {
+            const perf::CommandStatistics& statistics = perf::commandStatistics(i);
+            const perf::histogram_t& latency = statistics.latency;
+            uint32_t count = latency.count();
+
+            os << startObject <<
+                key("module") << statistics.module <<
+                key("name") << statistics.name <<
+                key("count") << count <<
+                key("min") << latency.min() <<
+                key("mean") << latency.mean() <<
+                key("max") << latency.max() <<
+                key("p50") << latency.percentile(50) <<
+                key("p99") << latency.percentile(99) <<
+                key("parse") << meanOf(statistics.parse, count) <<
+                key("handler") << meanOf(statistics.handler, count) <<
+                key("async_wait") << meanOf(statistics.asyncWait, count) <<
+                key("output") << meanOf(statistics.output, count) <<
+            endObject;
+        }
+
+        os << endArray << endObject;
+        response->success();
+    }
+};
+
+DECLARE_CMD(MemoryCommand) {
+    CMD_NAME("memory")
+
+    CMD_HELP(
+        "Return the heap and stack consumed by each command traced. Heap "
+        "statistics require MBED_HEAP_STATS_ENABLED and stack high-water marks "
+        "require the RTOS. The stack is measured when the handler returns."
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("bool", "heap_statistics", "True if heap statistics are recorded."),
+        CMD_RESULT("bool", "stack_painting", "True if stack high-water marks are recorded."),
+        CMD_RESULT("uint32_t", "heap_budget", "Heap budget of an invocation in bytes, 0 if disabled."),
+        CMD_RESULT("uint32_t", "stack_budget", "Stack budget of an invocation in bytes, 0 if disabled."),
+        CMD_RESULT("JSON Array", "commands", "Memory consumed by each command."),
+        CMD_RESULT("string", "commands[x].module", "Module of the command."),
+        CMD_RESULT("string", "commands[x].name", "Name of the command."),
+        CMD_RESULT("uint32_t", "commands[x].count", "Number of invocations."),
+        CMD_RESULT("uint32_t", "commands[x].heap_peak", "Greatest heap growth, in bytes, during an invocation."),
+        CMD_RESULT("uint32_t", "commands[x].heap_allocated", "Mean number of bytes allocated by an invocation."),
+        CMD_RESULT("int32_t", "commands[x].heap_outstanding", "Allocations still alive once the invocations have completed."),
+        CMD_RESULT("uint32_t", "commands[x].stack_high_water", "Greatest stack depth, in bytes, reached by the parsing and the handler."),
+        CMD_RESULT("uint32_t", "commands[x].over_budget", "Invocations which exceeded the heap or the stack budget.")
+    )
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        JSONOutputStream& os = response->getResultStream();
+        os << startObject <<
+            key("heap_statistics") << perf::heapStatisticsEnabled() <<
+            key("stack_painting") << perf::stackPaintingEnabled() <<
+            key("heap_budget") << perf::HEAP_BUDGET <<
+            key("stack_budget") << perf::STACK_BUDGET <<
+            key("commands") << startArray;
+
+        for (std::size_t i = 0; i < perf::commandCount(); ++i) {
+            const perf::CommandStatistics& statistics = perf::commandStatistics(i);
+            uint32_t count = statistics.latency.count();
+
+            os << startObject <<
+                key("module") << statistics.module <<
+                key("name") << statistics.name <<
+                key("count") << count <<
+                key("heap_peak") << statistics.heapPeak <<
+                key("heap_allocated") << meanOf(statistics.heapAllocated, count) <<
+                key("heap_outstanding") << statistics.heapOutstanding <<
+                key("stack_high_water") << statistics.stackHighWater <<
+                key("over_budget") << statistics.overBudget <<
+            endObject;
+        }
+
+        os << endArray << endObject;
+        response->success();
+    }
+};
+
+DECLARE_CMD(CheckBudgetsCommand) {
+    CMD_NAME("checkBudgets")
+
+    CMD_HELP(
+        "Check the memory budgets of the commands traced; the command fails if "
+        "an invocation exceeded BLE_CLIAPP_PERF_HEAP_BUDGET or "
+        "BLE_CLIAPP_PERF_STACK_BUDGET. Disabled budgets always pass."
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("uint32_t", "heap_budget", "Heap budget of an invocation in bytes, 0 if disabled."),
+        CMD_RESULT("uint32_t", "stack_budget", "Stack budget of an invocation in bytes, 0 if disabled."),
+        CMD_RESULT("JSON Array", "over_budget", "Commands with invocations over budget."),
+        CMD_RESULT("string", "over_budget[x].module", "Module of the command."),
+        CMD_RESULT("string", "over_budget[x].name", "Name of the command."),
+        CMD_RESULT("uint32_t", "over_budget[x].count", "Invocations which exceeded the heap or the stack budget."),
+        CMD_RESULT("uint32_t", "over_budget[x].heap_peak", "Greatest heap growth, in bytes, during an invocation."),
+        CMD_RESULT("uint32_t", "over_budget[x].stack_high_water", "Greatest stack depth, in bytes, reached by the parsing and the handler.")
+    )
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        bool overBudget = false;
+        for (std::size_t i = 0; i < perf::commandCount(); ++i) {
+            if (perf::commandStatistics(i).overBudget) {
+                overBudget = true;
+            }
+        }
+
+        if (overBudget) {
+            response->faillure();
+        } else {
+            response->success();
+        }
+
+        JSONOutputStream& os = response->getResultStream();
+        os << startObject <<
+            key("heap_budget") << perf::HEAP_BUDGET <<
+            key("stack_budget") << perf::STACK_BUDGET <<
+            key("over_budget") << startArray;
+
+        for (std::size_t i = 0; i < perf::commandCount(); ++i) {
+            const perf::CommandStatistics& statistics = perf::commandStatistics(i);
+            if (statistics.overBudget == 0) {
+                continue;
+            }
+
+            os << startObject <<
+                key("module") << statistics.module <<
+                key("name") << statistics.name <<
+                key("count") << statistics.overBudget <<
+                key("heap_peak") << statistics.heapPeak <<
+                key("stack_high_water") << statistics.stackHighWater <<
+            endObject;
+        }
+
+        os << endArray << endObject;
+    }
+};
+
+DECLARE_CMD(ResetCommand) {
+    CMD_NAME("reset")
+
+    CMD_HELP("Reset the histogram of every probe and the latency of every command.")
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        perf::reset();
+        response->success();
+    }
+};
+
+} // end of annonymous namespace
+
+
+DECLARE_SUITE_COMMANDS(PerfCommandSuiteDescription,
+    CMD_INSTANCE(DumpCommand),
+    CMD_INSTANCE(CommandsCommand),
+    CMD_INSTANCE(MemoryCommand),
+    CMD_INSTANCE(CheckBudgetsCommand),
+    CMD_INSTANCE(ResetCommand)
+)
+
+#endif // defined(ENABLE_PERF_INSTRUMENTATION)
@@ -0,0 +1,25 @@
+#ifndef BLE_CLIAPP_PERF_COMMANDS_H_
+#define BLE_CLIAPP_PERF_COMMANDS_H_
+
+#include "CLICommand/CommandSuite.h"
+
+class PerfCommandSuiteDescription {
+
+public:
+    static const char* name() {
+        return "perf";
+    }
+
+    static const char* info() {
+        return "Histograms of the time spent in the hot paths of the application";
+    }
+
+    static const char* man() {
+        return "perf <command> <command arguments>.";
+    }
+
+    // see implementation
+    static ConstArray<const Command*> commands();
+};
+
+#endif //BLE_CLIAPP_PERF_COMMANDS_H_
@@ -23,15 +23,33 @@ bool asciiHexByteToByte(char msb, char lsb, uint8_t& result) {
 
 serialization::JSONOutputStream& serializeRawDataToHexString(serialization::JSONOutputStream& os, const uint8_t* data, size_t length) {
     os.put('"');
-    for (size_t i = 0; i < length; ++i) {
-        os.format("%02X", data[i]);
-    }
+    writeHexDigits(os, data, length);
     os.put('"');
     os.commitValue();
 
     return os;
 }
 
+void writeHexDigits(serialization::JSONOutputStream& os, const uint8_t* data, size_t length) {
+    static const char digits[] = "0123456789ABCDEF";
+
+    // digits are written by blocks rather than one character at a time
+    char buffer[32];
+    size_t count = 0;
+    for (size_t i = 0; i < length; ++i) {
+        buffer[count++] = digits[data[i] >> 4];
+        buffer[count++] = digits[data[i] & 0x0F];
+        if (count == sizeof(buffer)) {
+            os.write(buffer, count);
+            count = 0;
+        }
+    }
+
+    if (count) {
+        os.write(buffer, count);
+    }
+}
+
 container::Vector<uint8_t> hexStringToRawData(const char* data) {
     container::Vector<uint8_t> result;
 
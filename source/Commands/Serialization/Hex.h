@@ -27,6 +27,15 @@ bool asciiHexByteToByte(char msb, char lsb, uint8_t& result);
  */
 serialization::JSONOutputStream& serializeRawDataToHexString(serialization::JSONOutputStream& os, const uint8_t* data, std::size_t length);
 
+/**
+ * @brief Write the hexadecimal digits of an array of bytes without quotes and
+ * without committing a value; it allows a string to be written in several parts.
+ *
+ * @param data The data to convert
+ * @param length The length of the data to convert
+ */
+void writeHexDigits(serialization::JSONOutputStream& os, const uint8_t* data, std::size_t length);
+
 /**
  * @brief Convert the string representation of bytes in ascii hexadecimal to
  * an array of bytes.
@@ -0,0 +1,68 @@
+#ifndef BLE_CLIAPP_UTIL_ATTRIBUTE_EVENT_RECORD_
+#define BLE_CLIAPP_UTIL_ATTRIBUTE_EVENT_RECORD_
+
+#include <stdint.h>
+#include <cstddef>
+#include <algorithm>
+
+/**
+ * @brief Fixed size record of an event applied to an attribute value
+ * (notification, indication, write, ...).
+ * @details Records are meant to be copied from BLE stack callbacks into
+ * preallocated storage and serialized later, out of the callback. Payloads
+ * larger than PayloadCapacity are truncated, length still holds the length
+ * of the original payload.
+ *
+ * @tparam PayloadCapacity The maximum number of payload bytes kept in the record.
+ */
+template<std::size_t PayloadCapacity>
+struct AttributeEventRecord {
+
+    /**
+     * @brief Fill the record.
+     *
+     * @param eventTimestamp Time at which the event was received, in microseconds.
+     * @param eventConnectionHandle Connection on which the event was received.
+     * @param eventAttributeHandle Attribute targeted by the event.
+     * @param eventType Type of the event, its meaning depends on the record owner.
+     * @param eventData Payload of the event.
+     * @param eventLength Length of the payload.
+     * @param eventOffset Offset of the payload in the attribute value.
+     */
+    void set(
+        uint32_t eventTimestamp, uint16_t eventConnectionHandle, uint16_t eventAttributeHandle,
+        uint8_t eventType, const uint8_t* eventData, uint16_t eventLength, uint16_t eventOffset = 0
+    ) {
+        timestamp = eventTimestamp;
+        connectionHandle = eventConnectionHandle;
+        attributeHandle = eventAttributeHandle;
+        type = eventType;
+        offset = eventOffset;
+        length = eventLength;
+        std::copy(eventData, eventData + storedLength(), data);
+    }
+
+    /**
+     * @brief Number of bytes of the payload held by the record.
+     */
+    uint16_t storedLength() const {
+        return std::min<uint16_t>(length, PayloadCapacity);
+    }
+
+    /**
+     * @brief Return true if the payload has been truncated.
+     */
+    bool truncated() const {
+        return length > PayloadCapacity;
+    }
+
+    uint32_t timestamp;
+    uint16_t connectionHandle;
+    uint16_t attributeHandle;
+    uint16_t offset;
+    uint16_t length;
+    uint8_t type;
+    uint8_t data[PayloadCapacity];
+};
+
+#endif //BLE_CLIAPP_UTIL_ATTRIBUTE_EVENT_RECORD_
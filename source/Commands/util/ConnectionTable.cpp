@@ -0,0 +1,181 @@
+#include <string.h>
+#include "ConnectionTable.h"
+
+#ifdef YOTTA_CFG
+#include "mbed-drivers/Timer.h"
+#else
+#include "Timer.h"
+#endif
+
+namespace {
+
+// default ATT MTU of a connection
+static const uint16_t DEFAULT_ATT_MTU = 23;
+
+mbed::Timer& clock() {
+    static mbed::Timer timer;
+    static bool started = false;
+    if (!started) {
+        timer.start();
+        started = true;
+    }
+    return timer;
+}
+
+/*
+ * ATT MTU changes are reported by the event handlers of the GattClient and
+ * GattServer.
+ */
+struct ClientMtuHandler : GattClient::EventHandler {
+    virtual void onAttMtuChange(ble::connection_handle_t connectionHandle, uint16_t attMtuSize) {
+        ConnectionTable::Entry* entry = ConnectionTable::find(connectionHandle);
+        if (entry) {
+            entry->attMtu = attMtuSize;
+        }
+    }
+};
+
+struct ServerMtuHandler : GattServer::EventHandler {
+    virtual void onAttMtuChange(ble::connection_handle_t connectionHandle, uint16_t attMtuSize) {
+        ConnectionTable::Entry* entry = ConnectionTable::find(connectionHandle);
+        if (entry) {
+            entry->attMtu = attMtuSize;
+        }
+    }
+};
+
+} // end of anonymous namespace
+
+ConnectionTable::Entry ConnectionTable::_entries[ConnectionTable::CAPACITY];
+
+void ConnectionTable::attach() {
+    static ClientMtuHandler clientMtuHandler;
+    static ServerMtuHandler serverMtuHandler;
+
+    for (std::size_t i = 0; i < CAPACITY; ++i) {
+        _entries[i].used = false;
+    }
+
+    Gap& gap = BLE::Instance().gap();
+    gap.onConnection().detach(whenConnected);
+    gap.onConnection(whenConnected);
+    gap.onDisconnection().detach(whenDisconnected);
+    gap.onDisconnection(whenDisconnected);
+
+    GattClient& client = BLE::Instance().gattClient();
+    client.onHVX().detach(whenHVXReceived);
+    client.onHVX(whenHVXReceived);
+    client.setEventHandler(&clientMtuHandler);
+
+    GattServer& server = BLE::Instance().gattServer();
+    server.onDataWritten().detach(whenDataWritten);
+    server.onDataWritten(whenDataWritten);
+    server.setEventHandler(&serverMtuHandler);
+}
+
+ConnectionTable::Entry* ConnectionTable::find(Gap::Handle_t handle) {
+    for (std::size_t i = 0; i < CAPACITY; ++i) {
+        if (_entries[i].used && _entries[i].handle == handle) {
+            return &_entries[i];
+        }
+    }
+    return NULL;
+}
+
+const ConnectionTable::Entry& ConnectionTable::at(std::size_t index) {
+    return _entries[index];
+}
+
+std::size_t ConnectionTable::count() {
+    std::size_t result = 0;
+    for (std::size_t i = 0; i < CAPACITY; ++i) {
+        if (_entries[i].used) {
+            ++result;
+        }
+    }
+    return result;
+}
+
+uint32_t ConnectionTable::connectionDuration(const Entry& entry) {
+    return (uint32_t) clock().read_ms() - entry.connectedAt;
+}
+
+bool ConnectionTable::registerGattProcedure(Gap::Handle_t handle) {
+    Entry* entry = find(handle);
+    if (!entry) {
+        return false;
+    }
+    ++entry->gattProcedures;
+    return true;
+}
+
+void ConnectionTable::updateConnectionParameters(
+    Gap::Handle_t handle, uint16_t interval, uint16_t latency, uint16_t supervisionTimeout
+) {
+    Entry* entry = find(handle);
+    if (entry) {
+        entry->interval = interval;
+        entry->latency = latency;
+        entry->supervisionTimeout = supervisionTimeout;
+    }
+}
+
+void ConnectionTable::updatePhy(Gap::Handle_t handle, ble::phy_t txPhy, ble::phy_t rxPhy) {
+    Entry* entry = find(handle);
+    if (entry) {
+        entry->txPhy = txPhy.value();
+        entry->rxPhy = rxPhy.value();
+    }
+}
+
+void ConnectionTable::whenConnected(const Gap::ConnectionCallbackParams_t* params) {
+    // reuse the entry of a connection whose disconnection has been missed
+    Entry* entry = find(params->handle);
+
+    for (std::size_t i = 0; (entry == NULL) && (i < CAPACITY); ++i) {
+        if (!_entries[i].used) {
+            entry = &_entries[i];
+        }
+    }
+
+    if (entry == NULL) {
+        return;
+    }
+
+    memset(entry, 0, sizeof(Entry));
+    entry->handle = params->handle;
+    entry->role = params->role;
+    entry->peerAddressType = params->peerAddrType;
+    memcpy(entry->peerAddress, params->peerAddr, sizeof(entry->peerAddress));
+    if (params->connectionParams) {
+        entry->interval = params->connectionParams->maxConnectionInterval;
+        entry->latency = params->connectionParams->slaveLatency;
+        entry->supervisionTimeout = params->connectionParams->connectionSupervisionTimeout;
+    }
+    entry->attMtu = DEFAULT_ATT_MTU;
+    entry->txPhy = ble::phy_t::LE_1M;
+    entry->rxPhy = ble::phy_t::LE_1M;
+    entry->connectedAt = clock().read_ms();
+    entry->used = true;
+}
+
+void ConnectionTable::whenDisconnected(const Gap::DisconnectionCallbackParams_t* params) {
+    Entry* entry = find(params->handle);
+    if (entry) {
+        entry->used = false;
+    }
+}
+
+void ConnectionTable::whenHVXReceived(const GattHVXCallbackParams* params) {
+    Entry* entry = find(params->connHandle);
+    if (entry) {
+        ++entry->hvxReceived;
+    }
+}
+
+void ConnectionTable::whenDataWritten(const GattWriteCallbackParams* params) {
+    Entry* entry = find(params->connHandle);
+    if (entry) {
+        ++entry->writesReceived;
+    }
+}
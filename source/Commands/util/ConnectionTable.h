@@ -0,0 +1,112 @@
+#ifndef BLE_CLIAPP_UTIL_CONNECTION_TABLE_
+#define BLE_CLIAPP_UTIL_CONNECTION_TABLE_
+
+#include <stdint.h>
+#include <cstddef>
+#include "ble/BLE.h"
+
+/**
+ * @brief Table of the live connections of the device.
+ * @details The table is updated from the connection and disconnection events
+ * of Gap; it also tracks the connection parameters, PHY, ATT MTU and activity
+ * of each connection. Callbacks registered by the table are released when the
+ * BLE instance is shutdown, attach must be called once the instance has been
+ * initialized.
+ */
+class ConnectionTable {
+public:
+    /**
+     * @brief State of a connection.
+     */
+    struct Entry {
+        Gap::Handle_t handle;
+        Gap::Role_t role;
+        BLEProtocol::AddressType_t peerAddressType;
+        BLEProtocol::AddressBytes_t peerAddress;
+        uint16_t interval;
+        uint16_t latency;
+        uint16_t supervisionTimeout;
+        uint16_t attMtu;
+        uint8_t txPhy;
+        uint8_t rxPhy;
+        uint32_t connectedAt;
+        uint32_t hvxReceived;
+        uint32_t writesReceived;
+        uint32_t gattProcedures;
+        bool used;
+    };
+
+    // By default, the table holds every connection a multi-peer connection
+    // procedure can establish or, if its count is not set, every connection
+    // the BLE stack accepts.
+#if defined(BLE_CLIAPP_CONNECTION_TABLE_SIZE)
+    static const std::size_t CAPACITY = BLE_CLIAPP_CONNECTION_TABLE_SIZE;
+#elif defined(BLE_CLIAPP_GAP_MULTI_CONNECT_PEER_COUNT)
+    static const std::size_t CAPACITY = BLE_CLIAPP_GAP_MULTI_CONNECT_PEER_COUNT;
+#elif defined(MBED_CONF_CORDIO_MAX_CONNECTIONS)
+    static const std::size_t CAPACITY = MBED_CONF_CORDIO_MAX_CONNECTIONS;
+#elif defined(NRF_SDH_BLE_TOTAL_LINK_COUNT)
+    static const std::size_t CAPACITY = NRF_SDH_BLE_TOTAL_LINK_COUNT;
+#elif defined(CENTRAL_LINK_COUNT) && defined(PERIPHERAL_LINK_COUNT)
+    static const std::size_t CAPACITY = CENTRAL_LINK_COUNT + PERIPHERAL_LINK_COUNT;
+#else
+    static const std::size_t CAPACITY = 4;
+#endif
+
+    /**
+     * @brief Clear the table and register the callbacks which maintain it.
+     */
+    static void attach();
+
+    /**
+     * @brief Return the entry of a live connection or NULL if the connection
+     * is unknown.
+     */
+    static Entry* find(Gap::Handle_t handle);
+
+    /**
+     * @brief Access an entry of the table, entries not in use have their
+     * used field set to false.
+     */
+    static const Entry& at(std::size_t index);
+
+    /**
+     * @brief Number of live connections.
+     */
+    static std::size_t count();
+
+    /**
+     * @brief Time in ms elapsed since the connection has been established.
+     */
+    static uint32_t connectionDuration(const Entry& entry);
+
+    /**
+     * @brief Account a GATT procedure started on a connection. It is called
+     * once the stack has accepted the procedure.
+     *
+     * @return false if the connection is unknown.
+     */
+    static bool registerGattProcedure(Gap::Handle_t handle);
+
+    /**
+     * @brief Update the connection parameters of a connection.
+     */
+    static void updateConnectionParameters(
+        Gap::Handle_t handle, uint16_t interval, uint16_t latency, uint16_t supervisionTimeout
+    );
+
+    /**
+     * @brief Update the PHY used by a connection.
+     */
+    static void updatePhy(Gap::Handle_t handle, ble::phy_t txPhy, ble::phy_t rxPhy);
+
+private:
+    static void whenConnected(const Gap::ConnectionCallbackParams_t* params);
+    static void whenDisconnected(const Gap::DisconnectionCallbackParams_t* params);
+    static void whenHVXReceived(const GattHVXCallbackParams* params);
+    static void whenDataWritten(const GattWriteCallbackParams* params);
+
+    static Entry _entries[CAPACITY];
+};
+
+#endif //BLE_CLIAPP_UTIL_CONNECTION_TABLE_
@@ -10,30 +10,54 @@
 #include "detail/RAIIGattCharacteristic.h"
 #include "detail/RAIIGattService.h"
 
+/**
+ * @brief Build a service step by step. The declaration is allocated in the
+ * arena of the service being built and the values in its arena of values.
+ */
 class ServiceBuilder {
 
 public:
-    ServiceBuilder(const UUID& uuid) :
-        service(new detail::RAIIGattService(uuid)), currentCharacteristic(NULL), currentDescriptor(NULL) {
+    /**
+     * @param arenaSize Size of the first chunk of the arena holding the
+     * declaration, 0 selects the default size; see RAIIGattService::create.
+     * @param valuesSize Size of the first chunk of the arena holding the
+     * values, 0 selects the default size.
+     */
+    ServiceBuilder(const UUID& uuid, std::size_t arenaSize = 0, std::size_t valuesSize = 0) :
+        service(detail::RAIIGattService::create(uuid, arenaSize, valuesSize)), currentCharacteristic(NULL), currentDescriptor(NULL) {
     }
 
     ~ServiceBuilder() {
-        delete service;
-        delete currentCharacteristic;
-        delete currentDescriptor;
+        if(service) {
+            detail::RAIIGattService::destroy(service);
+        }
+    }
+
+    /**
+     * @brief Return false if the service couldn't be allocated.
+     */
+    bool isValid() const {
+        return service != NULL;
     }
 
-    void declareCharacteristic(const UUID& characteristicUUID) {
-        commit();
-        currentCharacteristic = new detail::RAIIGattCharacteristic(characteristicUUID);
+    bool declareCharacteristic(const UUID& characteristicUUID) {
+        currentDescriptor = NULL;
+        currentCharacteristic = service->declareCharacteristic(characteristicUUID);
+        return currentCharacteristic != NULL;
     }
 
     bool setCharacteristicValue(const container::Vector<uint8_t>& characteristicValue) {
         if(!currentCharacteristic) {
             return false;
         }
-        currentCharacteristic->setValue(characteristicValue);
-        return true;
+        return currentCharacteristic->setValue(characteristicValue, service->valuesArena());
+    }
+
+    bool setCharacteristicValue(const uint8_t* characteristicValue, uint16_t length) {
+        if(!currentCharacteristic) {
+            return false;
+        }
+        return currentCharacteristic->setValue(characteristicValue, length, service->valuesArena());
     }
 
     bool setCharacteristicProperties(uint8_t properties) {
@@ -72,21 +96,24 @@ public:
             return false;
         }
 
-        if(currentDescriptor) {
-            currentCharacteristic->addDescriptor(currentDescriptor);
+        currentDescriptor = service->declareDescriptor(currentCharacteristic, descriptorUUID);
+        return currentDescriptor != NULL;
+    }
+
+    bool setDescriptorValue(const container::Vector<uint8_t>& descriptorValue) {
+        if(!currentCharacteristic || !currentDescriptor) {
+            return false;
         }
 
-        currentDescriptor = new detail::RAIIGattAttribute(descriptorUUID);
-        return true;
+        return currentDescriptor->setValue(descriptorValue, service->valuesArena());
     }
 
-    bool setDescriptorValue(const container::Vector<uint8_t>& descriptorValue) {
+    bool setDescriptorValue(const uint8_t* descriptorValue, uint16_t length) {
         if(!currentCharacteristic || !currentDescriptor) {
             return false;
         }
 
-        currentDescriptor->setValue(descriptorValue);
-        return true;
+        return currentDescriptor->setValue(descriptorValue, length, service->valuesArena());
     }
 
     bool setDescriptorVariableLength(bool variableLen) {
@@ -106,23 +133,24 @@ public:
         return currentDescriptor->setMaxLength(maxLen);
     }
 
+    /**
+     * @brief Complete the service declaration and release its ownership.
+     * @return The service declared or NULL if the declaration couldn't be
+     * completed. Once released, the service should be destroyed with
+     * detail::RAIIGattService::destroy.
+     */
     detail::RAIIGattService* release() {
+        if(!service->bindCharacteristics()) {
+            return NULL;
+        }
+
         detail::RAIIGattService* toReturn = service;
         service = NULL;
+        currentCharacteristic = NULL;
+        currentDescriptor = NULL;
         return toReturn;
     }
 
-    void commit() {
-        if(currentCharacteristic) {
-            if(currentDescriptor) {
-                currentCharacteristic->addDescriptor(currentDescriptor);
-                currentDescriptor = NULL;
-            }
-            service->addCharacteristic(currentCharacteristic);
-            currentCharacteristic = NULL;
-        }
-    }
-
 private:
     ServiceBuilder(const ServiceBuilder&);
     ServiceBuilder& operator=(const ServiceBuilder&);
@@ -9,35 +9,43 @@ HIJACK_MEMBER(_hasVariableLen_accessor, bool GattAttribute::*, &GattAttribute::_
 namespace detail {
 
 RAIIGattAttribute::RAIIGattAttribute(const UUID& uuid)  :
-    GattAttribute(uuid, NULL, 0, 0, true) {
+    GattAttribute(uuid, NULL, 0, 0, true), _valueCapacity(0), _next(NULL) {
 }
 
 RAIIGattAttribute::~RAIIGattAttribute() {
-    if(this->*_valuePtr_accessor) {
-        delete[] (this->*_valuePtr_accessor);
-    }
+    // the value is owned by the arena of the service
+}
+
+bool RAIIGattAttribute::setValue(const container::Vector<uint8_t>& newValue, util::BumpArena& arena) {
+    return setValue(newValue.cbegin(), newValue.size(), arena);
 }
 
-void RAIIGattAttribute::setValue(const container::Vector<uint8_t>& newValue) {
+bool RAIIGattAttribute::setValue(const uint8_t* newValue, uint16_t length, util::BumpArena& arena) {
     uint8_t*& valuePtr = (this->*_valuePtr_accessor);
     uint16_t& len = this->*_len_accessor;
     uint16_t& maxLen = this->*_lenMax_accessor;
 
-    if(valuePtr) {
-        delete[] valuePtr;
-        valuePtr = NULL;
-        len = 0;
+    // a value which fits in the storage of the previous one reuses it, the
+    // storage of a shorter previous value remains in the arena until it is released
+    if(length > _valueCapacity) {
+        uint8_t* storage = static_cast<uint8_t*>(arena.allocate(length));
+        if(!storage) {
+            return false;
+        }
+        valuePtr = storage;
+        _valueCapacity = length;
     }
 
-    if(newValue.size()) {
-        valuePtr = new uint8_t[newValue.size()]();
-        std::memcpy(valuePtr, newValue.cbegin(), newValue.size());
-        len = newValue.size();
+    if(length) {
+        std::memcpy(valuePtr, newValue, length);
     }
+    len = length;
 
     if(maxLen < len) {
         maxLen = len;
     }
+
+    return true;
 }
 
 bool RAIIGattAttribute::setMaxLength(uint16_t max) {
@@ -53,15 +61,10 @@ void RAIIGattAttribute::setVariableLength(bool hasVariableLen) {
     this->*_hasVariableLen_accessor = hasVariableLen;
 }
 
-void RAIIGattAttribute::releaseAttributeValue() {
-    uint8_t*& valuePtr = (this->*_valuePtr_accessor);
-    uint16_t& len = this->*_len_accessor;
-
-    if(valuePtr) {
-        delete[] valuePtr;
-        valuePtr = NULL;
-        len = 0;
-    }
+void RAIIGattAttribute::releaseValue() {
+    this->*_valuePtr_accessor = NULL;
+    this->*_len_accessor = 0;
+    _valueCapacity = 0;
 }
 
 }
@@ -4,26 +4,44 @@
 #include <stdint.h>
 #include <ble/GattAttribute.h>
 #include "util/Vector.h"
+#include "util/BumpArena.h"
 
 namespace detail {
 
+class RAIIGattCharacteristic;
+
+/**
+ * @brief Attribute allocated in the arena of a RAIIGattService.
+ * @note The attribute value is allocated in the arena of values of the service.
+ */
 class RAIIGattAttribute : public GattAttribute {
+    friend class RAIIGattCharacteristic;
+
 public:
 
     RAIIGattAttribute(const UUID& uuid);
 
     ~RAIIGattAttribute();
 
-    void setValue(const container::Vector<uint8_t>& value);
+    bool setValue(const container::Vector<uint8_t>& value, util::BumpArena& arena);
+
+    bool setValue(const uint8_t* value, uint16_t length, util::BumpArena& arena);
 
     bool setMaxLength(uint16_t max);
 
     void setVariableLength(bool hasVariableLen);
 
-    void releaseAttributeValue();
+    // forget the value, its storage is released with the arena of values
+    void releaseValue();
+
 private:
     RAIIGattAttribute(const RAIIGattAttribute&);
     RAIIGattAttribute& operator=(const RAIIGattAttribute&);
+
+    // size of the value storage allocated in the arena
+    uint16_t _valueCapacity;
+    // next descriptor in the characteristic list of descriptors
+    RAIIGattAttribute* _next;
 };
 
 }
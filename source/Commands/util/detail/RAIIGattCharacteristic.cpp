@@ -1,5 +1,3 @@
-#include <cstdlib>
-
 #include "RAIIGattCharacteristic.h"
 #include "RAIIGattAttribute.h"
 #include "util/HijackMember.h"
@@ -15,47 +13,49 @@ HIJACK_MEMBER(_descriptorCount_accessor, uint8_t GattCharacteristic::*, &GattCha
 namespace detail {
 
 RAIIGattCharacteristic::RAIIGattCharacteristic(const UUID& uuid)  :
-    GattCharacteristic(uuid) {
+    GattCharacteristic(uuid), _valueCapacity(0), _lastDescriptor(NULL), _next(NULL) {
 }
 
 RAIIGattCharacteristic::~RAIIGattCharacteristic() {
-    GattAttribute& attr = getValueAttribute();
-    GattAttribute**& descriptors = this->*_descriptors_accessor;
-    uint8_t& descriptorsCount = this->*_descriptorCount_accessor;
-
-    if(attr.*_valuePtr_accessor) {
-        delete[] (attr.*_valuePtr_accessor);
-    }
-
-    for(uint8_t i = 0; i < descriptorsCount; ++i) {
-        delete static_cast<RAIIGattAttribute*>(descriptors[i]);
+    // memory is owned by the arena of the service, only run destructors
+    RAIIGattAttribute* descriptor = _lastDescriptor;
+    while(descriptor) {
+        RAIIGattAttribute* next = descriptor->_next;
+        descriptor->~RAIIGattAttribute();
+        descriptor = next;
     }
+}
 
-    if(descriptorsCount) {
-        std::free(descriptors);
-    }
+bool RAIIGattCharacteristic::setValue(const container::Vector<uint8_t>& newValue, util::BumpArena& arena) {
+    return setValue(newValue.cbegin(), newValue.size(), arena);
 }
 
-void RAIIGattCharacteristic::setValue(const container::Vector<uint8_t>& newValue) {
+bool RAIIGattCharacteristic::setValue(const uint8_t* newValue, uint16_t length, util::BumpArena& arena) {
     uint8_t*& valuePtr = (this->getValueAttribute()).*_valuePtr_accessor;
     uint16_t& len = (this->getValueAttribute()).*_len_accessor;
     uint16_t& maxLen = (this->getValueAttribute()).*_lenMax_accessor;
 
-    if(valuePtr) {
-        delete[] valuePtr;
-        valuePtr = NULL;
-        len = 0;
+    // a value which fits in the storage of the previous one reuses it, the
+    // storage of a shorter previous value remains in the arena until it is released
+    if(length > _valueCapacity) {
+        uint8_t* storage = static_cast<uint8_t*>(arena.allocate(length));
+        if(!storage) {
+            return false;
+        }
+        valuePtr = storage;
+        _valueCapacity = length;
     }
 
-    if(newValue.size()) {
-        valuePtr = new uint8_t[newValue.size()]();
-        std::memcpy(valuePtr, newValue.cbegin(), newValue.size());
-        len = newValue.size();
+    if(length) {
+        std::memcpy(valuePtr, newValue, length);
     }
+    len = length;
 
     if(maxLen < len) {
         maxLen = len;
     }
+
+    return true;
 }
 
 bool RAIIGattCharacteristic::setMaxLength(uint16_t max) {
@@ -79,33 +79,48 @@ void RAIIGattCharacteristic::setSecurity(SecurityManager::SecurityMode_t securit
     requireSecurity(security);
 }
 
-void RAIIGattCharacteristic::addDescriptor(RAIIGattAttribute* descriptor) {
-    GattAttribute**& descriptors = this->*_descriptors_accessor;
-    uint8_t& descriptorsCount = this->*_descriptorCount_accessor;
+void RAIIGattCharacteristic::releaseValue() {
+    (this->getValueAttribute()).*_valuePtr_accessor = NULL;
+    (this->getValueAttribute()).*_len_accessor = 0;
+    _valueCapacity = 0;
 
-    descriptors = static_cast<GattAttribute**>(std::realloc(descriptors, sizeof(GattAttribute*) * (descriptorsCount + 1)));
-    descriptors[descriptorsCount] = descriptor;
-    descriptorsCount += 1;
+    for(RAIIGattAttribute* descriptor = _lastDescriptor; descriptor; descriptor = descriptor->_next) {
+        descriptor->releaseValue();
+    }
 }
 
+void RAIIGattCharacteristic::addDescriptor(RAIIGattAttribute* descriptor) {
+    descriptor->_next = _lastDescriptor;
+    _lastDescriptor = descriptor;
+}
 
-void RAIIGattCharacteristic::releaseAttributesValue() {
-    uint8_t*& valuePtr = (this->getValueAttribute()).*_valuePtr_accessor;
-    uint16_t& len = (this->getValueAttribute()).*_len_accessor;
+bool RAIIGattCharacteristic::bindDescriptors(util::BumpArena& arena) {
+    GattAttribute**& descriptors = this->*_descriptors_accessor;
+    uint8_t& descriptorsCount = this->*_descriptorCount_accessor;
 
-    if(valuePtr) {
-        delete[] valuePtr;
-        valuePtr = NULL;
-        len = 0;
+    uint8_t count = 0;
+    for(RAIIGattAttribute* descriptor = _lastDescriptor; descriptor; descriptor = descriptor->_next) {
+        ++count;
     }
 
+    descriptors = NULL;
+    descriptorsCount = 0;
+    if(!count) {
+        return true;
+    }
 
-    RAIIGattAttribute** descriptors = reinterpret_cast<RAIIGattAttribute**>(this->*_descriptors_accessor);
-    uint8_t descriptorsCount = this->*_descriptorCount_accessor;
+    descriptors = static_cast<GattAttribute**>(arena.allocate(sizeof(GattAttribute*) * count));
+    if(!descriptors) {
+        return false;
+    }
 
-    for(uint8_t i = 0; i < descriptorsCount; ++i) {
-        descriptors[i]->releaseAttributeValue();
+    // the list is in reverse order of declaration
+    descriptorsCount = count;
+    for(RAIIGattAttribute* descriptor = _lastDescriptor; descriptor; descriptor = descriptor->_next) {
+        descriptors[--count] = descriptor;
     }
+
+    return true;
 }
 
 } // namespace detail
@@ -4,17 +4,29 @@
 #include <stdint.h>
 #include <ble/GattCharacteristic.h>
 #include "util/Vector.h"
+#include "util/BumpArena.h"
 #include "RAIIGattAttribute.h"
 
 namespace detail {
 
+class RAIIGattService;
+
+/**
+ * @brief Characteristic allocated in the arena of a RAIIGattService.
+ * @note The characteristic and its descriptors are allocated in the arena of
+ * the service, their values in the arena of values of the service.
+ */
 class RAIIGattCharacteristic : public GattCharacteristic {
+    friend class RAIIGattService;
+
 public:
     RAIIGattCharacteristic(const UUID& uuid);
 
     ~RAIIGattCharacteristic();
 
-    void setValue(const container::Vector<uint8_t>& value);
+    bool setValue(const container::Vector<uint8_t>& value, util::BumpArena& arena);
+
+    bool setValue(const uint8_t* value, uint16_t length, util::BumpArena& arena);
 
     bool setMaxLength(uint16_t max);
 
@@ -24,13 +36,26 @@ public:
 
     void setSecurity(SecurityManager::SecurityMode_t security);
 
-    // note: the attribute will be moved and owned by this data structure ...
+    // note: the descriptor should be allocated in the same arena as the characteristic
     void addDescriptor(RAIIGattAttribute* descriptor);
 
-    void releaseAttributesValue();
+    // build the array of descriptors exposed by GattCharacteristic
+    bool bindDescriptors(util::BumpArena& arena);
+
+    // forget the value of the characteristic and of its descriptors, their
+    // storage is released with the arena of values
+    void releaseValue();
+
 private:
     RAIIGattCharacteristic(const RAIIGattCharacteristic&);
     RAIIGattCharacteristic& operator=(const RAIIGattCharacteristic&);
+
+    // size of the value storage allocated in the arena
+    uint16_t _valueCapacity;
+    // descriptors in reverse order of declaration
+    RAIIGattAttribute* _lastDescriptor;
+    // next characteristic in the service list of characteristics
+    RAIIGattCharacteristic* _next;
 };
 
 }
@@ -1,4 +1,4 @@
-#include <cstdlib>
+#include <new>
 #include "RAIIGattService.h"
 #include "RAIIGattAttribute.h"
 #include "util/HijackMember.h"
@@ -6,42 +6,126 @@
 HIJACK_MEMBER(_characteristics_accessor, GattCharacteristic** GattService::*, &GattService::_characteristics);
 HIJACK_MEMBER(_characteristicCount_accessor, uint8_t GattService::*, &GattService::_characteristicCount);
 
+#ifndef BLE_CLIAPP_GATT_SERVICE_ARENA_CHUNK_SIZE
+#define BLE_CLIAPP_GATT_SERVICE_ARENA_CHUNK_SIZE 256
+#endif
+
 namespace detail {
 
-RAIIGattService::RAIIGattService(const UUID& uuid)  :
-    GattService(uuid, NULL, 0) {
+RAIIGattService* RAIIGattService::create(const UUID& uuid, std::size_t arenaSize, std::size_t valuesSize) {
+    util::BumpArena arena(arenaSize ? arenaSize : BLE_CLIAPP_GATT_SERVICE_ARENA_CHUNK_SIZE);
+
+    void* storage = arena.allocate(sizeof(RAIIGattService));
+    if(!storage) {
+        return NULL;
+    }
+
+    // the service lives in the arena it owns
+    RAIIGattService* service = new (storage) RAIIGattService(
+        uuid, valuesSize ? valuesSize : BLE_CLIAPP_GATT_SERVICE_ARENA_CHUNK_SIZE
+    );
+    service->_arena.swap(arena);
+    return service;
+}
+
+std::size_t RAIIGattService::declarationSize(std::size_t characteristicCount, std::size_t descriptorCount) {
+    using util::BumpArena;
+
+    // each characteristic and descriptor also takes an entry in the arrays
+    // built by bindCharacteristics
+    return BumpArena::alignedSize(sizeof(RAIIGattService)) +
+        characteristicCount * (
+            BumpArena::alignedSize(sizeof(RAIIGattCharacteristic)) +
+            BumpArena::alignedSize(sizeof(GattCharacteristic*))
+        ) +
+        descriptorCount * (
+            BumpArena::alignedSize(sizeof(RAIIGattAttribute)) +
+            BumpArena::alignedSize(sizeof(GattAttribute*))
+        );
+}
+
+void RAIIGattService::destroy(RAIIGattService* service) {
+    // take the arena out of the service before it is destroyed, the memory is
+    // released when arena goes out of scope
+    util::BumpArena arena;
+    arena.swap(service->_arena);
+    service->~RAIIGattService();
+}
+
+RAIIGattService::RAIIGattService(const UUID& uuid, std::size_t valuesSize)  :
+    GattService(uuid, NULL, 0), _values(valuesSize), _lastCharacteristic(NULL), _next(NULL) {
 }
 
 RAIIGattService::~RAIIGattService() {
-    GattCharacteristic**& characteristics = this->*_characteristics_accessor;
-    uint8_t& characteristicCount = this->*_characteristicCount_accessor;
+    // memory is owned by the arena, only run destructors
+    RAIIGattCharacteristic* characteristic = _lastCharacteristic;
+    while(characteristic) {
+        RAIIGattCharacteristic* next = characteristic->_next;
+        characteristic->~RAIIGattCharacteristic();
+        characteristic = next;
+    }
+}
 
-    for(uint8_t i = 0; i < characteristicCount; ++i) {
-        delete static_cast<RAIIGattCharacteristic*>(characteristics[i]);
+void RAIIGattService::releaseAttributesValue() {
+    for(RAIIGattCharacteristic* characteristic = _lastCharacteristic; characteristic; characteristic = characteristic->_next) {
+        characteristic->releaseValue();
     }
+    _values.clear();
+}
+
+RAIIGattCharacteristic* RAIIGattService::declareCharacteristic(const UUID& uuid) {
+    void* storage = _arena.allocate(sizeof(RAIIGattCharacteristic));
+    if(!storage) {
+        return NULL;
+    }
+
+    RAIIGattCharacteristic* characteristic = new (storage) RAIIGattCharacteristic(uuid);
+    characteristic->_next = _lastCharacteristic;
+    _lastCharacteristic = characteristic;
+    return characteristic;
+}
 
-    if(characteristicCount) {
-        std::free(characteristics);
+RAIIGattAttribute* RAIIGattService::declareDescriptor(RAIIGattCharacteristic* characteristic, const UUID& uuid) {
+    void* storage = _arena.allocate(sizeof(RAIIGattAttribute));
+    if(!storage) {
+        return NULL;
     }
+
+    RAIIGattAttribute* descriptor = new (storage) RAIIGattAttribute(uuid);
+    characteristic->addDescriptor(descriptor);
+    return descriptor;
 }
 
-void RAIIGattService::addCharacteristic(RAIIGattCharacteristic* characteristic) {
+bool RAIIGattService::bindCharacteristics() {
     GattCharacteristic**& characteristics = this->*_characteristics_accessor;
     uint8_t& characteristicCount = this->*_characteristicCount_accessor;
 
-    characteristics = static_cast<GattCharacteristic**>(std::realloc(characteristics, sizeof(GattCharacteristic*) * (characteristicCount + 1)));
-    characteristics[characteristicCount] = characteristic;
-    characteristicCount += 1;
-}
+    uint8_t count = 0;
+    for(RAIIGattCharacteristic* characteristic = _lastCharacteristic; characteristic; characteristic = characteristic->_next) {
+        if(!characteristic->bindDescriptors(_arena)) {
+            return false;
+        }
+        ++count;
+    }
 
+    characteristics = NULL;
+    characteristicCount = 0;
+    if(!count) {
+        return true;
+    }
 
-void RAIIGattService::releaseAttributesValue() {
-    RAIIGattCharacteristic** characteristics = reinterpret_cast<RAIIGattCharacteristic**>(this->*_characteristics_accessor);
-    uint8_t characteristicCount = this->*_characteristicCount_accessor;
+    characteristics = static_cast<GattCharacteristic**>(_arena.allocate(sizeof(GattCharacteristic*) * count));
+    if(!characteristics) {
+        return false;
+    }
 
-    for(uint8_t i = 0; i < characteristicCount; ++i) {
-        characteristics[i]->releaseAttributesValue();
+    // the list is in reverse order of declaration
+    characteristicCount = count;
+    for(RAIIGattCharacteristic* characteristic = _lastCharacteristic; characteristic; characteristic = characteristic->_next) {
+        characteristics[--count] = characteristic;
     }
+
+    return true;
 }
 
 } // namespace detail
@@ -4,24 +4,112 @@
 #include <stdint.h>
 #include <ble/GattService.h>
 #include "util/Vector.h"
+#include "util/BumpArena.h"
 #include "RAIIGattCharacteristic.h"
 
 namespace detail {
 
+/**
+ * @brief Service which owns an arena holding the service declaration: the
+ * service itself, its characteristics and descriptors.
+ * @details Instances are created with create and released with destroy which
+ * gives back the memory of the declaration to the heap at once. Attribute
+ * values are held in a second arena which can be released on its own once the
+ * GattServer has copied them, see releaseAttributesValue.
+ */
 class RAIIGattService : public GattService {
 public:
-    RAIIGattService(const UUID& uuid);
+    /**
+     * @brief Create a new service in its own arena.
+     * @param arenaSize Size of the first chunk of the arena, 0 selects the
+     * default chunk size. A declaration which fits in the first chunk is held
+     * in a single allocation.
+     * @param valuesSize Size of the first chunk of the arena of values, 0
+     * selects the default chunk size. Each value takes
+     * util::BumpArena::alignedSize of its length.
+     * @return The service created or NULL if the heap is exhausted.
+     */
+    static RAIIGattService* create(const UUID& uuid, std::size_t arenaSize = 0, std::size_t valuesSize = 0);
 
-    ~RAIIGattService();
+    /**
+     * @brief Return the size of the arena needed by a declaration, values
+     * excluded. The size returned is an upper bound: arrays of pointers are
+     * accounted with the padding of each entry.
+     * @param characteristicCount Number of characteristics of the service.
+     * @param descriptorCount Number of descriptors of the service.
+     */
+    static std::size_t declarationSize(std::size_t characteristicCount, std::size_t descriptorCount);
+
+    /**
+     * @brief Destroy a service and release its arena.
+     */
+    static void destroy(RAIIGattService* service);
+
+    /**
+     * @brief Declare a new characteristic at the end of the service.
+     * @return The characteristic or NULL if the heap is exhausted.
+     */
+    RAIIGattCharacteristic* declareCharacteristic(const UUID& uuid);
 
-    // note: the characteristic will be moved and owned by this data structure ...
-    void addCharacteristic(RAIIGattCharacteristic* characteristic);
+    /**
+     * @brief Declare a new descriptor at the end of a characteristic of the service.
+     * @return The descriptor or NULL if the heap is exhausted.
+     */
+    RAIIGattAttribute* declareDescriptor(RAIIGattCharacteristic* characteristic, const UUID& uuid);
 
+    /**
+     * @brief Build the arrays of characteristics and descriptors exposed by
+     * GattService and GattCharacteristic. It should be called once the
+     * declaration is complete.
+     */
+    bool bindCharacteristics();
+
+    /**
+     * @brief Release the values of the characteristics and descriptors.
+     * @details The GattServer copies the values when the service is added,
+     * once they are not needed anymore the attributes are left empty and the
+     * memory of the values goes back to the heap.
+     */
     void releaseAttributesValue();
 
+    /**
+     * @brief Arena which holds the service declaration.
+     */
+    util::BumpArena& arena() {
+        return _arena;
+    }
+
+    /**
+     * @brief Arena which holds the values of the attributes.
+     */
+    util::BumpArena& valuesArena() {
+        return _values;
+    }
+
+    /**
+     * @brief Next service in a list of services.
+     */
+    RAIIGattService* next() const {
+        return _next;
+    }
+
+    void setNext(RAIIGattService* service) {
+        _next = service;
+    }
+
 private:
+    RAIIGattService(const UUID& uuid, std::size_t valuesSize);
+
+    ~RAIIGattService();
+
     RAIIGattService(const RAIIGattService&);
     RAIIGattService& operator=(const RAIIGattService&);
+
+    util::BumpArena _arena;
+    util::BumpArena _values;
+    // characteristics in reverse order of declaration
+    RAIIGattCharacteristic* _lastCharacteristic;
+    RAIIGattService* _next;
 };
 
 }
@@ -18,9 +18,36 @@
 #define EVENTQUEUE_EVENTQUEUE_H_
 
 #include <stdio.h>
+#include <stdint.h>
 #include "Thunk.h"
 #include "MakeThunk.h"
 
+/// EQ_CALLER_ADDRESS: address of the instruction following the call to the
+/// current function.
+/// EQ_FORCEINLINE, EQ_NOINLINE: force or prevent the inlining of a function.
+/// EQ_OPAQUE: side effect which prevents the compiler from merging or moving
+/// calls to a function.
+#if defined(__CC_ARM)
+#define EQ_CALLER_ADDRESS() ((const void*) __return_address())
+#define EQ_FORCEINLINE __forceinline
+#define EQ_NOINLINE __declspec(noinline)
+#define EQ_OPAQUE() __schedule_barrier()
+#elif defined(__GNUC__)
+#define EQ_CALLER_ADDRESS() ((const void*) __builtin_return_address(0))
+#define EQ_FORCEINLINE inline __attribute__((always_inline))
+#if defined(__clang__)
+#define EQ_NOINLINE __attribute__((noinline))
+#else
+#define EQ_NOINLINE __attribute__((noinline, noclone))
+#endif
+#define EQ_OPAQUE() __asm__ __volatile__("")
+#else
+#define EQ_CALLER_ADDRESS() ((const void*) NULL)
+#define EQ_FORCEINLINE inline
+#define EQ_NOINLINE
+#define EQ_OPAQUE()
+#endif
+
 namespace eq {
 
 class EventQueue {
@@ -38,6 +65,35 @@ public:
 	/// type used for time
 	typedef std::size_t ms_time_t;
 
+	/// Priority classes of events.
+	/// Among the events ready to be dispatched, events of an higher class are
+	/// dispatched first; events of the same class are dispatched in order.
+	/// Long running work should be split in chunks posted with PRIORITY_LOW
+	/// so other events can be dispatched between two chunks.
+	enum priority_t {
+		PRIORITY_LOW,		/// background work, like the output of large responses
+		PRIORITY_NORMAL,	/// default class
+		PRIORITY_HIGH		/// processing of the BLE stack
+	};
+
+	/// Health of an event queue.
+	struct Metrics {
+		std::size_t capacity;				/// number of events the queue can hold
+		std::size_t occupancy;				/// number of events in the queue
+		std::size_t peak_occupancy;			/// greatest number of events held by the queue
+		uint32_t post_failures;				/// events rejected because the queue was full
+		uint32_t dispatched;				/// events dispatched
+		ms_time_t max_dispatch_lag;			/// longest delay between the deadline of an event and its dispatch
+		ms_time_t max_callback_duration;	/// longest execution of an event
+	};
+
+	/// Metrics of the events posted from a call site.
+	struct SiteMetrics {
+		const void* site;					/// address of the call to post, NULL for the sites not tracked
+		uint32_t posted;					/// events posted from the site
+		ms_time_t max_callback_duration;	/// longest execution of an event posted from the site
+	};
+
 	/// Construct an empty event queue
 	EventQueue() { }
 
@@ -50,8 +106,8 @@ public:
 	 * @return the handle to the event.
 	 */
 	template<typename F>
-	event_handle_t post(const F& fn) {
-		return do_post(fn);
+	EQ_FORCEINLINE event_handle_t post(const F& fn) {
+		return do_post(fn, call_site());
 	}
 
 	/**
@@ -62,64 +118,132 @@ public:
 	 * @return the handle to the event.
 	 */
 	template<typename F, typename Arg0>
-	event_handle_t post(const F& fn, const Arg0& arg0) {
-		return do_post(make_thunk(fn, arg0));
+	EQ_FORCEINLINE event_handle_t post(const F& fn, const Arg0& arg0) {
+		return do_post(make_thunk(fn, arg0), call_site());
+	}
+
+	template<typename F, typename Arg0, typename Arg1>
+	EQ_FORCEINLINE event_handle_t post(const F& fn, const Arg0& arg0, const Arg1& arg1) {
+		return do_post(make_thunk(fn, arg0, arg1), call_site());
+	}
+
+	template<typename F, typename Arg0, typename Arg1, typename Arg2>
+	EQ_FORCEINLINE event_handle_t post(const F& fn, const Arg0& arg0, const Arg1& arg1, const Arg2& arg2) {
+		return do_post(make_thunk(fn, arg0, arg1, arg2), call_site());
+	}
+
+	/**
+	 * Post a callable to the event queue in a given priority class.
+	 * It will be executed during the next dispatch cycle, after the events
+	 * ready of an higher class.
+	 * @param priority The priority class of the event.
+	 * @param f The callbable to be executed by the event queue.
+	 * @return the handle to the event.
+	 */
+	template<typename F>
+	EQ_FORCEINLINE event_handle_t post(priority_t priority, const F& fn) {
+		return do_post(fn, call_site(), 0, false, priority);
+	}
+
+	template<typename F, typename Arg0>
+	EQ_FORCEINLINE event_handle_t post(priority_t priority, const F& fn, const Arg0& arg0) {
+		return do_post(make_thunk(fn, arg0), call_site(), 0, false, priority);
 	}
 
 	template<typename F, typename Arg0, typename Arg1>
-	event_handle_t post(const F& fn, const Arg0& arg0, const Arg1& arg1) {
-		return do_post(make_thunk(fn, arg0, arg1));
+	EQ_FORCEINLINE event_handle_t post(priority_t priority, const F& fn, const Arg0& arg0, const Arg1& arg1) {
+		return do_post(make_thunk(fn, arg0, arg1), call_site(), 0, false, priority);
 	}
 
 	template<typename F, typename Arg0, typename Arg1, typename Arg2>
-	event_handle_t post(const F& fn, const Arg0& arg0, const Arg1& arg1, const Arg2& arg2) {
-		return do_post(make_thunk(fn, arg0, arg1, arg2));
+	EQ_FORCEINLINE event_handle_t post(priority_t priority, const F& fn, const Arg0& arg0, const Arg1& arg1, const Arg2& arg2) {
+		return do_post(make_thunk(fn, arg0, arg1, arg2), call_site(), 0, false, priority);
 	}
 
 	template<typename F>
-	event_handle_t post_in(const F& fn, ms_time_t ms_delay) {
-		return do_post(fn, ms_delay);
+	EQ_FORCEINLINE event_handle_t post_in(const F& fn, ms_time_t ms_delay) {
+		return do_post(fn, call_site(), ms_delay);
 	}
 
 	template<typename F, typename Arg0>
-	event_handle_t post_in(const F& fn, const Arg0& arg0, ms_time_t ms_delay) {
-		return do_post(make_thunk(fn, arg0), ms_delay);
+	EQ_FORCEINLINE event_handle_t post_in(const F& fn, const Arg0& arg0, ms_time_t ms_delay) {
+		return do_post(make_thunk(fn, arg0), call_site(), ms_delay);
 	}
 
 	template<typename F, typename Arg0, typename Arg1>
-	event_handle_t post_in(const F& fn, const Arg0& arg0, const Arg1& arg1, ms_time_t ms_delay) {
-		return do_post(make_thunk(fn, arg0, arg1), ms_delay);
+	EQ_FORCEINLINE event_handle_t post_in(const F& fn, const Arg0& arg0, const Arg1& arg1, ms_time_t ms_delay) {
+		return do_post(make_thunk(fn, arg0, arg1), call_site(), ms_delay);
 	}
 
 	template<typename F, typename Arg0, typename Arg1, typename Arg2>
-	event_handle_t post_in(const F& fn, const Arg0& arg0, const Arg1& arg1, const Arg2& arg2, ms_time_t ms_delay) {
-		return do_post(make_thunk(fn, arg0, arg1, arg2), ms_delay);
+	EQ_FORCEINLINE event_handle_t post_in(const F& fn, const Arg0& arg0, const Arg1& arg1, const Arg2& arg2, ms_time_t ms_delay) {
+		return do_post(make_thunk(fn, arg0, arg1, arg2), call_site(), ms_delay);
 	}
 
 	template<typename F>
-	event_handle_t post_every(const F& fn, ms_time_t ms_delay) {
-		return do_post(fn, ms_delay, true);
+	EQ_FORCEINLINE event_handle_t post_every(const F& fn, ms_time_t ms_delay) {
+		return do_post(fn, call_site(), ms_delay, true);
 	}
 
 	template<typename F, typename Arg0>
-	event_handle_t post_every(const F& fn, const Arg0& arg0, ms_time_t ms_delay) {
-		return do_post(make_thunk(fn, arg0), ms_delay, true);
+	EQ_FORCEINLINE event_handle_t post_every(const F& fn, const Arg0& arg0, ms_time_t ms_delay) {
+		return do_post(make_thunk(fn, arg0), call_site(), ms_delay, true);
 	}
 
 	template<typename F, typename Arg0, typename Arg1>
-	event_handle_t post_every(const F& fn, const Arg0& arg0, const Arg1& arg1, ms_time_t ms_delay) {
-		return do_post(make_thunk(fn, arg0, arg1), ms_delay, true);
+	EQ_FORCEINLINE event_handle_t post_every(const F& fn, const Arg0& arg0, const Arg1& arg1, ms_time_t ms_delay) {
+		return do_post(make_thunk(fn, arg0, arg1), call_site(), ms_delay, true);
 	}
 
 	template<typename F, typename Arg0, typename Arg1, typename Arg2>
-	event_handle_t post_every(const F& fn, const Arg0& arg0, const Arg1& arg1, const Arg2& arg2, ms_time_t ms_delay) {
-		return do_post(make_thunk(fn, arg0, arg1, arg2), ms_delay, true);
+	EQ_FORCEINLINE event_handle_t post_every(const F& fn, const Arg0& arg0, const Arg1& arg1, const Arg2& arg2, ms_time_t ms_delay) {
+		return do_post(make_thunk(fn, arg0, arg1, arg2), call_site(), ms_delay, true);
 	}
 
 	virtual bool cancel(event_handle_t event_handle) = 0;
 
+	/**
+	 * Get the metrics of the queue.
+	 * @return false if the queue does not record metrics.
+	 */
+	virtual bool get_metrics(Metrics& metrics) const {
+		return false;
+	}
+
+	/**
+	 * Get the metrics of a call site.
+	 * @param index Index of the site, sites are indexed from 0.
+	 * @return false if there is no site at index.
+	 */
+	virtual bool get_site_metrics(std::size_t index, SiteMetrics& metrics) const {
+		return false;
+	}
+
+	/**
+	 * Reset the metrics of the queue.
+	 */
+	virtual void reset_metrics() { }
+
 private:
-	virtual event_handle_t do_post(const function_t& fn, ms_time_t ms_delay = 0, bool repeat = false) = 0;
+	/**
+	 * Return the address of the call to call_site.
+	 * The post functions are always inlined in their caller; the address
+	 * returned identifies the place where the event is posted.
+	 */
+	static EQ_NOINLINE const void* call_site() {
+		// not a pure function: each call must stay where it was written
+		EQ_OPAQUE();
+		return EQ_CALLER_ADDRESS();
+	}
+
+	/**
+	 * Post an event.
+	 * @param site Address identifying the place where the event is posted.
+	 */
+	virtual event_handle_t do_post(
+		const function_t& fn, const void* site,
+		ms_time_t ms_delay = 0, bool repeat = false, priority_t priority = PRIORITY_NORMAL
+	) = 0;
 };
 
 } // namespace eq
@@ -17,21 +17,55 @@
 #ifndef BLE_API_SOURCE_MBEDCLASSICEVENTQUEUE_H_
 #define BLE_API_SOURCE_MBEDCLASSICEVENTQUEUE_H_
 
-#include <cmsis.h>
 #include "PriorityQueue.h"
-#include "Ticker.h"
-#include "Timer.h"
 #include <stdio.h>
+#include <stdint.h>
 #include "Thunk.h"
 #include "MakeThunk.h"
 #include "EventQueue.h"
 
-#include <util/CriticalSectionLock.h>
-typedef ::mbed::util::CriticalSectionLock CriticalSection;
+// Default platform types of the queue, they are defined in
+// EventQueueClassicMbed.h which must be included to instantiate the queue
+// with its defaults.
+namespace mbed {
+class Timer;
+namespace util {
+class CriticalSectionLock;
+}
+}
 
 namespace eq {
 
-template<std::size_t EventCount>
+class MbedTicker;
+class PerfDispatchProbe;
+
+/// Event queue driven by a ticker.
+/// The ticker, timer and critical section types are parameters of the queue
+/// so it can run against a virtual clock off target; this header does not
+/// depend on mbed OS. Ticker must provide attach(object, member function, seconds)
+/// and detach(); Timer must provide start(), stop(), reset() and read_ms();
+/// CriticalSection is a RAII type which protects the queue from interrupts
+/// while it is alive. DispatchProbe is a RAII type alive while a callback
+/// runs; the default one feeds the perf instrumentation.
+///
+/// The queue records its metrics: occupancy, post failures, dispatch lag and
+/// callback durations. Events are also accounted per call site of post, sites
+/// are identified by the address of the call. The address is hashed into a
+/// table of SiteCount slots, a site takes the first free slot among
+/// SITE_PROBE_COUNT from its hash; sites which do not find a slot are
+/// accounted together. With a SiteCount of 0 sites are not accounted.
+///
+/// Among the events ready to be dispatched, the events of the highest
+/// priority class are dispatched first; within a class events are dispatched
+/// in the order they became ready.
+template<
+	std::size_t EventCount,
+	typename Ticker = MbedTicker,
+	typename Timer = mbed::Timer,
+	std::size_t SiteCount = 16,
+	typename CriticalSection = mbed::util::CriticalSectionLock,
+	typename DispatchProbe = PerfDispatchProbe
+>
 class EventQueueClassic: public EventQueue {
 
 	/// Describe an event.
@@ -44,10 +78,18 @@ class EventQueueClassic: public EventQueue {
 		/// @param ms_remaining_time remaining time before this event occurence
 		/// @param ms_repeat_period If the event is periodic, this parameter is the
 		/// period between to occurence of this event.
-		Event(const function_t& f, ms_time_t ms_remaining_time, ms_time_t ms_repeat_period = 0) :
+		/// @param site Index of the call site which has posted the event.
+		/// @param priority Priority class of the event.
+		Event(
+			const function_t& f, ms_time_t ms_remaining_time, ms_time_t ms_repeat_period = 0,
+			std::size_t site = SiteCount, priority_t priority = PRIORITY_NORMAL
+		) :
 			_f(f),
 			_ms_remaining_time(ms_remaining_time),
-			_ms_repeat_period(ms_repeat_period) {
+			_ms_repeat_period(ms_repeat_period),
+			_ms_ready_time(0),
+			_site(site),
+			_priority(priority) {
 		}
 
 		/// call the inner function within an event
@@ -61,9 +103,13 @@ class EventQueueClassic: public EventQueue {
 		}
 
 		/// comparison operator used by the priority queue.
-		/// comaprare remaining time between two events
+		/// comaprare remaining time between two events, events with the same
+		/// remaining time are ordered by priority class
 		friend bool operator<(const Event& lhs, const Event& rhs) {
-			return lhs._ms_remaining_time < rhs._ms_remaining_time;
+			if (lhs._ms_remaining_time != rhs._ms_remaining_time) {
+				return lhs._ms_remaining_time < rhs._ms_remaining_time;
+			}
+			return lhs._priority > rhs._priority;
 		}
 
 		/// return the time remaining when this event was inserted into the priority queue.
@@ -81,10 +127,33 @@ class EventQueueClassic: public EventQueue {
 			return _ms_repeat_period;
 		}
 
+		/// return the time at which the event became ready to be dispatched
+		ms_time_t get_ms_ready_time() const {
+			return _ms_ready_time;
+		}
+
+		/// set the time at which the event became ready to be dispatched
+		void set_ms_ready_time(ms_time_t ready_time) {
+			_ms_ready_time = ready_time;
+		}
+
+		/// return the index of the call site which has posted the event
+		std::size_t get_site() const {
+			return _site;
+		}
+
+		/// return the priority class of the event
+		priority_t get_priority() const {
+			return _priority;
+		}
+
 	private:
 		function_t _f;
 		ms_time_t _ms_remaining_time;
 		const ms_time_t _ms_repeat_period;
+		ms_time_t _ms_ready_time;
+		std::size_t _site;
+		priority_t _priority;
 	};
 
 	/// type of the internal queue
@@ -96,10 +165,16 @@ class EventQueueClassic: public EventQueue {
 	/// node type in the queue
 	typedef typename priority_queue_t::Node q_node_t;
 
+	/// number of slots probed to register a call site
+	static const std::size_t SITE_PROBE_COUNT = 4;
+
 public:
 	/// Construct an empty event queue
 	EventQueueClassic() :
-		_events_queue(), _ticker(), _timer(), _timed_event_pending(false) {
+		_events_queue(), _ticker(), _timer(), _timed_event_pending(false),
+		_clock(), _metrics(), _sites() {
+		_clock.start();
+		reset_metrics();
 	}
 
 	virtual ~EventQueueClassic() { }
@@ -114,35 +189,166 @@ public:
 		return success;
 	}
 
+	virtual bool get_metrics(Metrics& metrics) const {
+		CriticalSection critical_section;
+		metrics = _metrics;
+		metrics.capacity = EventCount;
+		metrics.occupancy = _events_queue.size();
+		return true;
+	}
+
+	virtual bool get_site_metrics(std::size_t index, SiteMetrics& metrics) const {
+		if (SiteCount == 0) {
+			return false;
+		}
+
+		CriticalSection critical_section;
+		for (std::size_t slot = 0; slot < SiteCount; ++slot) {
+			if (_sites[slot].site == NULL) {
+				continue;
+			}
+			if (index == 0) {
+				metrics = _sites[slot];
+				return true;
+			}
+			--index;
+		}
+
+		// events from the sites not tracked, reported after the tracked sites
+		if (index == 0 && _sites[SiteCount].posted) {
+			metrics = _sites[SiteCount];
+			return true;
+		}
+
+		return false;
+	}
+
+	virtual void reset_metrics() {
+		CriticalSection critical_section;
+		_metrics.capacity = EventCount;
+		_metrics.occupancy = _events_queue.size();
+		_metrics.peak_occupancy = _events_queue.size();
+		_metrics.post_failures = 0;
+		_metrics.dispatched = 0;
+		_metrics.max_dispatch_lag = 0;
+		_metrics.max_callback_duration = 0;
+		for (std::size_t i = 0; i < SiteCount; ++i) {
+			_sites[i].posted = 0;
+			_sites[i].max_callback_duration = 0;
+		}
+		_sites[SiteCount].site = NULL;
+		_sites[SiteCount].posted = 0;
+		_sites[SiteCount].max_callback_duration = 0;
+	}
+
 	void dispatch() {
 		while(true) {
 			function_t f;
+			std::size_t site = SiteCount;
+			ms_time_t lag = 0;
 			// pick a task from the queue/ or leave
 			{
 				CriticalSection cs;
-				q_iterator_t event_it = _events_queue.begin();
-				if(event_it != _events_queue.end() && event_it->get_ms_remaining_time() == 0) {
+				q_iterator_t event_it = next_ready_event();
+				if(event_it != _events_queue.end()) {
 					f = event_it->get_function();
+					site = event_it->get_site();
+					lag = now() - event_it->get_ms_ready_time();
 					// if the event_it should be repeated, reschedule it
 					if (event_it->get_ms_repeat_period()) {
 						reschedule_event(event_it);
 					} else {
-						_events_queue.pop();
+						_events_queue.erase(event_it);
 					}
 				} else {
 					break;
 				}
 			}
-			f();
+			ms_time_t start = now();
+			{
+				DispatchProbe probe;
+				f();
+			}
+			record_dispatch(site, lag, now() - start);
 		}
 	}
 
 private:
 
+	ms_time_t now() const {
+		return _clock.read_ms();
+	}
+
+	/// return the first event of the highest priority class among the events
+	/// ready to be dispatched or end() if no event is ready.
+	/// Events ready are at the front of the queue but events which became
+	/// ready when their delay elapsed are not ordered by priority.
+	q_iterator_t next_ready_event() {
+		q_iterator_t result = _events_queue.end();
+		for (q_iterator_t it = _events_queue.begin(); it != _events_queue.end(); ++it) {
+			if (it->get_ms_remaining_time()) {
+				break;
+			}
+			if (result == _events_queue.end() || it->get_priority() > result->get_priority()) {
+				result = it;
+				if (result->get_priority() == PRIORITY_HIGH) {
+					break;
+				}
+			}
+		}
+		return result;
+	}
+
+	void record_dispatch(std::size_t site, ms_time_t lag, ms_time_t duration) {
+		CriticalSection critical_section;
+		++_metrics.dispatched;
+		if (lag > _metrics.max_dispatch_lag) {
+			_metrics.max_dispatch_lag = lag;
+		}
+		if (duration > _metrics.max_callback_duration) {
+			_metrics.max_callback_duration = duration;
+		}
+		if (SiteCount && duration > _sites[site].max_callback_duration) {
+			_sites[site].max_callback_duration = duration;
+		}
+	}
+
+	/// return the slot of a call site in the table of sites; it does not
+	/// access the queue and is computed before entering the critical section.
+	static std::size_t site_hash(const void* site) {
+		if (SiteCount == 0) {
+			return 0;
+		}
+		// Fibonacci hashing, the low bit of the address is the thumb bit
+		uint32_t hash = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(site) >> 1) * 2654435761U;
+		// the divisor is never 0 here, the test keeps the compiler quiet
+		return (hash >> 16) % (SiteCount ? SiteCount : 1);
+	}
+
+	/// return the index of a call site, the site is registered in the first
+	/// free slot found from its hash. The index SiteCount is used if the
+	/// SITE_PROBE_COUNT slots probed are taken by other sites.
+	std::size_t site_index(const void* site, std::size_t slot) {
+		for (std::size_t i = 0; i < SITE_PROBE_COUNT && i < SiteCount; ++i) {
+			if (_sites[slot].site == site) {
+				return slot;
+			}
+			if (_sites[slot].site == NULL) {
+				_sites[slot].site = site;
+				_sites[slot].posted = 0;
+				_sites[slot].max_callback_duration = 0;
+				return slot;
+			}
+			slot = (slot + 1 == SiteCount) ? 0 : slot + 1;
+		}
+
+		return SiteCount;
+	}
+
 	void update_ticker(ms_time_t ms_delay) {
 		_timed_event_pending = true;
 		_ticker.detach();
-		_ticker.attach(mbed::callback(this, &EventQueueClassic::updateTime), ((float) ms_delay / 1000));
+		_ticker.attach(this, &EventQueueClassic::updateTime, ((float) ms_delay / 1000));
 	}
 
 	void update_ticker(q_node_t* ref, ms_time_t ms_delay) {
@@ -159,7 +365,7 @@ private:
 		}
 	}
 
-	void update_events_remaining_time(ms_time_t elapsed_time) {
+	void update_events_remaining_time(ms_time_t elapsed_time, ms_time_t current_time) {
 		bool ticker_updated = false;
 
 		for (q_iterator_t it = _events_queue.begin();
@@ -168,6 +374,8 @@ private:
 			if(remaining_time) {
 				if(remaining_time <= elapsed_time) {
 					it->set_ms_remaining_time(0);
+					// the event was due when its remaining time elapsed
+					it->set_ms_ready_time(current_time - (elapsed_time - remaining_time));
 				} else {
 					it->set_ms_remaining_time(remaining_time - elapsed_time);
 					if (!ticker_updated) {
@@ -187,7 +395,7 @@ private:
 		_timer.stop();
 		_timer.reset();
 		_ticker.detach();
-		update_events_remaining_time(elapsed_time);
+		update_events_remaining_time(elapsed_time, now());
 	}
 
 	void reschedule_event(q_iterator_t& event_it) {
@@ -206,20 +414,35 @@ private:
 		}
 	}
 
-	virtual event_handle_t do_post(const function_t& fn, ms_time_t ms_delay = 0, bool repeat = false) {
+	virtual event_handle_t do_post(
+		const function_t& fn, const void* call_site,
+		ms_time_t ms_delay = 0, bool repeat = false, priority_t priority = PRIORITY_NORMAL
+	) {
 		if(repeat && (ms_delay == 0)) {
 			return NULL;
 		}
 
-		Event event(fn, ms_delay, repeat ? ms_delay : 0);
+		std::size_t site = site_hash(call_site);
 
 		CriticalSection critical_section;
 		if (_events_queue.full()) {
+			++_metrics.post_failures;
 			return NULL;
 		}
 
+		if (SiteCount) {
+			site = site_index(call_site, site);
+			++_sites[site].posted;
+		}
+		if (_events_queue.size() + 1 > _metrics.peak_occupancy) {
+			_metrics.peak_occupancy = _events_queue.size() + 1;
+		}
+
+		Event event(fn, ms_delay, repeat ? ms_delay : 0, site, priority);
+
 		// there is no need to update timings if ms_delay == 0
 		if (!ms_delay) {
+			event.set_ms_ready_time(now());
 			return _events_queue.push(event).get_node();
 		}
 
@@ -241,9 +464,12 @@ private:
 	}
 
 	priority_queue_t _events_queue;
-	mbed::Ticker _ticker;
-	mbed::Timer _timer;
+	Ticker _ticker;
+	Timer _timer;
 	bool _timed_event_pending;
+	mutable Timer _clock;					/// free running clock used by the metrics
+	Metrics _metrics;
+	SiteMetrics _sites[SiteCount + 1];		/// the last entry accounts the sites not tracked
 };
 
 } // namespace eq
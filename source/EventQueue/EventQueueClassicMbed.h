@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EVENTQUEUE_EVENTQUEUECLASSICMBED_H_
+#define EVENTQUEUE_EVENTQUEUECLASSICMBED_H_
+
+#include <cmsis.h>
+#include "Ticker.h"
+#include "Timer.h"
+#include <util/CriticalSectionLock.h>
+#include <util/Perf.h>
+#include "EventQueueClassic.h"
+
+namespace eq {
+
+/**
+ * mbed::Ticker with the interface expected by EventQueueClassic; this is the
+ * default ticker of the queue on target.
+ */
+class MbedTicker {
+public:
+	/// Call method on object once, seconds from now.
+	template<typename T>
+	void attach(T* object, void (T::*method)(), float seconds) {
+		_ticker.attach(mbed::callback(object, method), seconds);
+	}
+
+	/// Cancel the pending call if any.
+	void detach() {
+		_ticker.detach();
+	}
+
+private:
+	mbed::Ticker _ticker;
+};
+
+/**
+ * Record the duration of the callbacks dispatched in the EVENT_QUEUE_DISPATCH
+ * probe; this is the default dispatch probe of the queue on target.
+ */
+class PerfDispatchProbe {
+public:
+#if defined(ENABLE_PERF_INSTRUMENTATION)
+	PerfDispatchProbe() : _scope(perf::EVENT_QUEUE_DISPATCH) { }
+
+private:
+	perf::Scope _scope;
+#else
+	PerfDispatchProbe() { }
+#endif
+};
+
+} // namespace eq
+
+#endif /* EVENTQUEUE_EVENTQUEUECLASSICMBED_H_ */
@@ -36,7 +36,11 @@ public:
 
 private:
 
-	virtual event_handle_t do_post(const function_t& fn, ms_time_t ms_delay = 0, bool repeat = false) {
+	// minar does not support priority classes, events are dispatched in order
+	virtual event_handle_t do_post(
+		const function_t& fn, const void* /* call_site */,
+		ms_time_t ms_delay = 0, bool repeat = false, priority_t priority = PRIORITY_NORMAL
+	) {
         // convert ms to minar time
         minar::tick_t tick = minar::milliseconds(ms_delay);
 
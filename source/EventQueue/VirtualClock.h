@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EVENTQUEUE_VIRTUALCLOCK_H_
+#define EVENTQUEUE_VIRTUALCLOCK_H_
+
+#include <stdint.h>
+#include <cstddef>
+
+namespace eq {
+
+class VirtualTicker;
+
+/**
+ * Discrete time clock shared by the tickers and timers of a simulation.
+ *
+ * Time only moves when the simulation advances it: the clock jumps from one
+ * ticker deadline to the next and fires the tickers in deadline order, tickers
+ * with the same deadline fire in attach order. Several event queues
+ * instantiated with VirtualTicker and VirtualTimer share the same clock and
+ * can therefore be run deterministically in a single thread:
+ *
+ * @code
+ * typedef eq::EventQueueClassic<
+ *     10, eq::VirtualTicker, eq::VirtualTimer, 16, eq::NoCriticalSection,
+ *     eq::NoDispatchProbe
+ * > SimulatedQueue;
+ *
+ * SimulatedQueue devices[2];
+ * do {
+ *     devices[0].dispatch();
+ *     devices[1].dispatch();
+ * } while (eq::VirtualClock::instance().step());
+ * @endcode
+ *
+ * Only the time source is simulated: the queues exchange events through
+ * callbacks posted directly in each other, there is no simulated link layer.
+ */
+class VirtualClock {
+	friend class VirtualTicker;
+
+public:
+	/// type used for time
+	typedef uint32_t ms_time_t;
+
+	/// Return the clock of the simulation.
+	static VirtualClock& instance() {
+		static VirtualClock clock;
+		return clock;
+	}
+
+	/// Return the current time.
+	ms_time_t now() const {
+		return _now;
+	}
+
+	/// Return true and set deadline to the earliest ticker deadline if a
+	/// ticker is attached, return false otherwise.
+	inline bool next_deadline(ms_time_t& deadline) const;
+
+	/// Move the time to the earliest ticker deadline and fire the tickers
+	/// expiring at that time.
+	/// @return false if no ticker is attached.
+	inline bool step();
+
+	/// Move the time forward by duration, tickers expiring in the meantime
+	/// are fired in order.
+	inline void advance(ms_time_t duration);
+
+	/// Set the time back to 0, tickers attached are not modified.
+	void reset() {
+		_now = 0;
+	}
+
+private:
+	VirtualClock() : _now(0), _sequence(0), _tickers(NULL) { }
+
+	inline VirtualTicker* earliest_ticker() const;
+	inline void fire(VirtualTicker* ticker);
+
+	ms_time_t _now;
+	uint32_t _sequence;
+	VirtualTicker* _tickers;
+};
+
+/**
+ * Ticker driven by the VirtualClock, it models the interface of mbed::Ticker
+ * used by EventQueueClassic.
+ */
+class VirtualTicker {
+	friend class VirtualClock;
+
+public:
+	VirtualTicker() :
+		_callback(NULL), _deadline(0), _sequence(0), _next(NULL) {
+	}
+
+	~VirtualTicker() {
+		detach();
+	}
+
+	/// Call f once, seconds after the current time of the clock.
+	template<typename F>
+	void attach(const F& f, float seconds) {
+		detach();
+		VirtualClock& clock = VirtualClock::instance();
+		_callback = new CallbackHolder<F>(f);
+		_deadline = clock._now + (VirtualClock::ms_time_t) (seconds * 1000.0f + 0.5f);
+		_sequence = clock._sequence++;
+		_next = clock._tickers;
+		clock._tickers = this;
+	}
+
+	/// Call method on object once, seconds after the current time of the clock.
+	template<typename T>
+	void attach(T* object, void (T::*method)(), float seconds) {
+		attach(MemberCallback<T>(object, method), seconds);
+	}
+
+	/// Cancel the pending call if any.
+	void detach() {
+		if (_callback == NULL) {
+			return;
+		}
+
+		VirtualTicker** it = &VirtualClock::instance()._tickers;
+		while (*it != this) {
+			it = &(*it)->_next;
+		}
+		*it = _next;
+		_next = NULL;
+
+		delete _callback;
+		_callback = NULL;
+	}
+
+private:
+	VirtualTicker(const VirtualTicker&);
+	VirtualTicker& operator=(const VirtualTicker&);
+
+	struct Callback {
+		virtual ~Callback() { }
+		virtual void call() = 0;
+	};
+
+	template<typename F>
+	struct CallbackHolder : Callback {
+		CallbackHolder(const F& f) : _f(f) { }
+		virtual void call() {
+			_f();
+		}
+		F _f;
+	};
+
+	template<typename T>
+	struct MemberCallback {
+		MemberCallback(T* object, void (T::*method)()) : _object(object), _method(method) { }
+		void operator()() const {
+			(_object->*_method)();
+		}
+		T* _object;
+		void (T::*_method)();
+	};
+
+	Callback* _callback;
+	VirtualClock::ms_time_t _deadline;
+	uint32_t _sequence;
+	VirtualTicker* _next;
+};
+
+/**
+ * Timer measuring the time of the VirtualClock, it models the interface of
+ * mbed::Timer used by EventQueueClassic.
+ */
+class VirtualTimer {
+public:
+	VirtualTimer() : _running(false), _start(0), _accumulated(0) { }
+
+	void start() {
+		if (!_running) {
+			_start = VirtualClock::instance().now();
+			_running = true;
+		}
+	}
+
+	void stop() {
+		if (_running) {
+			_accumulated += VirtualClock::instance().now() - _start;
+			_running = false;
+		}
+	}
+
+	void reset() {
+		_start = VirtualClock::instance().now();
+		_accumulated = 0;
+	}
+
+	int read_ms() const {
+		VirtualClock::ms_time_t elapsed = _accumulated;
+		if (_running) {
+			elapsed += VirtualClock::instance().now() - _start;
+		}
+		return elapsed;
+	}
+
+private:
+	bool _running;
+	VirtualClock::ms_time_t _start;
+	VirtualClock::ms_time_t _accumulated;
+};
+
+/**
+ * Critical section of a simulation: the virtual clock fires the tickers from
+ * the thread which steps it, nothing has to be masked.
+ */
+struct NoCriticalSection {
+	NoCriticalSection() { }
+};
+
+/**
+ * Dispatch probe of a simulation: callbacks dispatched by the simulated queues
+ * are not recorded by the perf instrumentation.
+ */
+struct NoDispatchProbe {
+	NoDispatchProbe() { }
+};
+
+VirtualTicker* VirtualClock::earliest_ticker() const {
+	VirtualTicker* result = NULL;
+	for (VirtualTicker* it = _tickers; it; it = it->_next) {
+		if (result == NULL ||
+			(int32_t) (it->_deadline - result->_deadline) < 0 ||
+			(it->_deadline == result->_deadline && (int32_t) (it->_sequence - result->_sequence) < 0)) {
+			result = it;
+		}
+	}
+	return result;
+}
+
+void VirtualClock::fire(VirtualTicker* ticker) {
+	// the ticker is detached before the call as the callback may attach it again
+	VirtualTicker::Callback* callback = ticker->_callback;
+	ticker->_callback = NULL;
+
+	VirtualTicker** it = &_tickers;
+	while (*it != ticker) {
+		it = &(*it)->_next;
+	}
+	*it = ticker->_next;
+	ticker->_next = NULL;
+
+	callback->call();
+	delete callback;
+}
+
+bool VirtualClock::next_deadline(ms_time_t& deadline) const {
+	VirtualTicker* ticker = earliest_ticker();
+	if (ticker == NULL) {
+		return false;
+	}
+	deadline = ticker->_deadline;
+	return true;
+}
+
+bool VirtualClock::step() {
+	VirtualTicker* ticker = earliest_ticker();
+	if (ticker == NULL) {
+		return false;
+	}
+
+	ms_time_t deadline = ticker->_deadline;
+	if ((int32_t) (deadline - _now) > 0) {
+		_now = deadline;
+	}
+
+	// tickers attached by the callbacks fire in a later step
+	uint32_t sequence = _sequence;
+	while (ticker && ticker->_deadline == deadline &&
+		(int32_t) (ticker->_sequence - sequence) < 0) {
+		fire(ticker);
+		ticker = earliest_ticker();
+	}
+	return true;
+}
+
+void VirtualClock::advance(ms_time_t duration) {
+	ms_time_t target = _now + duration;
+	VirtualTicker* ticker = earliest_ticker();
+	while (ticker && (int32_t) (ticker->_deadline - target) <= 0) {
+		if ((int32_t) (ticker->_deadline - _now) > 0) {
+			_now = ticker->_deadline;
+		}
+		fire(ticker);
+		ticker = earliest_ticker();
+	}
+	_now = target;
+}
+
+} // namespace eq
+
+#endif /* EVENTQUEUE_VIRTUALCLOCK_H_ */
@@ -0,0 +1,67 @@
+#ifndef BLE_CLIAPP_SERIALIZATION_CHUNKED_SERIALIZER_H_
+#define BLE_CLIAPP_SERIALIZATION_CHUNKED_SERIALIZER_H_
+
+#include "JSONOutputStream.h"
+
+namespace serialization {
+
+/**
+ * @brief Serializer which writes a value in several fragments.
+ * @details Large values can be written a fragment at a time: the serializer
+ * keeps its position between two calls to next, which lets the caller
+ * interleave other work between two fragments and bound the amount of data
+ * written at once.
+ *
+ * @code
+    struct RangeSerializer : public ChunkedSerializer {
+        RangeSerializer(int first, int last) : current(first), last(last), started(false) { }
+
+        virtual bool next(JSONOutputStream& os) {
+            if (!started) {
+                os << startArray;
+                started = true;
+            }
+
+            if (current == last) {
+                os << endArray;
+                return false;
+            }
+
+            os << current++;
+            return true;
+        }
+
+        int current;
+        int last;
+        bool started;
+    };
+ * @endcode
+ */
+class ChunkedSerializer {
+public:
+    virtual ~ChunkedSerializer() { }
+
+    /**
+     * @brief Write the next fragment of the value.
+     * @param os The stream to write into, it must be the same for all the
+     * fragments of the value.
+     * @return true if fragments remain to be written and false once the value
+     * is complete.
+     */
+    virtual bool next(JSONOutputStream& os) = 0;
+};
+
+/**
+ * @brief Write all the remaining fragments of a chunked serializer at once.
+ * @param os The output stream to operate on
+ * @param serializer The serializer to drain
+ * @return os
+ */
+static inline JSONOutputStream& operator<<(JSONOutputStream& os, ChunkedSerializer& serializer) {
+    while (serializer.next(os)) { }
+    return os;
+}
+
+} // namespace serialization
+
+#endif //BLE_CLIAPP_SERIALIZATION_CHUNKED_SERIALIZER_H_
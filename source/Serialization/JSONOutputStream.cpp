@@ -1,8 +1,10 @@
 #include <cstdio>
 #include <stdio.h>
 #include <cstdarg>
+#include <cstring>
 
 #include "JSONOutputStream.h"
+#include "util/Perf.h"
 
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
@@ -86,12 +88,12 @@ JSONOutputStream& nil(JSONOutputStream& os) {
     return os;
  }
 
-JSONOutputStream::JSONOutputStream(mbed::RawSerial& output) :
-    out(output), startNewValue(false) {
+JSONOutputStream::JSONOutputStream(OutputSink& output) :
+    out(output), startNewValue(false), written(0) {
 }
 
 JSONOutputStream::~JSONOutputStream() {
-    out.puts("\r\n");
+    out.write("\r\n");
     flush();
 }
 
@@ -104,6 +106,7 @@ JSONOutputStream& JSONOutputStream::format(const char *fmt, ...) {
 }
 
 JSONOutputStream& JSONOutputStream::vformat(const char *fmt, std::va_list list) {
+    PERF_SCOPE(JSON_OUTPUT);
     handleNewValue();
 
     // ARMCC microlib does not properly handle a size of 0.
@@ -113,32 +116,38 @@ JSONOutputStream& JSONOutputStream::vformat(const char *fmt, std::va_list list)
     if (len < 100) {
         char temp[100];
         vsprintf(temp, fmt, list);
-        out.puts(temp);
+        out.write(temp);
     } else {
         char *temp = new char[len + 1];
         vsprintf(temp, fmt, list);
-        out.puts(temp);
+        out.write(temp);
         delete[] temp;
     }
+    written += len;
 
     return *this;
 }
 
+// single characters are not measured, the cost of the probe would exceed the
+// cost of the operation
 void JSONOutputStream::put(char c) {
     handleNewValue();
-    out.putc(c);
+    out.put(c);
+    ++written;
 }
 
 void JSONOutputStream::write(const char* data, std::size_t count) {
+    PERF_SCOPE(JSON_OUTPUT);
     handleNewValue();
-    for (size_t i = 0; i < count; ++i) {
-        out.putc(data[i]);
-    }
+    out.write(data, count);
+    written += count;
 }
 
 void JSONOutputStream::write(const char* data) {
+    PERF_SCOPE(JSON_OUTPUT);
     handleNewValue();
-    out.puts(data);
+    out.write(data);
+    written += std::strlen(data);
 }
 
 void JSONOutputStream::flush() {
@@ -164,7 +173,8 @@ JSONOutputStream& JSONOutputStream::vformatValue(const char *fmt, std::va_list l
 
 void JSONOutputStream::handleNewValue() {
     if(startNewValue) {
-        out.puts(",");
+        out.write(",");
+        ++written;
         startNewValue = false;
     }
 }
@@ -4,17 +4,42 @@
 #include <stdint.h>
 #include <cstdarg>
 #include <cstdio>
+#include <cstddef>
 #include <memory>
 
-#ifndef YOTTA_CFG
-#include <drivers/RawSerial.h>
-#else
-#include <mbed-drivers/RawSerial.h>
-#endif
+namespace serialization {
 
-extern mbed::RawSerial& get_serial();
+/**
+ * @brief Destination of the characters written by output streams.
+ * @details It decouples the serialization from the device used to output
+ * data; the application provides the default sink with get_output_sink.
+ */
+class OutputSink {
+public:
+    /**
+     * @brief Write a single character.
+     */
+    virtual void put(char c) = 0;
 
-namespace serialization {
+    /**
+     * @brief Write a null terminated string.
+     */
+    virtual void write(const char* str) = 0;
+
+    /**
+     * @brief Write count characters from data.
+     */
+    virtual void write(const char* data, std::size_t count) = 0;
+
+protected:
+    ~OutputSink() { }
+};
+
+/**
+ * @brief Return the sink used by default by output streams.
+ * @note This function is implemented by the application.
+ */
+OutputSink& get_output_sink();
 
 /**
  * @brief Output JSON data to stdout
@@ -39,7 +64,7 @@ public:
     /**
      * @brief Instantiate a new output stream
      */
-    JSONOutputStream(mbed::RawSerial& output = get_serial());
+    JSONOutputStream(OutputSink& output = get_output_sink());
 
     ~JSONOutputStream();
 
@@ -203,6 +228,14 @@ public:
      */
     JSONOutputStream& vformatValue(const char *fmt, std::va_list list);
 
+    /**
+     * @brief Return the number of characters written into the stream since its
+     * construction. It is used to bound the amount of data written at once.
+     */
+    std::size_t bytesWritten() const {
+        return written;
+    }
+
 private:
     // disable all copy operation and move assignment (delete of move operations
     // is more questionable here)
@@ -211,8 +244,9 @@ private:
 
     void handleNewValue();
 
-    mbed::RawSerial& out;
+    OutputSink& out;
     bool startNewValue;
+    std::size_t written;
 };
 
 /**
@@ -220,10 +254,10 @@ private:
  * The event begin a new line with the characters '<<< '
  */
 struct JSONEventStream : public JSONOutputStream {
-    JSONEventStream(mbed::RawSerial& output = get_serial()) :
+    JSONEventStream(OutputSink& output = get_output_sink()) :
         JSONOutputStream(output)
     {
-        output.puts("<<< ");
+        output.write("<<< ");
     }
 };
 
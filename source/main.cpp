@@ -15,14 +15,22 @@
 #include "Commands/GattServerCommands.h"
 #include "Commands/GattClientCommands.h"
 #include "Commands/SecurityManagerCommands.h"
+#if defined(ENABLE_BENCH_COMMANDS)
+#include "Commands/BenchCommands.h"
+#endif
+#if defined(ENABLE_PERF_INSTRUMENTATION)
+#include "Commands/PerfCommands.h"
+#endif
 #include "Commands/parameters/AdvertisingParameters.h"
 #include "Commands/parameters/ScanParameters.h"
 #include "Commands/parameters/ConnectionParameters.h"
 
 #include "util/CriticalSectionLock.h"
+#include "util/Perf.h"
 typedef ::util::CriticalSectionLock CriticalSection;
 
 #include "util/CircularBuffer.h"
+#include "Serialization/JSONOutputStream.h"
 
 
 #ifdef YOTTA_CFG
@@ -30,9 +38,23 @@ typedef ::util::CriticalSectionLock CriticalSection;
 
 static eq::EventQueueMinar _taskQueue;
 #else
-#include "EventQueue/EventQueueClassic.h"
+#include "EventQueue/EventQueueClassicMbed.h"
+
+#ifndef MBED_CONF_APP_EVENT_QUEUE_CAPACITY
+static const std::size_t EVENT_QUEUE_CAPACITY = 10;
+#else
+static const std::size_t EVENT_QUEUE_CAPACITY = MBED_CONF_APP_EVENT_QUEUE_CAPACITY;
+#endif
+
+#ifndef MBED_CONF_APP_EVENT_QUEUE_SITE_COUNT
+static const std::size_t EVENT_QUEUE_SITE_COUNT = 16;
+#else
+static const std::size_t EVENT_QUEUE_SITE_COUNT = MBED_CONF_APP_EVENT_QUEUE_SITE_COUNT;
+#endif
 
-static eq::EventQueueClassic<10> _taskQueue;
+static eq::EventQueueClassic<
+    EVENT_QUEUE_CAPACITY, eq::MbedTicker, mbed::Timer, EVENT_QUEUE_SITE_COUNT
+> _taskQueue;
 #endif
 
 /**
@@ -69,6 +91,32 @@ RawSerial& get_serial() {
 
     return serial;
 }
+
+/**
+ * Output sink of the serialization module, data are written to the serial port.
+ */
+class SerialOutputSink : public serialization::OutputSink {
+public:
+    virtual void put(char c) {
+        get_serial().putc(c);
+    }
+
+    virtual void write(const char* str) {
+        get_serial().puts(str);
+    }
+
+    virtual void write(const char* data, std::size_t count) {
+        RawSerial& serial = get_serial();
+        for (std::size_t i = 0; i < count; ++i) {
+            serial.putc(data[i]);
+        }
+    }
+};
+
+serialization::OutputSink& serialization::get_output_sink() {
+    static SerialOutputSink sink;
+    return sink;
+}
 // constants
 static const size_t CIRCULAR_BUFFER_LENGTH = 768;
 static const size_t CONSUMER_BUFFER_LENGTH = 32;
@@ -103,6 +151,7 @@ static void whenRxInterrupt(void)
 // consumptions of bytes from the serial port.
 // this function should run in thread mode
 static void consumeSerialBytes(void) {
+    PERF_SCOPE(CONSUME_SERIAL_BYTES);
 // buffer of data
     uint8_t data[CONSUMER_BUFFER_LENGTH];
     uint32_t dataAvailable = 0;
@@ -161,10 +210,17 @@ void initialize_app_commands(void) {
     registerCommandSuite<AdvertisingParametersCommandSuiteDescription>();
     registerCommandSuite<ScanParametersCommandSuiteDescription>();
     registerCommandSuite<ConnectionParametersCommandSuiteDescription>();
+#if defined(ENABLE_BENCH_COMMANDS)
+    registerCommandSuite<BenchCommandSuiteDescription>();
+#endif
+#if defined(ENABLE_PERF_INSTRUMENTATION)
+    registerCommandSuite<PerfCommandSuiteDescription>();
+#endif
 }
 
 void scheduleBleEventsProcessing(BLE::OnEventsToProcessCallbackContext* context) {
-    taskQueue.post(&BLE::processEvents, &context->ble);
+    // the stack is processed before the other events ready
+    taskQueue.post(eq::EventQueue::PRIORITY_HIGH, &BLE::processEvents, &context->ble);
 }
 
 void app_start(int, char*[])
@@ -176,6 +232,10 @@ void app_start(int, char*[])
     get_serial().baud(115200);    // This is default baudrate for our test applications. 230400 is also working, but not 460800. At least with k64f.
     get_serial().attach(whenRxInterrupt);
 
+#if defined(ENABLE_PERF_INSTRUMENTATION)
+    perf::initialize();
+#endif
+
     cmd_init( &custom_cmd_response_out );
     cmd_set_ready_cb( cmd_ready_cb );
     cmd_history_size(1);
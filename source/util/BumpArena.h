@@ -0,0 +1,152 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BLE_CLIAPP_UTIL_BUMPARENA_H
+#define BLE_CLIAPP_UTIL_BUMPARENA_H
+
+#include <cstddef>
+#include <cstdlib>
+
+namespace util {
+
+/** Bump allocator.
+ *
+ * Memory is requested from the heap by chunks and handed out linearly;
+ * individual allocations are never released, the whole memory of the arena is
+ * released at once when the arena is cleared or destroyed. It is meant to hold
+ * objects sharing the same lifetime without fragmenting the heap.
+ *
+ * @note The arena does not run destructors of objects it holds.
+ */
+class BumpArena {
+
+public:
+    /**
+     * Construct an empty arena.
+     *
+     * @param chunkSize Minimum size of the chunks requested from the heap.
+     */
+    BumpArena(std::size_t chunkSize = 256) :
+        _head(NULL), _chunkSize(chunkSize) {
+    }
+
+    ~BumpArena() {
+        clear();
+    }
+
+    /**
+     * Allocate a block of memory aligned for any object.
+     *
+     * @param size The size of the block.
+     * @return The block allocated or NULL if the heap is exhausted.
+     */
+    void* allocate(std::size_t size) {
+        size = align(size);
+
+        if (!_head || (_head->capacity - _head->used) < size) {
+            std::size_t capacity = size > _chunkSize ? size : _chunkSize;
+            Chunk* chunk = static_cast<Chunk*>(std::malloc(HEADER_SIZE + capacity));
+            if (!chunk) {
+                return NULL;
+            }
+            chunk->next = _head;
+            chunk->capacity = capacity;
+            chunk->used = 0;
+            _head = chunk;
+        }
+
+        void* result = reinterpret_cast<char*>(_head) + HEADER_SIZE + _head->used;
+        _head->used += size;
+        return result;
+    }
+
+    /**
+     * Return the memory taken in the arena by a block of size bytes.
+     */
+    static std::size_t alignedSize(std::size_t size) {
+        return align(size);
+    }
+
+    /**
+     * Return the memory handed out by the arena, including the padding of
+     * each block.
+     */
+    std::size_t used() const {
+        std::size_t result = 0;
+        for (const Chunk* chunk = _head; chunk; chunk = chunk->next) {
+            result += chunk->used;
+        }
+        return result;
+    }
+
+    /**
+     * Return the number of chunks requested from the heap.
+     */
+    std::size_t chunkCount() const {
+        std::size_t result = 0;
+        for (const Chunk* chunk = _head; chunk; chunk = chunk->next) {
+            ++result;
+        }
+        return result;
+    }
+
+    /**
+     * Release all the memory held by the arena.
+     */
+    void clear() {
+        while (_head) {
+            Chunk* next = _head->next;
+            std::free(_head);
+            _head = next;
+        }
+    }
+
+    /**
+     * Exchange the content of two arenas.
+     */
+    void swap(BumpArena& other) {
+        Chunk* head = _head;
+        _head = other._head;
+        other._head = head;
+
+        std::size_t chunkSize = _chunkSize;
+        _chunkSize = other._chunkSize;
+        other._chunkSize = chunkSize;
+    }
+
+private:
+    BumpArena(const BumpArena&);
+    BumpArena& operator=(const BumpArena&);
+
+    struct Chunk {
+        Chunk* next;
+        std::size_t capacity;
+        std::size_t used;
+    };
+
+    static const std::size_t ALIGNMENT = 8;
+    static const std::size_t HEADER_SIZE = (sizeof(Chunk) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+    static std::size_t align(std::size_t size) {
+        return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+    Chunk* _head;
+    std::size_t _chunkSize;
+};
+
+} // namespace util
+
+#endif /* BLE_CLIAPP_UTIL_BUMPARENA_H */
@@ -131,6 +131,17 @@ public:
         return _full;
     }
 
+    /** Number of elements held by the buffer
+     *
+     * @return The number of elements which can be pop from the buffer
+     */
+    CounterType size() const {
+        if (_full) {
+            return BufferSize;
+        }
+        return (_head >= _tail) ? (_head - _tail) : (BufferSize - _tail + _head);
+    }
+
     /**
      * Reset the buffer
      */
@@ -0,0 +1,183 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BLE_CLIAPP_UTIL_LOG2HISTOGRAM_H
+#define BLE_CLIAPP_UTIL_LOG2HISTOGRAM_H
+
+#include <stdint.h>
+#include <cstddef>
+
+namespace util {
+
+/** Histogram of unsigned values with fixed, power of two sized, buckets.
+ *
+ * Bucket 0 holds the value 0 and bucket i holds values in the range
+ * [2^(i - 1), 2^i - 1]. Values which do not fit in the last bucket are
+ * accounted in it. Besides buckets, the histogram keeps the exact count, sum,
+ * min and max of the values recorded.
+ *
+ * @tparam BucketCount The number of buckets of the histogram.
+ */
+template<std::size_t BucketCount>
+class Log2Histogram {
+
+public:
+    Log2Histogram() {
+        reset();
+    }
+
+    /**
+     * Record a value in the histogram.
+     *
+     * @param value The value to record.
+     */
+    void record(uint32_t value) {
+        ++_buckets[bucketIndex(value)];
+        ++_count;
+        _sum += value;
+        if (value < _min) {
+            _min = value;
+        }
+        if (value > _max) {
+            _max = value;
+        }
+    }
+
+    /**
+     * Reset the histogram
+     */
+    void reset() {
+        for (std::size_t i = 0; i < BucketCount; ++i) {
+            _buckets[i] = 0;
+        }
+        _count = 0;
+        _sum = 0;
+        _min = 0xFFFFFFFF;
+        _max = 0;
+    }
+
+    /**
+     * Return the number of values recorded.
+     */
+    uint32_t count() const {
+        return _count;
+    }
+
+    /**
+     * Return the sum of the values recorded.
+     */
+    uint64_t sum() const {
+        return _sum;
+    }
+
+    /**
+     * Return the smallest value recorded or 0 if the histogram is empty.
+     */
+    uint32_t min() const {
+        return _count ? _min : 0;
+    }
+
+    /**
+     * Return the greatest value recorded.
+     */
+    uint32_t max() const {
+        return _max;
+    }
+
+    /**
+     * Return the mean of the values recorded or 0 if the histogram is empty.
+     */
+    uint32_t mean() const {
+        return _count ? (uint32_t) (_sum / _count) : 0;
+    }
+
+    /**
+     * Return an upper bound of the given percentile.
+     * @details The value returned is the upper bound of the bucket holding the
+     * percentile, capped by the maximum value recorded.
+     *
+     * @param percent The percentile to compute, between 0 and 100.
+     */
+    uint32_t percentile(uint8_t percent) const {
+        if (_count == 0) {
+            return 0;
+        }
+
+        // rank of the value in the sorted set of values, rounded up
+        uint64_t rank = (((uint64_t) _count * percent) + 99) / 100;
+        if (rank == 0) {
+            rank = 1;
+        }
+
+        uint64_t cumulated = 0;
+        for (std::size_t i = 0; i < BucketCount; ++i) {
+            cumulated += _buckets[i];
+            if (cumulated >= rank) {
+                uint32_t bound = bucketUpperBound(i);
+                return bound < _max ? bound : _max;
+            }
+        }
+
+        return _max;
+    }
+
+    /**
+     * Return the number of values held by a bucket.
+     *
+     * @param index The index of the bucket.
+     */
+    uint32_t bucket(std::size_t index) const {
+        return _buckets[index];
+    }
+
+    /**
+     * Return the number of buckets of the histogram.
+     */
+    static std::size_t bucketCount() {
+        return BucketCount;
+    }
+
+    /**
+     * Return the greatest value accounted by a bucket.
+     *
+     * @param index The index of the bucket.
+     */
+    static uint32_t bucketUpperBound(std::size_t index) {
+        if (index == (BucketCount - 1) || index >= 32) {
+            return 0xFFFFFFFF;
+        }
+        return (((uint32_t) 1) << index) - 1;
+    }
+
+private:
+    static std::size_t bucketIndex(uint32_t value) {
+        std::size_t index = 0;
+        while (value) {
+            value >>= 1;
+            ++index;
+        }
+        return index < BucketCount ? index : BucketCount - 1;
+    }
+
+    uint32_t _buckets[BucketCount];
+    uint32_t _count;
+    uint64_t _sum;
+    uint32_t _min;
+    uint32_t _max;
+};
+
+} // namespace util
+
+#endif /* BLE_CLIAPP_UTIL_LOG2HISTOGRAM_H */
@@ -0,0 +1,391 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Perf.h"
+
+#if defined(ENABLE_PERF_INSTRUMENTATION)
+
+#include <string.h>
+
+#if defined(MBED_HEAP_STATS_ENABLED) && MBED_HEAP_STATS_ENABLED
+#define PERF_HEAP_STATS
+#include "platform/mbed_stats.h"
+#endif
+
+#if defined(MBED_CONF_RTOS_PRESENT) && defined(__arm__)
+#define PERF_STACK_PAINTING
+#include "cmsis_os2.h"
+#include "rtx_os.h"
+#endif
+
+#if defined(BLE_CLIAPP_PERF_ASSERT_BUDGETS)
+#if defined(__arm__)
+#include "platform/mbed_error.h"
+#define PERF_BUDGET_EXCEEDED(module, name) \
+    error("perf: %s %s exceeds its memory budget\r\n", module, name)
+#else
+#include <cstdio>
+#include <cstdlib>
+#define PERF_BUDGET_EXCEEDED(module, name) \
+    (std::fprintf(stderr, "perf: %s %s exceeds its memory budget\n", module, name), std::abort())
+#endif
+#endif
+
+namespace perf {
+
+namespace {
+
+histogram_t histograms[PROBE_COUNT];
+
+CommandStatistics commands[COMMAND_TABLE_SIZE];
+std::size_t commandsUsed = 0;
+uint32_t commandsDropped = 0;
+
+/*
+ * State of the command in progress; the command line interface does not
+ * accept a new command until the response of the previous one is closed.
+ */
+/*
+ * Boundaries of the phases are in microseconds; parse and output accumulate
+ * measures of the probes, in the unit of the probes.
+ */
+struct Trace {
+    bool active;
+    bool handlerReturned;
+    CommandStatistics* entry;
+    uint64_t start;
+    uint64_t handlerStart;
+    uint64_t handlerEnd;
+    uint64_t parse;
+    uint64_t output;
+    uint64_t outputAtHandlerEnd;
+    uint32_t heapStart;
+    uint32_t heapPeak;
+    uint32_t heapMaxStart;
+    uint32_t heapTotalStart;
+    uint32_t heapCountStart;
+    uint32_t stackDepth;
+};
+
+Trace trace;
+
+#if defined(PERF_HEAP_STATS)
+void sampleHeap() {
+    mbed_stats_heap_t stats;
+    mbed_stats_heap_get(&stats);
+    if (stats.current_size > trace.heapPeak) {
+        trace.heapPeak = stats.current_size;
+    }
+}
+#endif
+
+#if defined(PERF_STACK_PAINTING)
+// pattern written in the free part of the stack
+static const uint32_t STACK_PAINT = 0xCCCCCCCC;
+
+// words left untouched below the stack pointer of the caller
+static const std::size_t STACK_PAINT_MARGIN = 16;
+
+/*
+ * Return the lowest word of the stack of the current thread; the first word
+ * holds the overflow canary of RTX and is skipped.
+ */
+uint32_t* stackBottom() {
+    osRtxThread_t* thread = reinterpret_cast<osRtxThread_t*>(osThreadGetId());
+    return static_cast<uint32_t*>(thread->stack_mem) + 1;
+}
+
+uint32_t* stackTop() {
+    osRtxThread_t* thread = reinterpret_cast<osRtxThread_t*>(osThreadGetId());
+    return reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(thread->stack_mem) + thread->stack_size);
+}
+
+void paintStack() {
+    uint32_t* end = reinterpret_cast<uint32_t*>(__get_PSP()) - STACK_PAINT_MARGIN;
+    for (uint32_t* it = stackBottom(); it < end; ++it) {
+        *it = STACK_PAINT;
+    }
+}
+
+uint32_t stackHighWater() {
+    uint32_t* it = stackBottom();
+    uint32_t* top = stackTop();
+    while (it < top && *it == STACK_PAINT) {
+        ++it;
+    }
+    return (top - it) * sizeof(uint32_t);
+}
+#endif
+
+CommandStatistics* findOrCreateCommand(const char* module, const void* command, const char* name) {
+    for (std::size_t i = 0; i < commandsUsed; ++i) {
+        if (commands[i].command == command) {
+            return &commands[i];
+        }
+    }
+
+    if (commandsUsed == COMMAND_TABLE_SIZE) {
+        return NULL;
+    }
+
+    CommandStatistics* entry = &commands[commandsUsed++];
+    entry->command = command;
+    entry->name = name;
+    strncpy(entry->module, module, sizeof(entry->module) - 1);
+    entry->module[sizeof(entry->module) - 1] = '\0';
+    entry->latency.reset();
+    entry->parse = 0;
+    entry->handler = 0;
+    entry->asyncWait = 0;
+    entry->output = 0;
+    entry->heapPeak = 0;
+    entry->heapAllocated = 0;
+    entry->heapOutstanding = 0;
+    entry->stackHighWater = 0;
+    entry->overBudget = 0;
+    return entry;
+}
+
+} // end of anonymous namespace
+
+void initialize() {
+#if defined(__arm__) && defined(__CORTEX_M) && (__CORTEX_M >= 3)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#elif defined(__arm__)
+    us_ticker_init();
+#endif
+}
+
+const char* unit() {
+#if defined(__arm__) && defined(__CORTEX_M) && (__CORTEX_M >= 3)
+    return "cycles";
+#elif defined(__arm__)
+    return "us";
+#else
+    return "ns";
+#endif
+}
+
+uint64_t toUs(uint64_t elapsed) {
+#if defined(__arm__) && defined(__CORTEX_M) && (__CORTEX_M >= 3)
+    return elapsed / (SystemCoreClock / 1000000);
+#elif defined(__arm__)
+    return elapsed;
+#else
+    return elapsed / 1000;
+#endif
+}
+
+const char* name(probe_t probe) {
+    static const char* const names[PROBE_COUNT] = {
+        "consume_serial_bytes",
+        "command_dispatch",
+        "argument_parsing",
+        "handler_execution",
+        "json_output",
+        "event_queue_dispatch"
+    };
+    return names[probe];
+}
+
+void record(probe_t probe, uint32_t elapsed) {
+    histograms[probe].record(elapsed);
+
+    if (trace.active) {
+        if (probe == ARGUMENT_PARSING) {
+            trace.parse += elapsed;
+        } else if (probe == JSON_OUTPUT) {
+            trace.output += elapsed;
+        }
+    }
+}
+
+const histogram_t& histogram(probe_t probe) {
+    return histograms[probe];
+}
+
+void reset() {
+    for (std::size_t i = 0; i < PROBE_COUNT; ++i) {
+        histograms[i].reset();
+    }
+    commandsUsed = 0;
+    commandsDropped = 0;
+    trace.entry = NULL;
+}
+
+void beginCommand() {
+    memset(&trace, 0, sizeof(trace));
+
+#if defined(PERF_HEAP_STATS)
+    mbed_stats_heap_t stats;
+    mbed_stats_heap_get(&stats);
+    trace.heapStart = stats.current_size;
+    trace.heapPeak = stats.current_size;
+    trace.heapMaxStart = stats.max_size;
+    trace.heapTotalStart = stats.total_size;
+    trace.heapCountStart = stats.alloc_cnt;
+#endif
+
+#if defined(PERF_STACK_PAINTING)
+    paintStack();
+#endif
+
+    trace.active = true;
+    trace.start = nowUs();
+}
+
+void commandHandlerStarted(const char* module, const void* command, const char* name) {
+    if (!trace.active) {
+        return;
+    }
+
+    trace.entry = findOrCreateCommand(module, command, name);
+    if (trace.entry == NULL) {
+        ++commandsDropped;
+        trace.active = false;
+        return;
+    }
+
+#if defined(PERF_HEAP_STATS)
+    sampleHeap();
+#endif
+
+    trace.handlerStart = nowUs();
+}
+
+void commandHandlerReturned() {
+    if (!trace.active) {
+        return;
+    }
+
+    trace.handlerReturned = true;
+    trace.handlerEnd = nowUs();
+    trace.outputAtHandlerEnd = trace.output;
+
+#if defined(PERF_HEAP_STATS)
+    sampleHeap();
+#endif
+
+#if defined(PERF_STACK_PAINTING)
+    // events dispatched while the response is open run on the same thread,
+    // the stack is measured before they do
+    trace.stackDepth = stackHighWater();
+#endif
+}
+
+void endCommand() {
+    if (!trace.active) {
+        return;
+    }
+
+    uint64_t end = nowUs();
+    trace.active = false;
+
+    CommandStatistics* entry = trace.entry;
+    if (entry == NULL) {
+        return;
+    }
+
+    if (!trace.handlerReturned) {
+        trace.handlerEnd = end;
+        trace.outputAtHandlerEnd = trace.output;
+    }
+
+    uint64_t total = end - trace.start;
+    uint64_t output = toUs(trace.output);
+    uint64_t asyncOutput = toUs(trace.output - trace.outputAtHandlerEnd);
+    uint64_t parse = (trace.handlerStart - trace.start) + toUs(trace.parse);
+    uint64_t asyncWait = end - trace.handlerEnd;
+    asyncWait = (asyncWait > asyncOutput) ? asyncWait - asyncOutput : 0;
+    uint64_t accounted = parse + output + asyncWait;
+
+    entry->latency.record((total > 0xFFFFFFFFu) ? 0xFFFFFFFFu : (uint32_t) total);
+    entry->parse += parse;
+    entry->handler += (total > accounted) ? total - accounted : 0;
+    entry->asyncWait += asyncWait;
+    entry->output += output;
+
+#if defined(PERF_HEAP_STATS)
+    mbed_stats_heap_t stats;
+    mbed_stats_heap_get(&stats);
+    uint32_t heapPeak = trace.heapPeak;
+    if (stats.max_size > trace.heapMaxStart) {
+        // the command has raised the peak of the heap
+        heapPeak = stats.max_size;
+    } else if (stats.current_size > heapPeak) {
+        heapPeak = stats.current_size;
+    }
+    uint32_t heapGrowth = heapPeak - trace.heapStart;
+    if (heapGrowth > entry->heapPeak) {
+        entry->heapPeak = heapGrowth;
+    }
+    entry->heapAllocated += stats.total_size - trace.heapTotalStart;
+    entry->heapOutstanding += (int32_t) (stats.alloc_cnt - trace.heapCountStart);
+#endif
+
+#if defined(PERF_STACK_PAINTING)
+    if (trace.stackDepth > entry->stackHighWater) {
+        entry->stackHighWater = trace.stackDepth;
+    }
+#endif
+
+    bool overBudget = false;
+#if defined(PERF_HEAP_STATS)
+    overBudget = overBudget || (HEAP_BUDGET && heapGrowth > HEAP_BUDGET);
+#endif
+#if defined(PERF_STACK_PAINTING)
+    overBudget = overBudget || (STACK_BUDGET && trace.stackDepth > STACK_BUDGET);
+#endif
+    if (overBudget) {
+        ++entry->overBudget;
+#if defined(BLE_CLIAPP_PERF_ASSERT_BUDGETS)
+        PERF_BUDGET_EXCEEDED(entry->module, entry->name);
+#endif
+    }
+}
+
+std::size_t commandCount() {
+    return commandsUsed;
+}
+
+const CommandStatistics& commandStatistics(std::size_t index) {
+    return commands[index];
+}
+
+uint32_t droppedCommands() {
+    return commandsDropped;
+}
+
+bool heapStatisticsEnabled() {
+#if defined(PERF_HEAP_STATS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool stackPaintingEnabled() {
+#if defined(PERF_STACK_PAINTING)
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace perf
+
+#endif // defined(ENABLE_PERF_INSTRUMENTATION)
@@ -0,0 +1,277 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BLE_CLIAPP_UTIL_PERF_H
+#define BLE_CLIAPP_UTIL_PERF_H
+
+/**
+ * Instrumentation of the hot paths of the application.
+ *
+ * Probes measure the time spent in a scope and record it in a histogram per
+ * probe. Probes are compiled in only when ENABLE_PERF_INSTRUMENTATION is
+ * defined, otherwise PERF_SCOPE expands to nothing.
+ *
+ * Time is measured with the DWT cycle counter on Cortex-M3 and above, with the
+ * microsecond ticker on other Cortex-M cores and with the monotonic clock in
+ * nanoseconds off target.
+ *
+ * Commands are traced from the reception of their line to the closing of
+ * their response; the latency of each command is aggregated in a fixed table.
+ * The table also records the heap and stack consumed by each command: heap
+ * figures require MBED_HEAP_STATS_ENABLED, the stack high-water mark is
+ * measured by painting the stack of the thread running the commands and
+ * requires the RTOS.
+ */
+#if defined(ENABLE_PERF_INSTRUMENTATION)
+
+#include <stdint.h>
+#include <cstddef>
+#include "util/Log2Histogram.h"
+
+#if defined(__arm__)
+#include "cmsis.h"
+#include "hal/us_ticker_api.h"
+#else
+#include <time.h>
+#endif
+
+namespace perf {
+
+/**
+ * Instrumentation points; a probe may run within another one: the handler
+ * execution includes argument parsing. Command dispatch only covers the
+ * lookup of the command and the check of its arguments count.
+ */
+enum probe_t {
+    CONSUME_SERIAL_BYTES,
+    COMMAND_DISPATCH,
+    ARGUMENT_PARSING,
+    HANDLER_EXECUTION,
+    JSON_OUTPUT,
+    EVENT_QUEUE_DISPATCH,
+    PROBE_COUNT
+};
+
+typedef util::Log2Histogram<32> histogram_t;
+
+#ifndef BLE_CLIAPP_PERF_COMMAND_TABLE_SIZE
+static const std::size_t COMMAND_TABLE_SIZE = 16;
+#else
+static const std::size_t COMMAND_TABLE_SIZE = BLE_CLIAPP_PERF_COMMAND_TABLE_SIZE;
+#endif
+
+/*
+ * Memory budget of a command invocation, 0 disables the budget. Invocations
+ * over budget are counted; if BLE_CLIAPP_PERF_ASSERT_BUDGETS is defined they
+ * also stop the program.
+ */
+#ifndef BLE_CLIAPP_PERF_HEAP_BUDGET
+static const uint32_t HEAP_BUDGET = 0;
+#else
+static const uint32_t HEAP_BUDGET = BLE_CLIAPP_PERF_HEAP_BUDGET;
+#endif
+
+#ifndef BLE_CLIAPP_PERF_STACK_BUDGET
+static const uint32_t STACK_BUDGET = 0;
+#else
+static const uint32_t STACK_BUDGET = BLE_CLIAPP_PERF_STACK_BUDGET;
+#endif
+
+/**
+ * Latency of a command, in microseconds.
+ * @details The time of each invocation is split in exclusive phases, sums of
+ * each phase are kept:
+ *   - parse: lookup of the command and decoding of its arguments.
+ *   - handler: synchronous execution of the handler.
+ *   - asyncWait: time between the return of the handler and the closing of
+ *     the response.
+ *   - output: JSON output written while the command is in progress.
+ *
+ * Heap peaks are sampled at the boundaries of the phases, they are exact when
+ * the command raises the peak of the heap. The stack depth is measured when
+ * the handler returns: it covers the parsing and the synchronous execution of
+ * the handler, not the events processed while the response is open.
+ */
+struct CommandStatistics {
+    const void* command;
+    const char* name;
+    char module[16];
+    histogram_t latency;
+    uint64_t parse;
+    uint64_t handler;
+    uint64_t asyncWait;
+    uint64_t output;
+    uint32_t heapPeak;          /// greatest heap growth during an invocation
+    uint64_t heapAllocated;     /// bytes allocated by all the invocations
+    int32_t heapOutstanding;    /// allocations still alive after the invocations
+    uint32_t stackHighWater;    /// greatest stack depth of the synchronous part of an invocation
+    uint32_t overBudget;        /// invocations which exceeded HEAP_BUDGET or STACK_BUDGET
+};
+
+/**
+ * Start the time source, it must be called before any measure.
+ */
+void initialize();
+
+/**
+ * Return the unit of the measures: "cycles", "us" or "ns".
+ */
+const char* unit();
+
+/**
+ * Return the name of a probe.
+ */
+const char* name(probe_t probe);
+
+/**
+ * Record a measure of a probe.
+ */
+void record(probe_t probe, uint32_t elapsed);
+
+/**
+ * Access the histogram of a probe.
+ */
+const histogram_t& histogram(probe_t probe);
+
+/**
+ * Reset the histograms of all the probes and the command table.
+ */
+void reset();
+
+/**
+ * Start the trace of a command; called when a command line is received.
+ */
+void beginCommand();
+
+/**
+ * Signal that the handler of the command traced is about to run.
+ *
+ * @param module Name of the module of the command.
+ * @param command Key of the command in the table.
+ * @param name Name of the command, it must outlive the table.
+ */
+void commandHandlerStarted(const char* module, const void* command, const char* name);
+
+/**
+ * Signal that the handler of the command traced has returned.
+ */
+void commandHandlerReturned();
+
+/**
+ * End the trace of a command; called when its response is closed. Commands
+ * whose handler has not run are not accounted.
+ */
+void endCommand();
+
+/**
+ * Return the number of entries used in the command table.
+ */
+std::size_t commandCount();
+
+/**
+ * Access an entry of the command table.
+ */
+const CommandStatistics& commandStatistics(std::size_t index);
+
+/**
+ * Return the number of invocations not accounted because the command table
+ * was full.
+ */
+uint32_t droppedCommands();
+
+/**
+ * Return true if heap statistics are recorded.
+ */
+bool heapStatisticsEnabled();
+
+/**
+ * Return true if stack high-water marks are recorded.
+ */
+bool stackPaintingEnabled();
+
+/**
+ * Return the current time.
+ */
+inline uint32_t now() {
+#if defined(__arm__) && defined(__CORTEX_M) && (__CORTEX_M >= 3)
+    return DWT->CYCCNT;
+#elif defined(__arm__)
+    return us_ticker_read();
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) ts.tv_sec * 1000000000u + (uint32_t) ts.tv_nsec;
+#endif
+}
+
+/**
+ * Return the current time in microseconds on 64 bits.
+ * @details Commands are timed with this clock rather than with now(): a
+ * response may be closed long after the command has been received, the cycle
+ * counter would wrap in the meantime.
+ */
+inline uint64_t nowUs() {
+#if defined(__arm__)
+    return ticker_read_us(get_us_ticker_data());
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000u) + (ts.tv_nsec / 1000);
+#endif
+}
+
+/**
+ * Convert a measure of the probes into microseconds.
+ */
+uint64_t toUs(uint64_t elapsed);
+
+/**
+ * Record the time spent between its construction and its destruction.
+ */
+class Scope {
+public:
+    Scope(probe_t probe) : _probe(probe), _start(now()) { }
+
+    ~Scope() {
+        record(_probe, now() - _start);
+    }
+
+private:
+    Scope(const Scope&);
+    Scope& operator=(const Scope&);
+
+    probe_t _probe;
+    uint32_t _start;
+};
+
+} // namespace perf
+
+#define PERF_SCOPE(probe) ::perf::Scope perf_scope_(::perf::probe)
+#define PERF_COMMAND_BEGIN() ::perf::beginCommand()
+#define PERF_COMMAND_HANDLER_STARTED(module, command, name) ::perf::commandHandlerStarted(module, command, name)
+#define PERF_COMMAND_HANDLER_RETURNED() ::perf::commandHandlerReturned()
+#define PERF_COMMAND_END() ::perf::endCommand()
+
+#else // !defined(ENABLE_PERF_INSTRUMENTATION)
+
+#define PERF_SCOPE(probe)
+#define PERF_COMMAND_BEGIN()
+#define PERF_COMMAND_HANDLER_STARTED(module, command, name)
+#define PERF_COMMAND_HANDLER_RETURNED()
+#define PERF_COMMAND_END()
+
+#endif // defined(ENABLE_PERF_INSTRUMENTATION)
+
+#endif /* BLE_CLIAPP_UTIL_PERF_H */
@@ -0,0 +1,216 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BLE_CLIAPP_UTIL_RECORDQUEUE_H
+#define BLE_CLIAPP_UTIL_RECORDQUEUE_H
+
+#include <stdint.h>
+#include <cstddef>
+
+namespace util {
+
+/** FIFO of variable size records stored in a fixed size buffer.
+ *
+ * Each record is made of a type tag and a contiguous block of memory aligned
+ * for any object; records never straddle the end of the buffer.
+ *
+ * A record is pushed in two steps: the producer reserves the memory of the
+ * record with reserve, fills it then publish it with commit. Records are
+ * consumed in order with front and pop.
+ *
+ * @note The queue does not run destructors of objects it holds.
+ *
+ * @tparam Capacity The size in bytes of the storage of the queue.
+ */
+template<std::size_t Capacity>
+class RecordQueue {
+
+public:
+    RecordQueue() :
+        _head(0), _tail(0), _end(0), _count(0), _wrapped(false),
+        _reservedPosition(0), _reservedSize(0) {
+    }
+
+    /**
+     * Reserve the memory of a new record at the back of the queue.
+     *
+     * @param type The type of the record.
+     * @param size The size of the record.
+     *
+     * @return The memory of the record or NULL if there is not enough room left
+     * in the queue. The record is not visible to the consumer until commit is
+     * called.
+     */
+    void* reserve(uint8_t type, std::size_t size) {
+        std::size_t fullSize = HEADER_SIZE + align(size);
+        if (size > 0xFFFF || fullSize > CAPACITY) {
+            return NULL;
+        }
+
+        _reservedSize = 0;
+        if (_wrapped) {
+            if ((_tail - _head) < fullSize) {
+                return NULL;
+            }
+            _reservedPosition = _head;
+        } else if ((CAPACITY - _head) >= fullSize) {
+            _reservedPosition = _head;
+        } else if (_tail >= fullSize) {
+            _reservedPosition = 0;
+        } else {
+            return NULL;
+        }
+
+        Header* header = headerAt(_reservedPosition);
+        header->size = size;
+        header->type = type;
+        _reservedSize = fullSize;
+        return bytes() + _reservedPosition + HEADER_SIZE;
+    }
+
+    /**
+     * Publish the last record reserved.
+     */
+    void commit() {
+        if (_reservedSize == 0) {
+            return;
+        }
+
+        if (!_wrapped && _reservedPosition < _head) {
+            _end = _head;
+            _wrapped = true;
+        }
+
+        _head = _reservedPosition + _reservedSize;
+        _reservedSize = 0;
+        ++_count;
+    }
+
+    /**
+     * Access the record at the front of the queue.
+     *
+     * @param type Set to the type of the record.
+     * @param size Set to the size of the record.
+     *
+     * @return The record at the front of the queue or NULL if the queue is
+     * empty.
+     */
+    const void* front(uint8_t& type, std::size_t& size) const {
+        if (_count == 0) {
+            return NULL;
+        }
+
+        const Header* header = headerAt(_tail);
+        type = header->type;
+        size = header->size;
+        return bytes() + _tail + HEADER_SIZE;
+    }
+
+    /**
+     * Remove the record at the front of the queue.
+     */
+    void pop() {
+        if (_count == 0) {
+            return;
+        }
+
+        _tail += HEADER_SIZE + align(headerAt(_tail)->size);
+        --_count;
+
+        if (_count == 0) {
+            _head = 0;
+            _tail = 0;
+            _wrapped = false;
+        } else if (_wrapped && _tail == _end) {
+            _tail = 0;
+            _wrapped = false;
+        }
+    }
+
+    /**
+     * Return true if the queue does not contain any record.
+     */
+    bool empty() const {
+        return _count == 0;
+    }
+
+    /**
+     * Return the number of records held by the queue.
+     */
+    std::size_t size() const {
+        return _count;
+    }
+
+    /**
+     * Return the size of the largest record the queue can hold.
+     */
+    static std::size_t maxRecordSize() {
+        return (CAPACITY - HEADER_SIZE) < 0xFFFF ? (CAPACITY - HEADER_SIZE) : 0xFFFF;
+    }
+
+    /**
+     * Remove all the records of the queue.
+     */
+    void reset() {
+        _head = 0;
+        _tail = 0;
+        _count = 0;
+        _wrapped = false;
+        _reservedSize = 0;
+    }
+
+private:
+    struct Header {
+        uint16_t size;
+        uint8_t type;
+    };
+
+    static const std::size_t ALIGNMENT = 8;
+    static const std::size_t HEADER_SIZE = (sizeof(Header) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    static const std::size_t CAPACITY = (Capacity + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+    static std::size_t align(std::size_t size) {
+        return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+    uint8_t* bytes() {
+        return reinterpret_cast<uint8_t*>(_storage);
+    }
+
+    const uint8_t* bytes() const {
+        return reinterpret_cast<const uint8_t*>(_storage);
+    }
+
+    Header* headerAt(std::size_t position) {
+        return reinterpret_cast<Header*>(bytes() + position);
+    }
+
+    const Header* headerAt(std::size_t position) const {
+        return reinterpret_cast<const Header*>(bytes() + position);
+    }
+
+    uint64_t _storage[CAPACITY / sizeof(uint64_t)];
+    std::size_t _head;
+    std::size_t _tail;
+    std::size_t _end;
+    std::size_t _count;
+    bool _wrapped;
+    std::size_t _reservedPosition;
+    std::size_t _reservedSize;
+};
+
+} // namespace util
+
+#endif /* BLE_CLIAPP_UTIL_RECORDQUEUE_H */
@@ -0,0 +1,151 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BLE_CLIAPP_UTIL_SLABPOOL_H
+#define BLE_CLIAPP_UTIL_SLABPOOL_H
+
+#include <stdint.h>
+#include <cstddef>
+
+namespace util {
+
+/** Pool of fixed size memory slots.
+ *
+ * The slots are held in the pool itself, allocation and release are O(1) and
+ * never touch the heap. Slots are handed out from a free list; slots never
+ * used are taken in order so a pool with static storage duration does not
+ * need to be initialized.
+ *
+ * The pool records its occupancy, the peak of occupancy and the number of
+ * allocations which failed because the pool was full.
+ *
+ * @note The pool is not thread safe.
+ */
+template<std::size_t SlotSize, std::size_t SlotCount>
+class SlabPool {
+
+public:
+    /**
+     * Construct an empty pool.
+     */
+    SlabPool() : _free(NULL), _initialized(0), _used(0), _peak(0), _exhausted(0) { }
+
+    /**
+     * Allocate a slot aligned for any object.
+     *
+     * @return The slot allocated or NULL if all the slots are in use.
+     */
+    void* allocate() {
+        Slot* slot = _free;
+        if (slot) {
+            _free = slot->next;
+        } else if (_initialized < SlotCount) {
+            slot = &_slots[_initialized++];
+        } else {
+            ++_exhausted;
+            return NULL;
+        }
+
+        if (++_used > _peak) {
+            _peak = _used;
+        }
+        return slot;
+    }
+
+    /**
+     * Release a slot allocated by this pool.
+     */
+    void deallocate(void* ptr) {
+        Slot* slot = static_cast<Slot*>(ptr);
+        slot->next = _free;
+        _free = slot;
+        --_used;
+    }
+
+    /**
+     * Return true if ptr is a slot of this pool.
+     */
+    bool owns(const void* ptr) const {
+        const char* p = static_cast<const char*>(ptr);
+        const char* begin = reinterpret_cast<const char*>(_slots);
+        return p >= begin && p < begin + sizeof(_slots);
+    }
+
+    /**
+     * Return the size of a slot.
+     */
+    static std::size_t slotSize() {
+        return sizeof(Slot);
+    }
+
+    /**
+     * Return the number of slots in the pool.
+     */
+    static std::size_t slotCount() {
+        return SlotCount;
+    }
+
+    /**
+     * Return the number of slots in use.
+     */
+    std::size_t used() const {
+        return _used;
+    }
+
+    /**
+     * Return the greatest number of slots used at once.
+     */
+    std::size_t peak() const {
+        return _peak;
+    }
+
+    /**
+     * Return the number of allocations which failed because the pool was full.
+     */
+    uint32_t exhausted() const {
+        return _exhausted;
+    }
+
+    /**
+     * Set the peak of occupancy to the current occupancy and clear the
+     * allocations failed.
+     */
+    void resetStatistics() {
+        _peak = _used;
+        _exhausted = 0;
+    }
+
+private:
+    SlabPool(const SlabPool&);
+    SlabPool& operator=(const SlabPool&);
+
+    union Slot {
+        Slot* next;
+        long long alignLong;
+        double alignDouble;
+        char storage[SlotSize];
+    };
+
+    Slot _slots[SlotCount];
+    Slot* _free;
+    std::size_t _initialized;
+    std::size_t _used;
+    std::size_t _peak;
+    uint32_t _exhausted;
+};
+
+} // namespace util
+
+#endif /* BLE_CLIAPP_UTIL_SLABPOOL_H */